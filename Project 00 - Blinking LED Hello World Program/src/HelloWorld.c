@@ -1,19 +1,36 @@
+#include "gpio.h"
+#include "led_pattern.h"
+#include "power.h"
+#include "scheduler.h"
+
+#include <avr/interrupt.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include <stdint.h>
-#include <util/delay.h>
 
-const uint16_t DELAY_TIME = 1000;
+#define LED B, 5
+
+/* On for a second, off for a second. */
+static const LedPatternStep_t HEARTBEAT_PATTERN[] PROGMEM = {
+  { GPIO_MASK (LED), 1000 },
+  { 0, 1000 },
+};
 
 int
 main (void)
 {
-  DDRB = DDRB | (1 << DDB5);
+  GPIO_MAKE_OUTPUT (LED);
+
+  sched_init ();
+  if (led_pattern_init () != 0)
+    return -1;
+
+  const LedPlayerId_t led
+      = led_pattern_add_player (&GPIO_OUT (LED), GPIO_MASK (LED), 0);
+  led_pattern_play (led, HEARTBEAT_PATTERN,
+                    LED_PATTERN_LENGTH (HEARTBEAT_PATTERN), true);
+  sei ();
 
-  while (1)
-    {
-      PORTB |= (1 << PORTB5);
-      _delay_ms (DELAY_TIME);
-      PORTB &= ~(1 << PORTB5);
-      _delay_ms (DELAY_TIME);
-    }
+  pwr_init ();
+  sched_run ();
 }
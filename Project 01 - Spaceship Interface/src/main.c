@@ -1,70 +1,87 @@
+#include "gpio.h"
+#include "input.h"
+#include "led_pattern.h"
+#include "power.h"
+#include "scheduler.h"
+
+#include <avr/interrupt.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include <stdint.h>
-#include <util/delay.h>
 
-void main_loop (void);
+#define FLASH_PERIOD_MS (250)
+#define TASK_DEADLINE_MS (5)
+
+#define SWITCH D, 2
+#define GREEN_LED D, 3
+#define FIRST_RED_LED D, 4
+#define SECOND_RED_LED D, 5
+#define ALL_LEDS GPIO_GROUP_MASK3 (GREEN_LED, FIRST_RED_LED, SECOND_RED_LED)
+
+/* Alternates the two red LEDs, with the green LED off. */
+static const LedPatternStep_t ALERT_PATTERN[] PROGMEM = {
+  { GPIO_MASK (SECOND_RED_LED), (FLASH_PERIOD_MS) },
+  { GPIO_MASK (FIRST_RED_LED), (FLASH_PERIOD_MS) },
+};
+
 void setup (void);
-void flash_red_LEDs (void);
+void handle_switch_events (void);
+
+static LedPlayerId_t leds = -1;
 
 int
 main (void)
 {
   setup ();
-  main_loop ();
 
-  return 0;
+  sched_init ();
+  const TaskId_t listener
+      = sched_add_task (handle_switch_events, 0, 0, TASK_DEADLINE_MS);
+  if (listener < 0 || input_init (listener) != 0 || led_pattern_init () != 0)
+    return -1;
+
+  /* Green while idle. */
+  leds = led_pattern_add_player (&GPIO_OUT (GREEN_LED), (ALL_LEDS),
+                                 GPIO_MASK (GREEN_LED));
+
+  /* The switch pulls PD2 (INT0) high against an external pull-down. */
+  if (input_add_button (INP_PORT_D, GPIO_BIT (SWITCH), false) < 0)
+    return -1;
+  sei ();
+
+  pwr_init ();
+  sched_run ();
 }
 
 /*
  *  Configures Port D as follows:
- *    * DDD2 (PORTD2) as input for switch
  *    * DDD3 (PORTD3) as output for green LED
  *    * DDD4 (PORTD4) as output for first red LED
  *    * DDD5 (PORTD5) as output for second red LED
+ *  The switch input on PD2 is configured by `input_add_button`.
  */
 void
 setup (void)
 {
-  /* initial value is 0 so this is probably unnecessary, but just to be safe */
-  DDRD &= ~(1 << DDD2);
-
-  DDRD |= (1 << DDD3);
-  DDRD |= (1 << DDD4);
-  DDRD |= (1 << DDD5);
+  gpio_write_group (&GPIO_DDR (GREEN_LED), (ALL_LEDS), (ALL_LEDS));
 }
 
+/*
+ *  Starts the red LED alert when the switch is pressed, and switches back to
+ *  the green LED as soon as it is released. Runs when the input module has
+ *  queued events.
+ */
 void
-main_loop (void)
+handle_switch_events (void)
 {
-  while (1)
+  InputEvent_t event;
+
+  while (input_get_event (&event))
     {
-      uint8_t switch_state = PIND & (1 << PIND2);
-      if (switch_state == (1 << PIND2))
-        {
-          flash_red_LEDs ();
-        }
-      else
-        {
-          PORTD |= (1 << PORTD3);
-          PORTD &= ~(1 << PORTD4);
-          PORTD &= ~(1 << PORTD5);
-        }
+      if (event.type == INPUT_PRESS)
+        led_pattern_play (leds, ALERT_PATTERN,
+                          LED_PATTERN_LENGTH (ALERT_PATTERN), true);
+      else if (event.type == INPUT_RELEASE)
+        led_pattern_stop (leds);
     }
 }
-
-void
-flash_red_LEDs (void)
-{
-  const uint8_t DELAY_TIME = 250;
-
-  PORTD &= ~(1 << PORTD3);
-  PORTD &= ~(1 << PORTD4);
-  PORTD |= (1 << PORTD5);
-
-  _delay_ms (DELAY_TIME);
-
-  PORTD |= (1 << PORTD4);
-  PORTD &= ~(1 << PORTD5);
-
-  _delay_ms (DELAY_TIME);
-}
@@ -0,0 +1,73 @@
+/*
+ *  Incremental baseline estimator.
+ *  Tracks the resting level of a sensor in raw ADC counts, one sample at a
+ *  time, so that a usable baseline is available from the first sample and
+ *  keeps following slow drift (e.g. room temperature) afterwards. The first
+ *  `BASELINE_WARMUP_SAMPLES` are averaged with a running mean, after which
+ *  the estimate becomes an exponential moving average which ignores samples
+ *  too far from it to be drift.
+ *
+ *  Everything is fixed point: the estimate holds `BASELINE_FRACTION_BITS` of
+ *  fraction so that the slow average doesn't stall on integer truncation.
+ */
+#ifndef _BASELINE_H_
+#define _BASELINE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BASELINE_FRACTION_BITS (10)
+
+/* Samples averaged evenly before switching to the moving average. */
+#define BASELINE_WARMUP_SAMPLES (8)
+
+/*
+ *  The moving average weights each sample by 1/2^BASELINE_EMA_SHIFT, a time
+ *  constant of ~128 samples (about two minutes at one sample per second).
+ */
+#define BASELINE_EMA_SHIFT (7)
+
+/*
+ *  Samples further than this from the estimate are treated as outliers (a
+ *  hand on the sensor) and left out. If that many arrive in a row, the
+ *  resting level has really moved and the estimator warms up again.
+ */
+#define BASELINE_OUTLIER_COUNTS (4)
+#define BASELINE_MAX_CONSECUTIVE_OUTLIERS (300)
+
+typedef struct BaselineEstimator_s
+{
+  uint32_t estimate;    // Counts << BASELINE_FRACTION_BITS
+  uint8_t sample_count; // Samples in the running mean, while warming up
+  uint16_t outliers;    // Consecutive rejected samples
+} BaselineEstimator_t;
+
+/*
+ *  Empties the estimator; the next sample becomes the baseline.
+ *  @param  be  the estimator to reset
+ */
+void baseline_reset (BaselineEstimator_t *be);
+
+/*
+ *  Folds one sample into the estimate.
+ *  @param  be      the estimator to update
+ *  @param  sample  the raw ADC reading
+ *  @return true if the sample was used, false if it was rejected as an
+ *          outlier.
+ */
+bool baseline_update (BaselineEstimator_t *be, uint16_t sample);
+
+/*
+ *  @param  be  the estimator to read
+ *  @return the baseline in ADC counts, rounded to nearest; 0 if no samples
+ *          have been taken.
+ */
+uint16_t baseline_value (const BaselineEstimator_t *be);
+
+/*
+ *  @param  be  the estimator to check
+ *  @return true once the warm-up average is complete.
+ */
+bool baseline_is_settled (const BaselineEstimator_t *be);
+
+#endif /* _BASELINE_H_ */
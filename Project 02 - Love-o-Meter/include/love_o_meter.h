@@ -1,9 +1,70 @@
 #ifndef _LOVE_O_METER_H_
 #define _LOVE_O_METER_H_
 
+#include "adc.h"
+#include "watchdog.h"
+
+#include <stddef.h>
 #include <stdint.h>
 
+/* Samples held in RAM between UART flushes in the logging mode. */
+#define LOG_BATCH_SIZE (16)
+
+/* Enough for any line `love_o_meter_format_report` writes. */
+#define LOVE_O_METER_REPORT_SIZE (160)
+
+/*
+ *  Configures the sensor input and LED outputs, and schedules
+ *  `love_o_meter_loop`. The LEDs respond from the first sample, while the
+ *  baseline temperature converges in the background.
+ */
 uint8_t init_love_o_meter (void);
+
+/*
+ *  Takes, reports and displays one temperature sample, and folds it into the
+ *  baseline. Runs as a task.
+ */
 void love_o_meter_loop (void);
 
+/*
+ *  Formats the line `love_o_meter_loop` prints for each sample: the time,
+ *  the reading, its voltage and temperature in Celsius and Fahrenheit, and
+ *  the baseline temperature.
+ *  @param  buffer           where the line is written, NUL-terminated
+ *  @param  size             the buffer's size; see `LOVE_O_METER_REPORT_SIZE`
+ *  @param  sample           the sample to report
+ *  @param  baseline_counts  the baseline, in ADC counts
+ *  @return the line's length, as `snprintf`.
+ */
+int love_o_meter_format_report (char *buffer, size_t size,
+                                const ADCSample_t *sample,
+                                uint16_t baseline_counts);
+
+/*
+ *  Sets up the low-duty logging mode: the sensor input, the ADC (left shut
+ *  down between samples) and the watchdog, which paces the samples. The
+ *  LEDs are left off.
+ *  @param  period  time between samples, `WDOG_1S` to `WDOG_8S`
+ *  @return 0 on success, -1 on failure.
+ */
+int8_t init_love_o_meter_logger (WatchdogPeriod_t period);
+
+/*
+ *  Sets up the threshold alarm mode. The sensor is watched by the analog
+ *  comparator against a reference voltage on AIN0 (PD6), with the ADC off.
+ *  When the sensor crosses the reference, one ADC reading quantifies the
+ *  temperature, which is reported, and the bargraph is lit while the sensor
+ *  is above the reference. Runs under the scheduler.
+ *  @return 0 on success, -1 on failure.
+ */
+int8_t init_love_o_meter_alarm (void);
+
+/*
+ *  Logs forever: sleeps in power-down until the watchdog fires, takes one
+ *  sample, and prints the samples over UART in batches of
+ *  `LOG_BATCH_SIZE`. The scheduler must not be running, as its tick would
+ *  keep the CPU out of power-down.
+ */
+void love_o_meter_log (void) __attribute__ ((noreturn));
+
 #endif /* _LOVE_O_METER_H_ */
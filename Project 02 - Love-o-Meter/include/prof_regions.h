@@ -0,0 +1,16 @@
+/* The Love-o-Meter's profiler regions; see: profiler.h. */
+#ifndef _PROF_REGIONS_H_
+#define _PROF_REGIONS_H_
+
+/*
+ *  Timer/Counter1 is free here, so regions are timed to the cycle. Holding
+ *  it keeps sleep to idle mode in profiling builds.
+ */
+#define PROF_CLOCK_TIMER1
+
+#define PROF_REGIONS(X)                                                       \
+  X (PROF_LOVE_SAMPLE, "love_sample")                                         \
+  X (PROF_LOVE_FORMAT, "love_format")                                         \
+  X (PROF_LOVE_REPORT, "love_report")
+
+#endif /* _PROF_REGIONS_H_ */
@@ -0,0 +1,60 @@
+#include "baseline.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void
+baseline_reset (BaselineEstimator_t *be)
+{
+  be->estimate = 0;
+  be->sample_count = 0;
+  be->outliers = 0;
+}
+
+bool
+baseline_update (BaselineEstimator_t *be, uint16_t sample)
+{
+  const int32_t scaled = (int32_t)sample << (BASELINE_FRACTION_BITS);
+  const int32_t error = scaled - (int32_t)be->estimate;
+
+  /*
+   *  Running mean: m_n = m_(n-1) + (x_n - m_(n-1)) / n. The first sample
+   *  lands on the estimate exactly.
+   */
+  if (!baseline_is_settled (be))
+    {
+      be->sample_count++;
+      be->estimate = (int32_t)be->estimate + error / be->sample_count;
+      return true;
+    }
+
+  const int32_t limit = (int32_t)(BASELINE_OUTLIER_COUNTS)
+                        << (BASELINE_FRACTION_BITS);
+  if (error > limit || error < -limit)
+    {
+      if (++be->outliers >= (BASELINE_MAX_CONSECUTIVE_OUTLIERS))
+        {
+          baseline_reset (be);
+          return baseline_update (be, sample);
+        }
+      return false;
+    }
+
+  be->outliers = 0;
+  /* Division rather than a shift, so negative errors round towards 0 too. */
+  be->estimate = (int32_t)be->estimate + error / (1L << (BASELINE_EMA_SHIFT));
+  return true;
+}
+
+uint16_t
+baseline_value (const BaselineEstimator_t *be)
+{
+  return (be->estimate + (1UL << ((BASELINE_FRACTION_BITS) - 1)))
+         >> (BASELINE_FRACTION_BITS);
+}
+
+bool
+baseline_is_settled (const BaselineEstimator_t *be)
+{
+  return be->sample_count >= (BASELINE_WARMUP_SAMPLES);
+}
@@ -1,42 +1,113 @@
 #include "love_o_meter.h"
 #include "adc.h"
+#include "analog_comparator.h"
+#include "baseline.h"
+#include "gpio.h"
+#include "latency.h"
+#include "led_pattern.h"
+#include "power.h"
+#include "profiler.h"
+#include "scheduler.h"
 #include "uart_hal.h"
+#include "watchdog.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <util/delay.h>
 
-#define PORT_C_DATA_DIRECTION_REGISTER (DDRC)
-#define PORT_C0_DATA_DIRECTION_BIT (DDC0)
+#define TEMPERATURE_SENSOR_PIN C, 0
 
-#define PORT_D_DATA_REGISTER (PORTD)
-#define PORT_D2 (PORTD2)
-#define PORT_D3 (PORTD3)
-#define PORT_D4 (PORTD4)
-#define PORT_D_DATA_DIRECTION_REGISTER (DDRD)
-#define PORT_D2_DATA_DIRECTION_BIT (DDD2)
-#define PORT_D3_DATA_DIRECTION_BIT (DDD3)
-#define PORT_D4_DATA_DIRECTION_BIT (DDD4)
+#define DIGITAL_INPUT_DISABLE_REGISTER_0 (DIDR0)
+#define ADC0_DIGITAL_INPUT_DISABLE_BIT (ADC0D)
+
+#define ANALOG_COMPARATOR_CTRL_STATUS_REGISTER (ACSR)
+#define ANALOG_COMPARATOR_DISABLE_BIT (ACD)
+
+#define FIRST_LED D, 2
+#define SECOND_LED D, 3
+#define THIRD_LED D, 4
+#define BARGRAPH_LEDS GPIO_GROUP_MASK3 (FIRST_LED, SECOND_LED, THIRD_LED)
+
+/*
+ *  The TMP36 gives 10 mV/C, and one count is 5000/1024 mV, so a level is
+ *  2 C, ~4 counts (rounded). A level is only dropped once the reading falls
+ *  `BARGRAPH_HYSTERESIS_COUNTS` below the threshold that raised it.
+ */
+#define CELSIUS_TO_COUNTS(c) (((c)*10L * 1024 + 2500) / 5000)
+#define BARGRAPH_LEVEL_STEP_C (2)
+#define BARGRAPH_HYSTERESIS_COUNTS (1)
+
+#define SAMPLE_PERIOD_MS (1000)
+/* Generous, as each run blocks on ~100 bytes of UART output at 9600 baud. */
+#define SAMPLE_DEADLINE_MS (100)
+#define POWER_REPORT_PERIOD_MS (60000)
+/* How often the task latency histograms are reported (LATENCY=1 builds). */
+#define LATENCY_REPORT_PERIOD_MS (60000)
+
+/* Comparator events are ignored for this long after one is handled. */
+#define ALARM_HOLDOFF_MS (500)
 
-static float calculate_baseline_temp (void);
 static float sensor_value_to_voltage (uint16_t val);
 static float voltage_to_temperature (float v);
 static float celsius_to_fahrenheit (float c);
-static void configure_output_leds_w_temperature (float temp);
+static void update_bargraph_thresholds (uint16_t baseline_counts);
+static void update_bargraph (uint16_t sensor_val);
+static void report_power (void);
+static void flush_log (void);
+static void handle_alarm (void);
+static void rearm_alarm (void);
+#if LAT_ENABLED
+static int8_t track_latency (TaskId_t task);
+#endif /* LAT_ENABLED */
+
+/* One held step per bargraph level; 0-3 LEDs lit. */
+static const LedPatternStep_t BARGRAPH_LEVELS[] PROGMEM = {
+  { 0, LED_PATTERN_HOLD },
+  { GPIO_MASK (FIRST_LED), LED_PATTERN_HOLD },
+  { GPIO_GROUP_MASK (FIRST_LED, SECOND_LED), LED_PATTERN_HOLD },
+  { (BARGRAPH_LEDS), LED_PATTERN_HOLD },
+};
+
+#define BARGRAPH_LEVEL_COUNT (LED_PATTERN_LENGTH (BARGRAPH_LEVELS))
 
-static float baseline_temp = 20.0;
+/* bargraph_thresholds[i] is the reading that raises level i to i + 1. */
+static uint16_t bargraph_thresholds[(BARGRAPH_LEVEL_COUNT)-1] = { 0 };
+static uint16_t bargraph_baseline = 0;
+static uint8_t bargraph_level = 0;
+
+static BaselineEstimator_t baseline = { 0 };
+static LedPlayerId_t bargraph = -1;
+
+static uint16_t log_samples[(LOG_BATCH_SIZE)] = { 0 };
+static uint8_t log_count = 0;
+static uint32_t log_first_timeout = 0; // Watchdog timeout of log_samples[0]
+static uint16_t log_period_ms = 0;
+
+static TaskId_t alarm_task = -1;
+static TaskId_t rearm_task = -1;
+static bool alarm_raised = false;
+
+#if LAT_ENABLED
+/* Of the sampling task (`love_o_meter_loop` or `handle_alarm`). */
+static LatencyHistogram_t task_jitter = { 0 };
+static LatencyHistogram_t task_run_time = { 0 };
+#endif /* LAT_ENABLED */
 
 uint8_t
 init_love_o_meter (void)
 {
   /* Configure Port C0 as an input. */
-  PORT_C_DATA_DIRECTION_REGISTER &= ~(1 << (PORT_C0_DATA_DIRECTION_BIT));
+  GPIO_MAKE_INPUT (TEMPERATURE_SENSOR_PIN);
 
   /* Configure Port D2-4 as output. */
-  PORT_D_DATA_DIRECTION_REGISTER |= (1 << PORT_D2_DATA_DIRECTION_BIT);
-  PORT_D_DATA_DIRECTION_REGISTER |= (1 << PORT_D3_DATA_DIRECTION_BIT);
-  PORT_D_DATA_DIRECTION_REGISTER |= (1 << PORT_D4_DATA_DIRECTION_BIT);
+  gpio_write_group (&GPIO_DDR (FIRST_LED), (BARGRAPH_LEDS), (BARGRAPH_LEDS));
+
+  if (led_pattern_init () != 0)
+    return -1;
+  bargraph
+      = led_pattern_add_player (&GPIO_OUT (FIRST_LED), (BARGRAPH_LEDS), 0);
 
   if (adc_init (ADCRV_AVCC, true, ADCC_ADC0, ADCP_BY_128) != ADC_INIT_SUCCESS)
     {
@@ -44,63 +115,201 @@ init_love_o_meter (void)
       return -1;
     }
 
-  uart_send_string ("Calculating baseline temperature...\r\n");
-  baseline_temp = calculate_baseline_temp ();
-  uart_send_string ("Baseline temperature calculation complete.\r\n");
+  if (sched_add_task (report_power, POWER_REPORT_PERIOD_MS,
+                      POWER_REPORT_PERIOD_MS, SCHED_NO_DEADLINE)
+      < 0)
+    return -1;
+
+  baseline_reset (&baseline);
+  const TaskId_t loop_task = sched_add_task (love_o_meter_loop, 0,
+                                             SAMPLE_PERIOD_MS,
+                                             SAMPLE_DEADLINE_MS);
+  if (loop_task < 0)
+    return -1;
+#if LAT_ENABLED
+  if (track_latency (loop_task) != 0)
+    return -1;
+#endif /* LAT_ENABLED */
 
   return 0;
 }
 
-float
-calculate_baseline_temp (void)
+int8_t
+init_love_o_meter_logger (WatchdogPeriod_t period)
 {
-  float total = 0.0;
+  if (period < WDOG_1S || period > WDOG_8S)
+    return -1;
 
-  for (uint8_t i = 0; i < 5; i++)
+  GPIO_MAKE_INPUT (TEMPERATURE_SENSOR_PIN);
+
+  /* Drive the (unused) LED pins low rather than leaving them floating. */
+  gpio_write_group (&GPIO_OUT (FIRST_LED), (BARGRAPH_LEDS), 0);
+  gpio_write_group (&GPIO_DDR (FIRST_LED), (BARGRAPH_LEDS), (BARGRAPH_LEDS));
+
+  /*
+   *  The digital input buffer on an analog pin only wastes current, as does
+   *  the (unused) analog comparator. see: pg. 41, ATmega328P data sheet.
+   */
+  DIGITAL_INPUT_DISABLE_REGISTER_0 |= (1 << (ADC0_DIGITAL_INPUT_DISABLE_BIT));
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_DISABLE_BIT));
+
+  if (adc_init (ADCRV_AVCC, true, ADCC_ADC0, ADCP_BY_128) != ADC_INIT_SUCCESS)
     {
-      const uint16_t sensor_val = adc_start (true);
-      const float voltage = sensor_value_to_voltage (sensor_val);
-      const float temp = voltage_to_temperature (voltage);
-      total += temp;
-      _delay_ms (1000);
+      uart_send_string ("Fatal Error: Error initializing ADC.\r\n");
+      return -1;
     }
+  adc_shutdown ();
 
-  return total / 5;
+  log_period_ms = wdog_period_ms (period);
+  return wdog_start (period);
 }
 
 void
-love_o_meter_loop (void)
+love_o_meter_log (void)
 {
-  char output_buffer[256] = { 0 };
-
-  sprintf (output_buffer, "Baseline temperature (C): %d\r\n",
-           (int)baseline_temp);
-  uart_send_string (output_buffer);
+  uint32_t last_timeout = wdog_timeouts ();
 
+  uart_shutdown ();
   while (true)
     {
+      pwr_sleep ();
+
+      /* Only the watchdog should be able to wake us, but be sure. */
+      const uint32_t timeout = wdog_timeouts ();
+      if (timeout == last_timeout)
+        continue;
+
+      pwr_add_residency (PWR_MODE_POWER_DOWN,
+                         (timeout - last_timeout) * log_period_ms);
+      last_timeout = timeout;
+
+      /* The ADC is powered up just for this conversion. */
       const uint16_t sensor_val = adc_start (true);
-      const float voltage = sensor_value_to_voltage (sensor_val);
-      const float temperature = voltage_to_temperature (voltage);
-      const float temp_f = celsius_to_fahrenheit (temperature);
-
-      /*
-       *  avr libc sprintf can't handle floats, apparently.
-       *  @see:
-       * https://onlinedocs.microchip.com/oxy/GUID-317042D4-BCCE-4065-BB05-AC4312DBC2C4-en-US-2/GUID-BC6AFB6B-C75E-4B3B-9185-1F369F36AE22.html#GUID-BC6AFB6B-C75E-4B3B-9185-1F369F36AE22
-       */
-      sprintf (output_buffer,
-               "Sensor value: %d Voltage: 0.%02d Temperature (C): %d "
-               "Temperature (F): %d\r\n",
-               sensor_val, (int)(voltage * 100), (int)temperature,
-               (int)temp_f);
-      uart_send_string (output_buffer);
+      adc_shutdown ();
+
+      if (log_count == 0)
+        log_first_timeout = timeout;
+      log_samples[log_count++] = sensor_val;
 
-      configure_output_leds_w_temperature (temperature);
-      _delay_ms (1000);
+      if (log_count == (LOG_BATCH_SIZE))
+        {
+          uart_wake ();
+          flush_log ();
+          uart_shutdown ();
+          log_count = 0;
+        }
     }
 }
 
+int8_t
+init_love_o_meter_alarm (void)
+{
+  GPIO_MAKE_INPUT (TEMPERATURE_SENSOR_PIN);
+  DIGITAL_INPUT_DISABLE_REGISTER_0 |= (1 << (ADC0_DIGITAL_INPUT_DISABLE_BIT));
+
+  gpio_write_group (&GPIO_DDR (FIRST_LED), (BARGRAPH_LEDS), (BARGRAPH_LEDS));
+  if (led_pattern_init () != 0)
+    return -1;
+  bargraph
+      = led_pattern_add_player (&GPIO_OUT (FIRST_LED), (BARGRAPH_LEDS), 0);
+
+  if (adc_init (ADCRV_AVCC, true, ADCC_ADC0, ADCP_BY_128) != ADC_INIT_SUCCESS)
+    {
+      uart_send_string ("Fatal Error: Error initializing ADC.\r\n");
+      return -1;
+    }
+  adc_shutdown ();
+
+  /*
+   *  The alarm task runs once straight away to report the starting state,
+   *  then on comparator events. Each run reschedules the re-arm task.
+   */
+  alarm_task = sched_add_task (handle_alarm, 0, 0, SAMPLE_DEADLINE_MS);
+  rearm_task = sched_add_task (rearm_alarm, ALARM_HOLDOFF_MS, 0,
+                               SCHED_NO_DEADLINE);
+  if (alarm_task < 0 || rearm_task < 0)
+    return -1;
+#if LAT_ENABLED
+  /* Here, jitter is how long a comparator event waits for its task. */
+  if (track_latency (alarm_task) != 0)
+    return -1;
+#endif /* LAT_ENABLED */
+
+  /* The sensor (on ADC0) against the reference on AIN0. */
+  if (acmp_init (ACMP_POS_AIN0, ACMP_NEG_ADC0, ACMP_ON_TOGGLE, alarm_task)
+      != 0)
+    return -1;
+
+  if (sched_add_task (report_power, POWER_REPORT_PERIOD_MS,
+                      POWER_REPORT_PERIOD_MS, SCHED_NO_DEADLINE)
+      < 0)
+    return -1;
+
+  return 0;
+}
+
+void
+love_o_meter_loop (void)
+{
+  char output_buffer[(LOVE_O_METER_REPORT_SIZE)] = { 0 };
+
+  ADCSample_t sample;
+  PROF_BEGIN (PROF_LOVE_SAMPLE);
+  adc_sample (true, &sample);
+  adc_shutdown ();
+  PROF_END (PROF_LOVE_SAMPLE);
+
+  /*
+   *  The baseline starts at the first sample and converges in the background;
+   *  warm readings are rejected as outliers rather than dragging it up.
+   */
+  const uint16_t sensor_val = sample.value;
+  const bool was_settled = baseline_is_settled (&baseline);
+  baseline_update (&baseline, sensor_val);
+  const uint16_t baseline_counts = baseline_value (&baseline);
+  if (!was_settled && baseline_is_settled (&baseline))
+    uart_send_string ("Baseline temperature calculation complete.\r\n");
+
+  if (baseline_counts != bargraph_baseline)
+    update_bargraph_thresholds (baseline_counts);
+  update_bargraph (sensor_val);
+
+  PROF_BEGIN (PROF_LOVE_FORMAT);
+  love_o_meter_format_report (output_buffer, sizeof (output_buffer), &sample,
+                              baseline_counts);
+  PROF_END (PROF_LOVE_FORMAT);
+
+  PROF_BEGIN (PROF_LOVE_REPORT);
+  uart_send_string (output_buffer);
+  PROF_END (PROF_LOVE_REPORT);
+}
+
+int
+love_o_meter_format_report (char *buffer, size_t size,
+                            const ADCSample_t *sample,
+                            uint16_t baseline_counts)
+{
+  const float voltage = sensor_value_to_voltage (sample->value);
+  const float temperature = voltage_to_temperature (voltage);
+  const float temp_f = celsius_to_fahrenheit (temperature);
+  const float baseline_temp
+      = voltage_to_temperature (sensor_value_to_voltage (baseline_counts));
+
+  /*
+   *  avr libc sprintf can't handle floats, apparently.
+   *  @see:
+   * https://onlinedocs.microchip.com/oxy/GUID-317042D4-BCCE-4065-BB05-AC4312DBC2C4-en-US-2/GUID-BC6AFB6B-C75E-4B3B-9185-1F369F36AE22.html#GUID-BC6AFB6B-C75E-4B3B-9185-1F369F36AE22
+   */
+  return snprintf (
+      buffer, size,
+      "Time (us): %lu Sensor value: %d Voltage: 0.%02d "
+      "Temperature (C): %d Temperature (F): %d Baseline (C): %d\r\n",
+      (unsigned long)sample->timestamp_us, sample->value,
+      (int)(voltage * 100), (int)temperature, (int)temp_f,
+      (int)baseline_temp);
+}
+
 float
 sensor_value_to_voltage (uint16_t val)
 {
@@ -119,31 +328,149 @@ celsius_to_fahrenheit (float c)
   return (c * 1.8) + 32;
 }
 
+/* Moves the level thresholds with the baseline, in ADC counts. */
 void
-configure_output_leds_w_temperature (float temp)
+update_bargraph_thresholds (uint16_t baseline_counts)
 {
-  if (temp < baseline_temp + 2)
-    {
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D2));
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D3));
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D4));
-    }
-  else if (temp < baseline_temp + 4)
-    {
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D2));
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D3));
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D4));
-    }
-  else if (temp < baseline_temp + 6)
+  for (uint8_t i = 0; i < (BARGRAPH_LEVEL_COUNT)-1; i++)
+    bargraph_thresholds[i]
+        = baseline_counts
+          + CELSIUS_TO_COUNTS ((BARGRAPH_LEVEL_STEP_C) * (i + 1));
+  bargraph_baseline = baseline_counts;
+}
+
+/*
+ *  Steps the bargraph level towards the reading, with hysteresis on the way
+ *  down. The LEDs are only written (in one masked store, by the pattern
+ *  player) when the level changes.
+ */
+void
+update_bargraph (uint16_t sensor_val)
+{
+  uint8_t level = bargraph_level;
+
+  while (level < (BARGRAPH_LEVEL_COUNT)-1
+         && sensor_val >= bargraph_thresholds[level])
+    level++;
+  while (level > 0
+         && sensor_val + (BARGRAPH_HYSTERESIS_COUNTS)
+                < bargraph_thresholds[level - 1])
+    level--;
+
+  if (level == bargraph_level && led_pattern_is_playing (bargraph))
+    return;
+
+  bargraph_level = level;
+  led_pattern_play (bargraph, &BARGRAPH_LEVELS[level], 1, false);
+}
+
+/* Prints the time spent in each power mode and the estimated draw. */
+void
+report_power (void)
+{
+  static const char *const MODE_NAMES[(PWR_MODE_COUNT)] = {
+    [PWR_MODE_ACTIVE] = "active",
+    [PWR_MODE_IDLE] = "idle",
+    [PWR_MODE_ADC_NOISE_REDUCTION] = "ADC noise reduction",
+    [PWR_MODE_POWER_SAVE] = "power-save",
+    [PWR_MODE_POWER_DOWN] = "power-down",
+  };
+
+  char output_buffer[96] = { 0 };
+  PowerModeStats_t stats[(PWR_MODE_COUNT)];
+
+  pwr_get_stats (stats);
+  for (uint8_t m = 0; m < (PWR_MODE_COUNT); m++)
     {
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D2));
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D3));
-      PORT_D_DATA_REGISTER &= ~(1 << (PORT_D4));
+      sprintf (output_buffer, "Power mode %s: %lu ms, ~%u uA\r\n",
+               MODE_NAMES[m], (unsigned long)stats[m].residency_ms,
+               stats[m].typical_ua);
+      uart_send_string (output_buffer);
     }
-  else
+
+  sprintf (output_buffer, "Estimated average MCU current: %lu uA\r\n",
+           (unsigned long)pwr_estimated_average_ua ());
+  uart_send_string (output_buffer);
+}
+
+/* Prints the batched samples, timed by the (approximate) watchdog period. */
+void
+flush_log (void)
+{
+  char output_buffer[64] = { 0 };
+
+  for (uint8_t i = 0; i < log_count; i++)
     {
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D2));
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D3));
-      PORT_D_DATA_REGISTER |= (1 << (PORT_D4));
+      const uint32_t time_s
+          = ((log_first_timeout + i) * log_period_ms) / 1000;
+      const float voltage = sensor_value_to_voltage (log_samples[i]);
+
+      sprintf (output_buffer, "Time (s): ~%lu Temperature (C): %d\r\n",
+               (unsigned long)time_s, (int)voltage_to_temperature (voltage));
+      uart_send_string (output_buffer);
     }
 }
+
+/*
+ *  Runs on each comparator event. The comparator is held off while the ADC
+ *  quantifies the reading (and for `ALARM_HOLDOFF_MS` after, so a noisy
+ *  crossing can't flood the CPU with interrupts).
+ */
+void
+handle_alarm (void)
+{
+  char output_buffer[96] = { 0 };
+
+  acmp_suspend ();
+
+  ADCSample_t sample;
+  adc_sample (true, &sample);
+  adc_shutdown ();
+
+  /* The comparator output is high while the reference is above the sensor. */
+  alarm_raised = !acmp_output ();
+  const float temperature
+      = voltage_to_temperature (sensor_value_to_voltage (sample.value));
+
+  sprintf (output_buffer,
+           "Alarm %s - event (us): %lu sample (us): %lu "
+           "Temperature (C): %d\r\n",
+           alarm_raised ? "raised" : "clear",
+           (unsigned long)acmp_last_event_us (),
+           (unsigned long)sample.timestamp_us, (int)temperature);
+  uart_send_string (output_buffer);
+
+  const uint8_t level = alarm_raised ? (BARGRAPH_LEVEL_COUNT)-1 : 0;
+  led_pattern_play (bargraph, &BARGRAPH_LEVELS[level], 1, false);
+  sched_reschedule (rearm_task, ALARM_HOLDOFF_MS);
+}
+
+/*
+ *  Re-enables the comparator after the hold-off, catching up on a crossing
+ *  which happened while it was disabled.
+ */
+void
+rearm_alarm (void)
+{
+  acmp_resume ();
+
+  if (alarm_raised == !acmp_output ())
+    return;
+
+  sched_reschedule (alarm_task, 0);
+}
+
+#if LAT_ENABLED
+/* Times each run of `task`, and reports it periodically. */
+int8_t
+track_latency (TaskId_t task)
+{
+  if (sched_track_latency (task, &task_jitter, &task_run_time) != 0
+      || lat_add_to_report (&task_jitter, "sample_jitter") != 0
+      || lat_add_to_report (&task_run_time, "sample_run") != 0
+      || lat_start_reports (LATENCY_REPORT_PERIOD_MS, uart_send_string) != 0)
+    return -1;
+
+  return 0;
+}
+#endif /* LAT_ENABLED */
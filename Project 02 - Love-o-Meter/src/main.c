@@ -1,23 +1,58 @@
 #include "love_o_meter.h"
+#include "memory_monitor.h"
+#include "metrics.h"
+#include "power.h"
+#include "profiler.h"
+#include "scheduler.h"
 #include "uart_hal.h"
+#include "watchdog.h"
 
 #include <avr/interrupt.h>
 
 #define BAUD_RATE (9600)
+#define COMMAND_POLL_PERIOD_MS (100)
+#define LOG_PERIOD (WDOG_8S)
 
 static void init_serial_connection (void);
+#ifndef LOVE_O_METER_LOGGER
+static int8_t init_commands (void);
+static void poll_commands (void);
+#endif /* LOVE_O_METER_LOGGER */
 
 int
 main (void)
 {
+#ifdef LOVE_O_METER_LOGGER
+  init_serial_connection ();
+  if (init_love_o_meter_logger (LOG_PERIOD) != 0)
+    return -1;
+
+  uart_send_string ("Love-o-meter logger initialized.\r\n");
+  pwr_init ();
+  love_o_meter_log ();
+#elif defined(LOVE_O_METER_ALARM)
+  sched_init ();
+  init_serial_connection ();
+  if (init_love_o_meter_alarm () != 0)
+    return -1;
+  if (init_commands () != 0)
+    return -1;
+
+  uart_send_string ("Love-o-meter alarm initialized.\r\n");
+  pwr_init ();
+  sched_run ();
+#else
+  sched_init ();
   init_serial_connection ();
   if (init_love_o_meter () != 0)
     return -1;
+  if (init_commands () != 0)
+    return -1;
 
   uart_send_string ("Love-o-meter initialized.\r\n");
-  love_o_meter_loop ();
-
-  return 0;
+  pwr_init ();
+  sched_run ();
+#endif /* LOVE_O_METER_LOGGER */
 }
 
 void
@@ -29,3 +64,51 @@ init_serial_connection (void)
   sei ();
   uart_send_string (START_MSG);
 }
+
+#ifndef LOVE_O_METER_LOGGER
+/* Starts the profiler, if built in, and polls for serial commands. */
+int8_t
+init_commands (void)
+{
+#if PROF_ENABLED
+  prof_init ();
+#endif /* PROF_ENABLED */
+
+  if (sched_add_task (poll_commands, 0, COMMAND_POLL_PERIOD_MS,
+                      SCHED_NO_DEADLINE)
+      < 0)
+    return -1;
+
+  return 0;
+}
+
+/*
+ *  Send 'm' for a metrics dump, 'c' to clear them (see: metrics.h), 's' for
+ *  memory use (see: memory_monitor.h), and with PROFILE=1, 'p' for a profile
+ *  dump, 'r' to reset it (see: profiler.h).
+ *
+ *  Also checks the stack canary; once the stack has overrun .bss, a clean
+ *  restart beats running on corrupted state.
+ */
+void
+poll_commands (void)
+{
+  if (!mem_canary_intact ())
+    {
+      uart_send_string ("Fatal Error: Stack overflow.\r\n");
+      wdog_reset_system ();
+    }
+
+  while (uart_read_count () > 0)
+    {
+      const uint8_t cmd = uart_read ();
+
+      if (metrics_command (cmd, uart_send_string) == 0
+          || mem_command (cmd, uart_send_string) == 0)
+        continue;
+#if PROF_ENABLED
+      prof_command (cmd, uart_send_string);
+#endif /* PROF_ENABLED */
+    }
+}
+#endif /* LOVE_O_METER_LOGGER */
@@ -17,4 +17,10 @@ typedef struct AnalogInput_s
 uint8_t ai_create_analog_input (AnalogInput_t *ai, ADCChannel_t channel);
 int8_t ai_analog_read (AnalogInput_t *ai, uint16_t *output);
 
+/* Changes `ai`'s ADC clock divisor, from its next reading on. */
+void ai_set_prescaler (AnalogInput_t *ai, ADCPrescalerDivisor_t prescaler);
+
+/* As `ai_analog_read`, but timestamps the reading (see: `adc_sample`). */
+int8_t ai_analog_read_sample (AnalogInput_t *ai, ADCSample_t *output);
+
 #endif /* _ANALOG_INPUT_H_ */
@@ -1,9 +1,74 @@
 #ifndef _COLOR_MIXING_LAMP_H_
 #define _COLOR_MIXING_LAMP_H_
 
+#include "adc.h"
+
+#include <stddef.h>
 #include <stdint.h>
 
+/* Bump whenever `LampConfig_t` changes, so stale settings aren't loaded. */
+#define LAMP_CONFIG_VERSION (1)
+
+/* The settings kept in EEPROM (see: config_store.h). */
+typedef struct LampConfig_s
+{
+  uint16_t sample_period_ms;
+  uint8_t adc_prescaler; // An ADCPrescalerDivisor_t
+  uint32_t baud_rate;
+} LampConfig_t;
+
+/*
+ *  Loads the sample period, ADC clock and baud rate from EEPROM, or the
+ *  defaults (see: config_store.h). Call after `sched_init`, and before
+ *  `uart_init` and `l_init_lamp`, which use them. Without it, the lamp runs
+ *  on the defaults. Stored settings outside the ranges `l_command` allows
+ *  are clamped into them; an unknown baud rate becomes the default.
+ *  @return 0 or 1 as `cfg_load`, -1 on error.
+ */
+int8_t l_load_config (void);
+
+/* @return the baud rate to start the UART at. */
+uint32_t l_baud_rate (void);
+
+/* Sets up the sensors and LED outputs, and schedules `l_lamp_loop`. */
 int8_t l_init_lamp (void);
-int8_t l_lamp_loop (void);
+
+/* Samples one colour channel per run. Runs as a task. */
+void l_lamp_loop (void);
+
+/*
+ *  Reads all three colour channels back to back, then reports and drives the
+ *  LEDs just as the task `l_lamp_loop` schedules after its third run: the
+ *  whole sensor-to-PWM path in one call, without the scheduler. For
+ *  replaying recorded readings (see: replay/).
+ *  @return 0 on success, -1 if an input couldn't be read.
+ */
+int8_t l_lamp_step (void);
+
+/*
+ *  Formats the report printed after each colour cycle: the raw readings,
+ *  when they were taken, and the LED duty cycles they map to, a line each.
+ *  @param  buffer  where the report is written, NUL-terminated
+ *  @param  size    the buffer's size; 256 bytes always fits
+ *  @param  red     the red sample, and so on
+ *  @return the report's length, as `snprintf`.
+ */
+int l_format_report (char *buffer, size_t size, const ADCSample_t *red,
+                     const ADCSample_t *green, const ADCSample_t *blue);
+
+/*
+ *  Handles a one-byte serial command which changes a setting, then prints
+ *
+ *    lamp,<sample period ms>,<ADC clock divisor>,<baud rate>
+ *
+ *  '+'/'-' halve/double the sample period, '<'/'>' halve/double the ADC
+ *  clock divisor, 'b' steps through the baud rates (taking effect at the
+ *  next reset), 'd' restores the defaults and 'l' only prints. Changes are
+ *  saved to EEPROM a few seconds later. Anything else is ignored.
+ *  @param  cmd    the byte received
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ *  @return 0 if `cmd` was a lamp command, -1 if not.
+ */
+int8_t l_command (uint8_t cmd, void (*write) (const char *));
 
 #endif /* _COLOR_MIXING_LAMP_H_ */
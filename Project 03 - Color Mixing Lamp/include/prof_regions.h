@@ -0,0 +1,13 @@
+/* The lamp's profiler regions; see: profiler.h. */
+#ifndef _PROF_REGIONS_H_
+#define _PROF_REGIONS_H_
+
+/* Green and blue are PWM on OC1A/OC1B. */
+#define PROF_TIMER1_IN_USE
+
+#define PROF_REGIONS(X)                                                       \
+  X (PROF_LAMP_SAMPLE, "lamp_sample")                                         \
+  X (PROF_LAMP_REPORT, "lamp_report")                                         \
+  X (PROF_LAMP_PWM, "lamp_pwm")
+
+#endif /* _PROF_REGIONS_H_ */
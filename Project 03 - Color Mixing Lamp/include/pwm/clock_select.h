@@ -4,7 +4,12 @@
 #include "pwm/pwm_timer_cntr.h"
 #include "pwm/timer_cntr_selection.h"
 
+#include <avr/io.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+/* CSn2:0 occupy the same bits in TCCR0B, TCCR1B and TCCR2B. */
+#define CLK_SELECT_MASK (0x7 << (CS00))
 
 /** see: Table 14-9, pg. 87, ATmega328P data sheet. */
 typedef enum ClockSelect_e
@@ -22,7 +27,20 @@ typedef enum ClockSelect_e
 } ClockSelect_t;
 
 bool clk_is_valid_clock_select (TimerCounterSelect_t t, ClockSelect_t c);
-void clk_set_clk_select_mode_bits (PWMTimerCntr_t *pmw, TimerCounterSelect_t t,
-                                   ClockSelect_t c);
+
+/*
+ *  Replaces the clock select bits of `reg` in a single masked write. Invalid
+ *  selections leave the register untouched.
+ *  @param  reg  TCCRnB, or an image of it
+ *  @return 0 on success, -1 if `c` is not available on timer `t`.
+ */
+int8_t clk_set_clk_select_bits (volatile uint8_t *reg, TimerCounterSelect_t t,
+                                ClockSelect_t c);
+/*
+ *  As `clk_set_clk_select_bits`, on an image of the control registers.
+ *  @return 0 on success, -1 if `c` is not available on timer `t`.
+ */
+int8_t clk_set_clk_select_mode_bits (PWMTimerCntr_t *pmw,
+                                     TimerCounterSelect_t t, ClockSelect_t c);
 
 #endif /* _CLOCK_SELECT_H_ */
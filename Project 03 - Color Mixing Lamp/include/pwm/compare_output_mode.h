@@ -16,7 +16,9 @@ typedef enum CompareOutputMode_e
 } CompareOutputMode_t;
 
 bool cmp_is_valid_cmp_output_mode (CompareOutputMode_t c);
-void cmp_set_cmp_output_mode (PWMTimerCntr_t *pmw, WaveformGenerationMode_t w,
-                              CompareOutputMode_t c);
+/* @return 0 on success, -1 if `c` is invalid, leaving `pmw` untouched. */
+int8_t cmp_set_cmp_output_mode (PWMTimerCntr_t *pmw,
+                                WaveformGenerationMode_t w,
+                                CompareOutputMode_t c);
 
 #endif /* _COMPARE_OUTPUT_MODE_H_ */
@@ -0,0 +1,91 @@
+/*
+ *  Timer/Counter1 input capture.
+ *  Timestamps edges on ICP1 (PB0/D08) in hardware and measures the period,
+ *  frequency and duty cycle of pulse trains such as frequency-output sensors
+ *  and tachometers. The counter runs free and its overflows are counted, so
+ *  timestamps are 32 bits of timer ticks.
+ *
+ *  The capture interrupt only queues the timestamp; `icp_measure` does the
+ *  arithmetic. The queue holds `ICP_QUEUE_SIZE` edges, so with the consumer
+ *  running every millisecond, edge rates up to ~30 kHz are kept up with.
+ *  Takes Timer/Counter1 over entirely, so it cannot be combined with PWM on
+ *  OC1A/OC1B or with `pwm_stream`.
+ */
+#ifndef _INPUT_CAPTURE_H_
+#define _INPUT_CAPTURE_H_
+
+#include "pwm/clock_select.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef ICP_QUEUE_SIZE
+#define ICP_QUEUE_SIZE (32) // Must be a power of two
+#endif /* ICP_QUEUE_SIZE */
+
+/* Capture flags. */
+#define ICP_RISING_EDGE (1 << 0) // Else a falling edge
+#define ICP_AFTER_GAP (1 << 1)   // Captures were dropped just before this one
+
+typedef enum ICPEdges_e
+{
+  ICP_RISING_EDGES,
+  ICP_FALLING_EDGES,
+  ICP_BOTH_EDGES, // Needed for the duty cycle
+} ICPEdges_t;
+
+typedef struct ICPCapture_s
+{
+  uint32_t ticks; // Timer ticks since `icp_start`
+  uint8_t flags;
+} ICPCapture_t;
+
+typedef struct ICPMeasurement_s
+{
+  uint32_t period_ticks;  // Between the last two period edges
+  uint32_t high_ticks;    // Rising to falling edge; 0 unless both are captured
+  uint32_t frequency_hz;  // Rounded to nearest
+  uint16_t duty_permille; // 0 unless both edges are captured
+} ICPMeasurement_t;
+
+/*
+ *  Starts the counter and the capture interrupt, dropping anything queued.
+ *  @param  prescale        the tick rate; 1, 8, 64, 256 or 1024. Smaller
+ *                          prescalers resolve higher frequencies, larger ones
+ *                          reach lower frequencies before the count wraps.
+ *  @param  edges           which edges to capture. Period edges are rising
+ *                          ones when capturing both.
+ *  @param  noise_canceler  if true, an edge only counts once the input has
+ *                          been stable for four CPU cycles
+ *  @return 0 on success, -1 if `prescale` is not supported.
+ */
+int8_t icp_start (ClockSelect_t prescale, ICPEdges_t edges,
+                  bool noise_canceler);
+
+/*
+ *  Stops the counter and drops this module's claim on it, letting the power
+ *  manager shut it down once nothing else holds it. Does nothing if not
+ *  started.
+ */
+void icp_stop (void);
+
+/* @return the timer tick rate, or 0 if not started. */
+uint32_t icp_tick_hz (void);
+
+/*
+ *  Takes the oldest queued capture.
+ *  @return true if a capture was copied to `capture`, false if none remain.
+ */
+bool icp_read_capture (ICPCapture_t *capture);
+
+/*
+ *  Consumes the queued captures, updating `m` with the most recent complete
+ *  period. Gaps left by dropped captures aren't measured across.
+ *  @return 0 if `m` was updated, -1 if no new period was complete.
+ */
+int8_t icp_measure (ICPMeasurement_t *m);
+
+/* @return the number of edges lost to a full queue. */
+uint16_t icp_dropped_captures (void);
+
+#endif /* _INPUT_CAPTURE_H_ */
@@ -0,0 +1,105 @@
+/*
+ *  Compile-time PWM configuration.
+ *  `PWM_DEFINE_CONFIG` checks a timer/waveform/compare output/prescaler
+ *  selection at build time and folds it into the constant control register
+ *  bytes that `pwm_apply_config` (see: pwm_hal.h) writes. Use it instead of
+ *  `pwm_init` whenever the settings are constants: invalid combinations fail
+ *  to compile, and none of the runtime validation (or its error strings)
+ *  ends up in the image.
+ */
+#ifndef _PWM_CONFIG_H_
+#define _PWM_CONFIG_H_
+
+#include "pwm/clock_select.h"
+#include "pwm/compare_output_mode.h"
+#include "pwm/timer_cntr_selection.h"
+#include "pwm/waveform_generation_mode.h"
+
+#include <avr/io.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct PWMConfig_s
+{
+  TimerCounterSelect_t timer;
+  uint8_t control_register_a; // TCCRnA: COMnA/COMnB and WGMn1:0
+  uint8_t control_register_b; // TCCRnB: WGMn2 and CSn2:0
+  uint8_t force_output_cmp;   // FOCnA/FOCnB (TCCR1C on Timer/Counter1)
+} PWMConfig_t;
+
+/*
+ *  The control register layouts of Timer/Counter0, 1 and 2 agree for every
+ *  bit used here, so the Timer/Counter0 bit names stand in for all three.
+ */
+#define PWM_CFG_TIMER_IS_VALID(t) ((unsigned)(t) <= (TCNTRS_2))
+
+#define PWM_CFG_WGM_IS_VALID(w)                                               \
+  ((w) == WGM_MODE_0 || (w) == WGM_MODE_1 || (w) == WGM_MODE_2               \
+   || (w) == WGM_MODE_3 || (w) == WGM_MODE_5 || (w) == WGM_MODE_7)
+
+#define PWM_CFG_WGM_IS_PWM(w) ((w) != WGM_MODE_0 && (w) != WGM_MODE_2)
+
+#define PWM_CFG_COM_IS_VALID(c) ((unsigned)(c) <= (COM_SET))
+
+/** see: Table 14-9, pg. 87 and Table 17-9, pg. 131, ATmega328P data sheet. */
+#define PWM_CFG_CLK_IS_VALID(t, c)                                            \
+  ((t) == TCNTRS_2 ? (unsigned)(c) <= (CS_PRESCALE_BY_1024)                  \
+                   : ((unsigned)(c) <= (CS_EXT_RISING_EDGE)                  \
+                      && (c) != CS_PRESCALE_BY_32                            \
+                      && (c) != CS_PRESCALE_BY_128))
+
+/* Timer/Counter2's encoding matches `ClockSelect_t`; 0 and 1 skip 32/128. */
+#define PWM_CFG_CLK_BITS(t, c)                                                \
+  ((t) == TCNTRS_2                ? (c)                                       \
+   : (c) <= CS_PRESCALE_BY_8      ? (c)                                       \
+   : (c) == CS_PRESCALE_BY_64     ? 0x3                                       \
+   : (c) == CS_PRESCALE_BY_256    ? 0x4                                       \
+   : (c) == CS_PRESCALE_BY_1024   ? 0x5                                       \
+                                  : (c) - 2)
+
+/* In the PWM modes, the toggle setting is only defined for channel A. */
+#define PWM_CFG_COM_BITS(w, c)                                                \
+  (((c) << (COM0A0))                                                          \
+   | ((PWM_CFG_WGM_IS_PWM (w) && (c) == COM_TOGGLE) ? 0 : (c) << (COM0B0)))
+
+#define PWM_CFG_WGM_A_BITS(w) (((w)&0x3) << (WGM00))
+#define PWM_CFG_WGM_B_BITS(w) ((((w) >> 2) & 0x1) << (WGM02))
+
+#define PWM_CFG_FOC_BITS(foc_a, foc_b)                                        \
+  (((foc_a) ? (1 << (FOC0A)) : 0) | ((foc_b) ? (1 << (FOC0B)) : 0))
+
+#define PWM_STATIC_ASSERT(cond, msg) __extension__ _Static_assert (cond, msg)
+
+/*
+ *  Rejects invalid combinations at build time. FOCnA/B should only be set in
+ *  a non-PWM mode (see: pg. 86, ATmega328P data sheet).
+ */
+#define PWM_CONFIG_ASSERT(t, w, c, foc_a, foc_b, s)                           \
+  PWM_STATIC_ASSERT (PWM_CFG_TIMER_IS_VALID (t), "invalid timer selection");  \
+  PWM_STATIC_ASSERT (PWM_CFG_WGM_IS_VALID (w),                                \
+                     "invalid waveform generation mode");                     \
+  PWM_STATIC_ASSERT (PWM_CFG_COM_IS_VALID (c),                                \
+                     "invalid compare output mode");                          \
+  PWM_STATIC_ASSERT (!PWM_CFG_WGM_IS_PWM (w) || !((foc_a) || (foc_b)),        \
+                     "force output compare requires a non-PWM mode");         \
+  PWM_STATIC_ASSERT (PWM_CFG_CLK_IS_VALID (t, s),                             \
+                     "invalid clock prescaler for the selected timer")
+
+/* Initializer for a `PWMConfig_t`. Prefer `PWM_DEFINE_CONFIG`. */
+#define PWM_CONFIG(t, w, c, foc_a, foc_b, s)                                  \
+  {                                                                           \
+    .timer = (t),                                                             \
+    .control_register_a = PWM_CFG_COM_BITS (w, c) | PWM_CFG_WGM_A_BITS (w),   \
+    .control_register_b = PWM_CFG_WGM_B_BITS (w) | PWM_CFG_CLK_BITS (t, s),   \
+    .force_output_cmp = PWM_CFG_FOC_BITS (foc_a, foc_b),                      \
+  }
+
+/*
+ *  Defines `name` as a build-time validated `static const PWMConfig_t`.
+ *  Takes the same arguments as `pwm_init`.
+ */
+#define PWM_DEFINE_CONFIG(name, t, w, c, foc_a, foc_b, s)                     \
+  PWM_CONFIG_ASSERT (t, w, c, foc_a, foc_b, s);                               \
+  static const PWMConfig_t name = PWM_CONFIG (t, w, c, foc_a, foc_b, s)
+
+#endif /* _PWM_CONFIG_H_ */
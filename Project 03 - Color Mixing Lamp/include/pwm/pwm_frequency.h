@@ -0,0 +1,105 @@
+/*
+ *  PWM frequency/resolution solver.
+ *  Picks the waveform generation mode, prescaler and TOP value that get a
+ *  timer closest to a target PWM frequency with at least the requested
+ *  resolution, rather than making callers work it out from the data sheet.
+ */
+#ifndef _PWM_FREQUENCY_H_
+#define _PWM_FREQUENCY_H_
+
+#include "pwm/clock_select.h"
+#include "pwm/pwm_config.h"
+#include "pwm/timer_cntr_selection.h"
+#include "pwm/waveform_generation_mode.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ *  Lowest PWM frequency accepted for driving LEDs. Below a couple hundred Hz
+ *  the modulation becomes visible as flicker, especially on moving objects or
+ *  in peripheral vision.
+ */
+#define PWM_FLICKER_FUSION_HZ (200UL)
+
+/* The fastest any timer can toggle: fast PWM with a TOP of 1, unprescaled. */
+#define PWM_MAX_HZ ((F_CPU) / 2)
+
+typedef struct PWMSolution_s
+{
+  WaveformGenerationMode_t waveform_gen_mode;
+  ClockSelect_t prescale;
+  uint16_t top;              // Counter TOP value
+  bool top_is_ocra;          // TOP is held in OCRnA, which costs channel A
+  uint32_t frequency_hz;     // Achieved PWM frequency
+  uint8_t resolution_bits;   // floor(log2(TOP + 1))
+} PWMSolution_t;
+
+/*
+ *  Searches prescaler x TOP x waveform generation mode for the configuration
+ *  closest to `target_hz` that has at least `min_bits` of resolution.
+ *  @param  timer           the timer/counter to solve for
+ *  @param  target_hz       the desired PWM frequency
+ *  @param  min_bits        the minimum acceptable resolution
+ *  @param  need_channel_a  if true, modes which use OCRnA as TOP are skipped
+ *  @param  solution        where the selected configuration is stored
+ *  @return 0 on success, -1 if nothing meets the constraints, the result
+ *          would flicker (see `PWM_FLICKER_FUSION_HZ`) or `target_hz` is
+ *          above `PWM_MAX_HZ`.
+ */
+int8_t pwm_solve_for (TimerCounterSelect_t timer, uint32_t target_hz,
+                      uint8_t min_bits, bool need_channel_a,
+                      PWMSolution_t *solution);
+
+/*
+ *  Solves as `pwm_solve_for` does, then configures the timer for
+ *  non-inverting PWM with the result (setting OCRnA as TOP where needed).
+ *  @return 0 on success, -1 if no acceptable configuration exists.
+ */
+int8_t pwm_configure_for (TimerCounterSelect_t timer, uint32_t target_hz,
+                          uint8_t min_bits, bool need_channel_a,
+                          PWMSolution_t *solution);
+
+/*
+ *  Compile-time variant, restricted to fast PWM with a fixed 8-bit TOP (both
+ *  channels usable). Selects the largest prescaler that still reaches
+ *  `target_hz`, i.e. the frequency closest to the target from above.
+ */
+#define PWM_CLK_DIVISOR(c)                                                    \
+  ((c) == CS_NO_PRESCALING     ? 1UL                                          \
+   : (c) == CS_PRESCALE_BY_8   ? 8UL                                          \
+   : (c) == CS_PRESCALE_BY_32  ? 32UL                                         \
+   : (c) == CS_PRESCALE_BY_64  ? 64UL                                         \
+   : (c) == CS_PRESCALE_BY_128 ? 128UL                                        \
+   : (c) == CS_PRESCALE_BY_256 ? 256UL                                        \
+                               : 1024UL)
+
+#define PWM_FAST_8BIT_HZ(c) ((F_CPU) / (PWM_CLK_DIVISOR (c) * 256UL))
+
+/* Timer/Counter1's 8-bit fast PWM is WGM1 0b0101 (Table 15-5, pg. 109). */
+#define PWM_FAST_8BIT_WGM(t) ((t) == TCNTRS_1 ? WGM_MODE_5 : WGM_MODE_3)
+
+#define PWM_FAST_8BIT_CLK_FOR(t, hz)                                          \
+  (PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_1024) >= (hz) ? CS_PRESCALE_BY_1024     \
+   : PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_256) >= (hz) ? CS_PRESCALE_BY_256     \
+   : ((t) == TCNTRS_2 && PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_128) >= (hz))     \
+       ? CS_PRESCALE_BY_128                                                   \
+   : PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_64) >= (hz) ? CS_PRESCALE_BY_64       \
+   : ((t) == TCNTRS_2 && PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_32) >= (hz))      \
+       ? CS_PRESCALE_BY_32                                                    \
+   : PWM_FAST_8BIT_HZ (CS_PRESCALE_BY_8) >= (hz) ? CS_PRESCALE_BY_8         \
+                                                  : CS_NO_PRESCALING)
+
+/*
+ *  Defines `name` as a `static const PWMConfig_t` for non-inverting 8-bit
+ *  fast PWM near `hz`, failing the build if the result would flicker.
+ */
+#define PWM_DEFINE_FAST_PWM_CONFIG(name, t, hz)                               \
+  PWM_STATIC_ASSERT (                                                         \
+      PWM_FAST_8BIT_HZ (PWM_FAST_8BIT_CLK_FOR (t, hz))                        \
+          >= (PWM_FLICKER_FUSION_HZ),                                         \
+      "PWM frequency is below the flicker fusion threshold");                 \
+  PWM_DEFINE_CONFIG (name, t, PWM_FAST_8BIT_WGM (t), COM_CLEAR, false,       \
+                     false, PWM_FAST_8BIT_CLK_FOR (t, hz))
+
+#endif /* _PWM_FREQUENCY_H_ */
@@ -3,15 +3,65 @@
 
 #include "pwm/clock_select.h"
 #include "pwm/compare_output_mode.h"
+#include "pwm/pwm_config.h"
 #include "pwm/timer_cntr_selection.h"
 #include "pwm/waveform_generation_mode.h"
 
 #include <stdbool.h>
 #include <stdint.h>
 
+/* Output compare channels; OCnA and OCnB. */
+typedef enum PWMChannel_e
+{
+  PWMC_A,
+  PWMC_B
+} PWMChannel_t;
+
+/*
+ *  Configures a timer/counter at runtime. Arguments are validated in every
+ *  build, with the errors reported over UART unless NDEBUG is defined;
+ *  configurations known at compile time should use `PWM_DEFINE_CONFIG` and
+ *  `pwm_apply_config`.
+ *  @return 0 on success, -1 if the arguments were rejected.
+ */
 int8_t pwm_init (TimerCounterSelect_t timer,
                  WaveformGenerationMode_t waveform_gen_mode,
                  CompareOutputMode_t cmp_output_mode, bool force_output_cmp_a,
                  bool force_output_cmp_b, ClockSelect_t prescale);
 
+/*
+ *  Writes a configuration from `PWM_DEFINE_CONFIG` to the timer's control
+ *  registers and powers the timer up. With nothing to validate, this is a
+ *  handful of stores.
+ *  @param  cfg  pointer to the configuration to apply
+ */
+void pwm_apply_config (const PWMConfig_t *cfg);
+
+/*
+ *  Changes a running timer's prescaler with a single masked write to TCCRnB,
+ *  leaving the waveform and compare output settings alone.
+ *  @return 0 on success, -1 if `prescale` is not available on `timer`.
+ */
+int8_t pwm_set_prescaler (TimerCounterSelect_t timer, ClockSelect_t prescale);
+
+/*
+ *  Sets a channel's output compare register, i.e. its duty cycle (or TOP, for
+ *  channel A in the modes which use OCRnA as TOP). Only Timer/Counter1 uses
+ *  more than the low 8 bits of `value`.
+ */
+void pwm_set_compare (TimerCounterSelect_t timer, PWMChannel_t channel,
+                      uint16_t value);
+
+/*
+ *  Registers the PWM code as a user of the timer with the power manager, once
+ *  per timer. Configuring a timer does this itself.
+ */
+void pwm_power_up (TimerCounterSelect_t timer);
+
+/*
+ *  Stops a timer's clock and drops the PWM code's claim on it, letting the
+ *  power manager shut it down. Reconfiguring the timer powers it back up.
+ */
+void pwm_power_down (TimerCounterSelect_t timer);
+
 #endif /* _PULSE_WIDTH_MODULATOR_HARDWARE_ABSTRACTION_LAYER_H_ */
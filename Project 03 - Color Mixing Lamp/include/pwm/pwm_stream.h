@@ -0,0 +1,68 @@
+/*
+ *  PWM DAC streaming.
+ *  Runs Timer/Counter1 as 8-bit fast PWM with no prescaling (a 62.5 kHz
+ *  carrier on OC1A/~D09) and updates the duty cycle from a sample buffer at a
+ *  fixed sample rate from the overflow interrupt. With an RC low-pass filter
+ *  on OC1A this gives an analog output for setpoints and tone alerts.
+ *
+ *  Buffers are double buffered: while one plays, the next can be queued, and
+ *  playback moves on to it without a gap. Takes Timer/Counter1 over entirely,
+ *  so it cannot be combined with other users of OC1A/OC1B.
+ */
+#ifndef _PWM_STREAM_H_
+#define _PWM_STREAM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PWM_STREAM_CARRIER_HZ ((F_CPU) / 256UL)
+
+/* Sample flags for `pwm_stream_queue`. */
+#define PWM_STREAM_IN_FLASH (1 << 0) // `samples` points into program memory
+#define PWM_STREAM_LOOP (1 << 1)     // repeat until another buffer is queued
+#define PWM_STREAM_END (1 << 2)      // the last; running out isn't an underrun
+
+/*
+ *  Starts the carrier at mid-scale. The sample clock (the overflow
+ *  interrupt) only runs while a buffer is queued.
+ *  @param  sample_rate_hz  between `PWM_STREAM_CARRIER_HZ` / 255 and
+ *                          `PWM_STREAM_CARRIER_HZ`
+ *  @return the achieved sample rate (the carrier divided by a whole number),
+ *          or 0 if `sample_rate_hz` is out of range.
+ */
+uint16_t pwm_stream_init (uint16_t sample_rate_hz);
+
+/*
+ *  Queues 8-bit unsigned samples for playback. The buffer must stay valid
+ *  until it has been played (see `pwm_stream_can_queue`).
+ *  @param  samples  the samples to play
+ *  @param  length   number of samples; must be non-zero
+ *  @param  flags    any of `PWM_STREAM_IN_FLASH`, `PWM_STREAM_LOOP` and
+ *                   `PWM_STREAM_END`
+ *  @return 0 on success, -1 if both buffers are already queued or the
+ *          stream isn't started.
+ */
+int8_t pwm_stream_queue (const uint8_t *samples, uint16_t length,
+                         uint8_t flags);
+
+/* @return true if a buffer can be queued without failing. */
+bool pwm_stream_can_queue (void);
+
+/* @return true once every queued buffer has been played. */
+bool pwm_stream_is_idle (void);
+
+/*
+ *  @return the number of times playback ran out of buffers other than after
+ *          one flagged `PWM_STREAM_END`, i.e. the next was queued too late.
+ */
+uint16_t pwm_stream_underruns (void);
+
+/*
+ *  Stops the sample clock and the carrier, drops queued buffers, leaves OC1A
+ *  an input (high impedance, so the filter output decays) and drops the
+ *  claim on Timer/Counter1, letting the power manager shut it down.
+ *  `pwm_stream_init` starts the stream again, at mid-scale.
+ */
+void pwm_stream_stop (void);
+
+#endif /* _PWM_STREAM_H_ */
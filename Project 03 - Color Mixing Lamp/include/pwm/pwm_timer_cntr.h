@@ -3,11 +3,25 @@
 
 #include <stdint.h>
 
-// TODO: look up the actual size of these registers
+/* Image of a timer/counter's (8-bit) control registers. */
 typedef struct PWMTimerCntr_s
 {
-  uint16_t control_register_a;
-  uint16_t control_register_b;
+  uint8_t control_register_a; // TCCRnA
+  uint8_t control_register_b; // TCCRnB, without the force output bits
+  uint8_t force_output_cmp;   // FOCnA/FOCnB
 } PWMTimerCntr_t;
 
+/*
+ *  Where a timer/counter's control bits live. One of these is kept in flash
+ *  per timer so that (re)configuring any timer is a fixed sequence of masked
+ *  register writes rather than a switch over the timer selection.
+ */
+typedef struct PWMTimerDesc_s
+{
+  volatile uint8_t *control_register_a;
+  volatile uint8_t *control_register_b;
+  volatile uint8_t *force_output_register; // TCCRnB, or TCCR1C for TC1
+  uint8_t power_peripheral; // `PowerPeripheral_t`
+} PWMTimerDesc_t;
+
 #endif /* _PWM_TIMER_CNTR_H_ */
@@ -1,4 +1,5 @@
 #include "analog_input.h"
+#include "metrics.h"
 
 #include <stdlib.h>
 
@@ -6,6 +7,12 @@ static const ADCRefVoltage_t REF_VOLTAGE = ADCRV_AVCC;
 static const bool RIGHT_ADJUSTED = false;
 static const ADCPrescalerDivisor_t PRESCALER = ADCP_BY_128;
 
+/* The input the ADC is configured for. */
+static AnalogInput_t *last_input = NULL;
+
+static ADCInitResult_t configure_adc (const AnalogInput_t *ai);
+static int8_t select_input (AnalogInput_t *ai);
+
 uint8_t
 ai_create_analog_input (AnalogInput_t *ai, ADCChannel_t channel)
 {
@@ -14,25 +21,58 @@ ai_create_analog_input (AnalogInput_t *ai, ADCChannel_t channel)
   ai->channel = channel;
   ai->prescaler = PRESCALER;
 
-  return adc_init_with_analog_input (ai);
+  return configure_adc (ai);
 }
 
 int8_t
 ai_analog_read (AnalogInput_t *ai, uint16_t *output)
 {
-  static AnalogInput_t *last_input = NULL;
+  if (output == NULL || select_input (ai) != 0)
+    return -1;
+
+  *output = adc_start (ai->right_adjusted);
+  return 0;
+}
+
+void
+ai_set_prescaler (AnalogInput_t *ai, ADCPrescalerDivisor_t prescaler)
+{
+  ai->prescaler = prescaler;
+  if (ai == last_input)
+    last_input = NULL;
+}
+
+int8_t
+ai_analog_read_sample (AnalogInput_t *ai, ADCSample_t *output)
+{
+  if (output == NULL || select_input (ai) != 0)
+    return -1;
+
+  adc_sample (ai->right_adjusted, output);
+  return 0;
+}
 
-  if (ai == NULL || output == NULL)
+/* Reconfigures the ADC for `ai`, unless it was the last input read. */
+int8_t
+select_input (AnalogInput_t *ai)
+{
+  if (ai == NULL)
     return -1;
 
   if (ai != last_input)
     {
-      if (adc_init_with_analog_input (ai) != ADC_INIT_SUCCESS)
+      if (configure_adc (ai) != ADC_INIT_SUCCESS)
         return -1;
+      METRIC_INC (adc_channel_switches);
     }
 
   last_input = ai;
-
-  *output = adc_start (ai->right_adjusted);
   return 0;
 }
+
+ADCInitResult_t
+configure_adc (const AnalogInput_t *ai)
+{
+  return adc_init (ai->ref_voltage, ai->right_adjusted, ai->channel,
+                   ai->prescaler);
+}
@@ -1,28 +1,64 @@
 #include "lamp.h"
 #include "analog_input.h"
+#include "config_store.h"
+#include "gpio.h"
+#include "latency.h"
+#include "profiler.h"
+#include "pwm/pwm_frequency.h"
 #include "pwm/pwm_hal.h"
+#include "scheduler.h"
 #include "uart_hal.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <util/delay.h>
 
 #define STR_BUFFER_SIZE (256)
 
-#define PORT_B_DATA_DIRECTION_REGISTER (DDRB)
+/* The 10-bit readings scaled to the LEDs' 8-bit duty cycles. */
+#define TO_DUTY_CYCLE(val) ((uint8_t)((val) >> 2))
 
-#define RED_LED_PIN_DATA_DIR_BIT (DDB3)
-#define GREEN_LED_PIN_DATA_DIR_BIT (DDB1)
-#define BLUE_LED_PIN_DATA_DIR_BIT (DDB2)
+/* OC2A, OC1A and OC1B. */
+#define RED_LED_PIN B, 3
+#define GREEN_LED_PIN B, 1
+#define BLUE_LED_PIN B, 2
+#define LED_PINS GPIO_GROUP_MASK3 (RED_LED_PIN, GREEN_LED_PIN, BLUE_LED_PIN)
 
-#define PORT_C_DATA_DIRECTION_REGISTER (DDRC)
-
-#define RED_PHOTORESISTOR_DATA_DIR_BIT (DDC0)
-#define GREEN_PHOTORESISTOR_DATA_DIR_BIT (DDC1)
-#define BLUE_PHOTORESISTOR_DATA_DIR_BIT (DDC2)
+#define RED_PHOTORESISTOR_PIN C, 0
+#define GREEN_PHOTORESISTOR_PIN C, 1
+#define BLUE_PHOTORESISTOR_PIN C, 2
+#define PHOTORESISTOR_PINS                                                    \
+  GPIO_GROUP_MASK3 (RED_PHOTORESISTOR_PIN, GREEN_PHOTORESISTOR_PIN,           \
+                    BLUE_PHOTORESISTOR_PIN)
 
 #define READ_ANALOG_INPUT_DELAY_MS (5000)
+/* Fast enough for the readings' 8 bits; 128 gives the full 10. */
+#define MIN_ADC_PRESCALER (ADCP_BY_16)
+#define MAX_ADC_PRESCALER (ADCP_BY_128)
+#define DEFAULT_BAUD_RATE (9600)
+#define SAMPLE_DEADLINE_MS (10)
+/* Generous, as each run blocks on ~160 bytes of UART output at 9600 baud. */
+#define UPDATE_DEADLINE_MS (200)
+
+/* How often the loop latency histograms are reported (LATENCY=1 builds). */
+#define LATENCY_REPORT_PERIOD_MS (60000)
+
+/* Lowest LED PWM frequency wanted; well clear of the flicker threshold. */
+#define LED_PWM_FREQUENCY_HZ (400)
+
+/* A third of a report per sample at 9600 baud, with room to spare. */
+#define MIN_SAMPLE_PERIOD_MS (250)
+#define MAX_SAMPLE_PERIOD_MS (60000)
+
+#define SHOW_CONFIG_COMMAND ('l')
+#define FASTER_SAMPLES_COMMAND ('+')
+#define SLOWER_SAMPLES_COMMAND ('-')
+#define FASTER_ADC_COMMAND ('<')
+#define SLOWER_ADC_COMMAND ('>')
+#define NEXT_BAUD_RATE_COMMAND ('b')
+#define DEFAULTS_COMMAND ('d')
 
 AnalogInput_t red_photoresistor = { 0 };
 AnalogInput_t green_photoresistor = { 0 };
@@ -32,13 +68,64 @@ static const ADCChannel_t RED_PHOTORESISTOR_CHANNEL = ADCC_ADC0;
 static const ADCChannel_t GREEN_PHOTORESISTOR_CHANNEL = ADCC_ADC1;
 static const ADCChannel_t BLUE_PHOTORESISTOR_CHANNEL = ADCC_ADC2;
 
+enum
+{
+  RED,
+  GREEN,
+  BLUE,
+  SENSOR_COUNT
+};
+
+static AnalogInput_t *const SENSORS[(SENSOR_COUNT)] = {
+  [RED] = &red_photoresistor,
+  [GREEN] = &green_photoresistor,
+  [BLUE] = &blue_photoresistor,
+};
+
+/* The settings kept in EEPROM are a `LampConfig_t` (see: lamp.h). */
+#define LAMP_DEFAULTS                                                         \
+  { (READ_ANALOG_INPUT_DELAY_MS), (ADCP_BY_128), (DEFAULT_BAUD_RATE) }
+
+static const LampConfig_t DEFAULT_CONFIG PROGMEM = LAMP_DEFAULTS;
+/* The defaults until `l_load_config`, for builds which never call it. */
+static LampConfig_t config = LAMP_DEFAULTS;
+
+/* Rates 'b' steps through; UBRR0 errors are all within 2.1% at 16 MHz. */
+static const uint32_t BAUD_RATES[] PROGMEM = { 9600, 19200, 38400, 57600 };
+#define BAUD_RATE_COUNT (sizeof (BAUD_RATES) / sizeof (BAUD_RATES[0]))
+
+static ADCSample_t samples[(SENSOR_COUNT)] = { 0 };
+static TaskId_t sample_task = -1;
+static TaskId_t update_task = -1;
+
+#if LAT_ENABLED
+static LatencyHistogram_t sample_jitter = { 0 };
+static LatencyHistogram_t sample_run_time = { 0 };
+static LatencyHistogram_t update_jitter = { 0 };
+static LatencyHistogram_t update_run_time = { 0 };
+#endif /* LAT_ENABLED */
+
+static void update_lamp (void);
+static void finish_cycle (void);
+static void apply_config (void);
+static void show_config (void (*write) (const char *));
+static void clamp_config (void);
+static uint32_t next_baud_rate (uint32_t baud_rate);
+static bool is_baud_rate (uint32_t baud_rate);
+
+/*
+ *  Red is driven by OC2A, green and blue by OC1A and OC1B. Fixed-TOP fast PWM
+ *  keeps both channels of each timer available.
+ */
+PWM_DEFINE_FAST_PWM_CONFIG (RED_PWM_CONFIG, TCNTRS_2, LED_PWM_FREQUENCY_HZ);
+PWM_DEFINE_FAST_PWM_CONFIG (GREEN_BLUE_PWM_CONFIG, TCNTRS_1,
+                            LED_PWM_FREQUENCY_HZ);
+
 int8_t
 l_init_lamp (void)
 {
   // Configure the red, green, and blue photoresistors as input.
-  PORT_C_DATA_DIRECTION_REGISTER &= ~(1 << (RED_PHOTORESISTOR_DATA_DIR_BIT));
-  PORT_C_DATA_DIRECTION_REGISTER &= ~(1 << (GREEN_PHOTORESISTOR_DATA_DIR_BIT));
-  PORT_C_DATA_DIRECTION_REGISTER &= ~(1 << (BLUE_PHOTORESISTOR_DATA_DIR_BIT));
+  gpio_write_group (&GPIO_DDR (RED_PHOTORESISTOR_PIN), PHOTORESISTOR_PINS, 0);
 
   /* clang-format off */
   if (
@@ -52,58 +139,275 @@ l_init_lamp (void)
   }
   /* clang-format on */
 
-  pwm_init (TCNTRS_2, WGM_MODE_7, COM_CLEAR, false, false, CS_PRESCALE_BY_128);
+  pwm_apply_config (&RED_PWM_CONFIG);
+  pwm_apply_config (&GREEN_BLUE_PWM_CONFIG);
 
   /*
    *  Configure the red, green, and blue pins as output. The setup of the OC2x
    *  should be performed before setting the data direction register for the
    *  port pin to output.
    */
-  PORT_B_DATA_DIRECTION_REGISTER |= (1 << (RED_LED_PIN_DATA_DIR_BIT));
-  PORT_B_DATA_DIRECTION_REGISTER |= (1 << (GREEN_LED_PIN_DATA_DIR_BIT));
-  PORT_B_DATA_DIRECTION_REGISTER |= (1 << (BLUE_LED_PIN_DATA_DIR_BIT));
+  gpio_write_group (&GPIO_DDR (RED_LED_PIN), LED_PINS, LED_PINS);
+
+  sample_task = sched_add_task (l_lamp_loop, 0, config.sample_period_ms,
+                                SAMPLE_DEADLINE_MS);
+  if (sample_task < 0)
+    return -1;
+  apply_config ();
+
+#if LAT_ENABLED
+  /* The update task is added after the first cycle, and tracked then. */
+  if (sched_track_latency (sample_task, &sample_jitter, &sample_run_time) != 0
+      || lat_add_to_report (&sample_jitter, "sample_jitter") != 0
+      || lat_add_to_report (&sample_run_time, "sample_run") != 0
+      || lat_add_to_report (&update_jitter, "update_jitter") != 0
+      || lat_add_to_report (&update_run_time, "update_run") != 0
+      || lat_start_reports (LATENCY_REPORT_PERIOD_MS, uart_send_string) != 0)
+    return -1;
+#endif /* LAT_ENABLED */
 
   return 0;
 }
 
 int8_t
-l_lamp_loop (void)
+l_load_config (void)
 {
-  char buffer[(STR_BUFFER_SIZE)] = { 0 };
+  const int8_t status = cfg_load (&config, sizeof (config),
+                                  (LAMP_CONFIG_VERSION), &DEFAULT_CONFIG);
+
+  if (status == 0)
+    clamp_config ();
+  return status;
+}
+
+uint32_t
+l_baud_rate (void)
+{
+  return config.baud_rate;
+}
 
-  while (true)
+int8_t
+l_command (uint8_t cmd, void (*write) (const char *))
+{
+  switch (cmd)
     {
-      uint16_t red_sensor_val;
-      if (ai_analog_read (&red_photoresistor, &red_sensor_val) != 0)
-        goto error_cleanup;
+    case (SHOW_CONFIG_COMMAND):
+      show_config (write);
+      return 0;
+    case (FASTER_SAMPLES_COMMAND):
+      if (config.sample_period_ms / 2 < (MIN_SAMPLE_PERIOD_MS))
+        config.sample_period_ms = (MIN_SAMPLE_PERIOD_MS);
+      else
+        config.sample_period_ms /= 2;
+      break;
+    case (SLOWER_SAMPLES_COMMAND):
+      if (config.sample_period_ms > (MAX_SAMPLE_PERIOD_MS) / 2)
+        config.sample_period_ms = (MAX_SAMPLE_PERIOD_MS);
+      else
+        config.sample_period_ms *= 2;
+      break;
+    case (FASTER_ADC_COMMAND):
+      if (config.adc_prescaler > (MIN_ADC_PRESCALER))
+        config.adc_prescaler--;
+      break;
+    case (SLOWER_ADC_COMMAND):
+      if (config.adc_prescaler < (MAX_ADC_PRESCALER))
+        config.adc_prescaler++;
+      break;
+    case (NEXT_BAUD_RATE_COMMAND):
+      config.baud_rate = next_baud_rate (config.baud_rate);
+      break;
+    case (DEFAULTS_COMMAND):
+      cfg_restore_defaults ();
+      break;
+    default:
+      return -1;
+    }
 
-      _delay_ms ((READ_ANALOG_INPUT_DELAY_MS));
+  cfg_mark_dirty ();
+  apply_config ();
+  show_config (write);
+  return 0;
+}
 
-      uint16_t green_sensor_val;
-      if (ai_analog_read (&green_photoresistor, &green_sensor_val) != 0)
-        goto error_cleanup;
+/*
+ *  Reads the next photoresistor in red, green, blue order. After blue, the
+ *  report/LED update task is (re)scheduled, and red follows it.
+ */
+void
+l_lamp_loop (void)
+{
+  static uint8_t next_channel = 0;
 
-      _delay_ms ((READ_ANALOG_INPUT_DELAY_MS));
+  PROF_BEGIN (PROF_LAMP_SAMPLE);
+  const int8_t status
+      = ai_analog_read_sample (SENSORS[next_channel], &samples[next_channel]);
+  PROF_END (PROF_LAMP_SAMPLE);
 
-      uint16_t blue_sensor_val;
-      if (ai_analog_read (&blue_photoresistor, &blue_sensor_val) != 0)
-        goto error_cleanup;
+  if (status != 0)
+    {
+      uart_send_string ("Error reading from analog input!\r\n");
+      sched_remove_task (sample_task);
+      return;
+    }
 
-      sprintf (buffer, "Raw sensor values - red: %d green: %d blue: %d\r\n",
-               red_sensor_val, green_sensor_val, blue_sensor_val);
-      uart_send_string (buffer);
+  if (++next_channel < (SENSOR_COUNT))
+    return;
+  next_channel = 0;
+  adc_shutdown ();
 
-      const uint8_t red_value = (red_sensor_val >> 2);
-      const uint8_t green_value = (green_sensor_val >> 2);
-      const uint8_t blue_value = (blue_sensor_val >> 2);
+  if (update_task >= 0)
+    {
+      sched_reschedule (update_task, 0);
+      return;
+    }
 
-      sprintf (buffer, "Mapped sensor values - red: %d green: %d blue: %d\r\n",
-               red_value, green_value, blue_value);
-      uart_send_string (buffer);
+  update_task = sched_add_task (finish_cycle, 0, 0, UPDATE_DEADLINE_MS);
+#if LAT_ENABLED
+  if (update_task >= 0
+      && sched_track_latency (update_task, &update_jitter, &update_run_time)
+             != 0)
+    {
+      sched_remove_task (update_task);
+      update_task = -1;
+    }
+#endif /* LAT_ENABLED */
+  if (update_task < 0)
+    {
+      uart_send_string ("Error scheduling the lamp update!\r\n");
+      sched_remove_task (sample_task);
     }
+}
+
+int
+l_format_report (char *buffer, size_t size, const ADCSample_t *red,
+                 const ADCSample_t *green, const ADCSample_t *blue)
+{
+  return snprintf (buffer, size,
+                   "Raw sensor values - red: %d green: %d blue: %d\r\n"
+                   "Sample times (us) - red: %lu green: %lu blue: %lu\r\n"
+                   "Mapped sensor values - red: %d green: %d blue: %d\r\n",
+                   red->value, green->value, blue->value,
+                   (unsigned long)red->timestamp_us,
+                   (unsigned long)green->timestamp_us,
+                   (unsigned long)blue->timestamp_us,
+                   TO_DUTY_CYCLE (red->value), TO_DUTY_CYCLE (green->value),
+                   TO_DUTY_CYCLE (blue->value));
+}
+
+int8_t
+l_lamp_step (void)
+{
+  for (uint8_t c = 0; c < (SENSOR_COUNT); c++)
+    {
+      if (ai_analog_read_sample (SENSORS[c], &samples[c]) != 0)
+        return -1;
+    }
+  adc_shutdown ();
 
+  update_lamp ();
   return 0;
-error_cleanup:
-  uart_send_string ("Error reading from analog input!\r\n");
-  return -1;
+}
+
+/*
+ *  Reports, then reads red again straight away rather than a sample period
+ *  later, as the original read/delay/read/delay/read loop did: a full cycle
+ *  takes two sample periods, not three.
+ */
+void
+finish_cycle (void)
+{
+  update_lamp ();
+  sched_reschedule (sample_task, 0);
+}
+
+/* Reports the latest readings and drives the LEDs with them. */
+void
+update_lamp (void)
+{
+  char buffer[(STR_BUFFER_SIZE)] = { 0 };
+
+  PROF_BEGIN (PROF_LAMP_REPORT);
+  l_format_report (buffer, sizeof (buffer), &samples[RED], &samples[GREEN],
+                   &samples[BLUE]);
+  uart_send_string (buffer);
+  PROF_END (PROF_LAMP_REPORT);
+
+  PROF_BEGIN (PROF_LAMP_PWM);
+  pwm_set_compare (TCNTRS_2, PWMC_A, TO_DUTY_CYCLE (samples[RED].value));
+  pwm_set_compare (TCNTRS_1, PWMC_A, TO_DUTY_CYCLE (samples[GREEN].value));
+  pwm_set_compare (TCNTRS_1, PWMC_B, TO_DUTY_CYCLE (samples[BLUE].value));
+  PROF_END (PROF_LAMP_PWM);
+}
+
+/* Puts the sample period and ADC clock into effect; the baud rate waits. */
+void
+apply_config (void)
+{
+  sched_set_period (sample_task, config.sample_period_ms);
+  for (uint8_t c = 0; c < (SENSOR_COUNT); c++)
+    ai_set_prescaler (SENSORS[c],
+                      (ADCPrescalerDivisor_t)config.adc_prescaler);
+}
+
+/*
+ *  Holds stored settings to the ranges `l_command` keeps them in; a CRC only
+ *  shows they were written whole, not that they're usable. An unknown baud
+ *  rate falls back to the default. Left unsaved, so the EEPROM copy stays as
+ *  it was until the settings next change.
+ */
+void
+clamp_config (void)
+{
+  if (config.sample_period_ms < (MIN_SAMPLE_PERIOD_MS))
+    config.sample_period_ms = (MIN_SAMPLE_PERIOD_MS);
+  else if (config.sample_period_ms > (MAX_SAMPLE_PERIOD_MS))
+    config.sample_period_ms = (MAX_SAMPLE_PERIOD_MS);
+
+  if (config.adc_prescaler < (MIN_ADC_PRESCALER))
+    config.adc_prescaler = (MIN_ADC_PRESCALER);
+  else if (config.adc_prescaler > (MAX_ADC_PRESCALER))
+    config.adc_prescaler = (MAX_ADC_PRESCALER);
+
+  if (!is_baud_rate (config.baud_rate))
+    config.baud_rate = (DEFAULT_BAUD_RATE);
+}
+
+/* Prints `lamp,<sample period ms>,<ADC clock divisor>,<baud rate>`. */
+void
+show_config (void (*write) (const char *))
+{
+  char line[(STR_BUFFER_SIZE)];
+
+  snprintf (line, sizeof (line), "lamp,%u,%u,%lu\r\n",
+            config.sample_period_ms, 1U << config.adc_prescaler,
+            (unsigned long)config.baud_rate);
+  write (line);
+}
+
+/*
+ *  @return the rate after `baud_rate` in `BAUD_RATES`, wrapping around, or
+ *          the first if it isn't one of them.
+ */
+uint32_t
+next_baud_rate (uint32_t baud_rate)
+{
+  uint8_t i = 0;
+
+  while (i < (BAUD_RATE_COUNT) - 1
+         && pgm_read_dword (&BAUD_RATES[i]) != baud_rate)
+    i++;
+
+  return pgm_read_dword (&BAUD_RATES[i < (BAUD_RATE_COUNT) - 1 ? i + 1 : 0]);
+}
+
+/* @return true if `baud_rate` is one of `BAUD_RATES`. */
+bool
+is_baud_rate (uint32_t baud_rate)
+{
+  for (uint8_t i = 0; i < (BAUD_RATE_COUNT); i++)
+    if (pgm_read_dword (&BAUD_RATES[i]) == baud_rate)
+      return true;
+
+  return false;
 }
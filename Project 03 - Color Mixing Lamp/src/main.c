@@ -1,19 +1,35 @@
+#include "config_store.h"
 #include "lamp.h"
+#include "memory_monitor.h"
+#include "metrics.h"
+#include "power.h"
+#include "profiler.h"
+#include "scheduler.h"
 #include "uart_hal.h"
+#include "watchdog.h"
 
 #include <avr/interrupt.h>
 
-#define BAUD_RATE (9600)
+#define COMMAND_POLL_PERIOD_MS (100)
 
 static void init_serial_connection (void);
+static int8_t init_commands (void);
+static void poll_commands (void);
 
 int
 main (void)
 {
+  sched_init ();
+  if (l_load_config () < 0)
+    return -1;
   init_serial_connection ();
-  l_init_lamp ();
+  if (l_init_lamp () != 0)
+    return -1;
+  if (init_commands () != 0)
+    return -1;
 
-  return l_lamp_loop ();
+  pwr_init ();
+  sched_run ();
 }
 
 void
@@ -21,7 +37,57 @@ init_serial_connection (void)
 {
   const char *START_MSG = "UART connection started.\r\n";
 
-  uart_init ((BAUD_RATE), false);
+  uart_init (l_baud_rate (), false);
   sei ();
   uart_send_string (START_MSG);
 }
+
+/* Starts the profiler, if built in, and polls for serial commands. */
+int8_t
+init_commands (void)
+{
+#if PROF_ENABLED
+  prof_init ();
+#endif /* PROF_ENABLED */
+
+  if (sched_add_task (poll_commands, 0, COMMAND_POLL_PERIOD_MS,
+                      SCHED_NO_DEADLINE)
+      < 0)
+    return -1;
+
+  return 0;
+}
+
+/*
+ *  Send 'm' for a metrics dump, 'c' to clear them (see: metrics.h), 's' for
+ *  memory use (see: memory_monitor.h), 'k' for the config store's state, 'w'
+ *  to save changed settings now (see: config_store.h), the lamp's settings
+ *  commands (see: `l_command`), and with PROFILE=1, 'p' for a profile dump,
+ *  'r' to reset it (see: profiler.h).
+ *
+ *  Also checks the stack canary; once the stack has overrun .bss, a clean
+ *  restart beats running on corrupted state.
+ */
+void
+poll_commands (void)
+{
+  if (!mem_canary_intact ())
+    {
+      uart_send_string ("Fatal Error: Stack overflow.\r\n");
+      wdog_reset_system ();
+    }
+
+  while (uart_read_count () > 0)
+    {
+      const uint8_t cmd = uart_read ();
+
+      if (metrics_command (cmd, uart_send_string) == 0
+          || mem_command (cmd, uart_send_string) == 0
+          || cfg_command (cmd, uart_send_string) == 0
+          || l_command (cmd, uart_send_string) == 0)
+        continue;
+#if PROF_ENABLED
+      prof_command (cmd, uart_send_string);
+#endif /* PROF_ENABLED */
+    }
+}
@@ -1,191 +1,81 @@
 #include "pwm/clock_select.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
-#define CLOCK_SELECT_BIT_0 (CS00)
-#define CLOCK_SELECT_BIT_1 (CS01)
-#define CLOCK_SELECT_BIT_2 (CS02)
+#define CLOCK_SELECT_INVALID (0xFF)
 
-static bool validate_tcntr0_or_1_clk_select (ClockSelect_t c);
-static bool validate_tcntr2_clk_select (ClockSelect_t c);
-static void set_tcntr0_or_1_clk_select_mode_bits (PWMTimerCntr_t *pwm,
-                                                  ClockSelect_t c);
-static void set_tcntr2_clk_select_mode_bits (PWMTimerCntr_t *pwm,
-                                             ClockSelect_t c);
+/*
+ *  CSn2:0 encodings, indexed by `ClockSelect_t`.
+ *  see: Table 14-9, pg. 87 and Table 17-9, pg. 131, ATmega328P data sheet.
+ */
+static const uint8_t TCNTR0_OR_1_CLOCK_SELECT_BITS[] PROGMEM = {
+  [CS_NONE] = 0x0,
+  [CS_NO_PRESCALING] = 0x1,
+  [CS_PRESCALE_BY_8] = 0x2,
+  [CS_PRESCALE_BY_32] = CLOCK_SELECT_INVALID,
+  [CS_PRESCALE_BY_64] = 0x3,
+  [CS_PRESCALE_BY_128] = CLOCK_SELECT_INVALID,
+  [CS_PRESCALE_BY_256] = 0x4,
+  [CS_PRESCALE_BY_1024] = 0x5,
+  [CS_EXT_FALLING_EDGE] = 0x6,
+  [CS_EXT_RISING_EDGE] = 0x7,
+};
 
-bool
-clk_is_valid_clock_select (TimerCounterSelect_t t, ClockSelect_t c)
+static const uint8_t TCNTR2_CLOCK_SELECT_BITS[] PROGMEM = {
+  [CS_NONE] = 0x0,
+  [CS_NO_PRESCALING] = 0x1,
+  [CS_PRESCALE_BY_8] = 0x2,
+  [CS_PRESCALE_BY_32] = 0x3,
+  [CS_PRESCALE_BY_64] = 0x4,
+  [CS_PRESCALE_BY_128] = 0x5,
+  [CS_PRESCALE_BY_256] = 0x6,
+  [CS_PRESCALE_BY_1024] = 0x7,
+  [CS_EXT_FALLING_EDGE] = CLOCK_SELECT_INVALID,
+  [CS_EXT_RISING_EDGE] = CLOCK_SELECT_INVALID,
+};
+
+static uint8_t get_clk_select_bits (TimerCounterSelect_t t, ClockSelect_t c);
+
+uint8_t
+get_clk_select_bits (TimerCounterSelect_t t, ClockSelect_t c)
 {
+  if ((unsigned)c >= sizeof (TCNTR2_CLOCK_SELECT_BITS))
+    return CLOCK_SELECT_INVALID;
+
   switch (t)
     {
     case TCNTRS_0:
-      return validate_tcntr0_or_1_clk_select (c);
     case TCNTRS_1:
-      return validate_tcntr0_or_1_clk_select (c);
+      return pgm_read_byte (&TCNTR0_OR_1_CLOCK_SELECT_BITS[c]);
     case TCNTRS_2:
-      return validate_tcntr2_clk_select (c);
+      return pgm_read_byte (&TCNTR2_CLOCK_SELECT_BITS[c]);
     default:
-      return false;
+      return CLOCK_SELECT_INVALID;
     }
 }
 
 bool
-validate_tcntr2_clk_select (ClockSelect_t c)
+clk_is_valid_clock_select (TimerCounterSelect_t t, ClockSelect_t c)
 {
-  switch (c)
-    {
-    case CS_NONE:
-    case CS_NO_PRESCALING:
-    case CS_PRESCALE_BY_8:
-    case CS_PRESCALE_BY_32:
-    case CS_PRESCALE_BY_64:
-    case CS_PRESCALE_BY_128:
-    case CS_PRESCALE_BY_256:
-    case CS_PRESCALE_BY_1024:
-      return true;
-    case CS_EXT_FALLING_EDGE:
-    case CS_EXT_RISING_EDGE:
-    default:
-      return false;
-    }
+  return get_clk_select_bits (t, c) != CLOCK_SELECT_INVALID;
 }
 
-bool
-validate_tcntr0_or_1_clk_select (ClockSelect_t c)
+int8_t
+clk_set_clk_select_bits (volatile uint8_t *reg, TimerCounterSelect_t t,
+                         ClockSelect_t c)
 {
-  switch (c)
-    {
-    case CS_NONE:
-    case CS_NO_PRESCALING:
-    case CS_PRESCALE_BY_8:
-    case CS_PRESCALE_BY_64:
-    case CS_PRESCALE_BY_256:
-    case CS_PRESCALE_BY_1024:
-    case CS_EXT_FALLING_EDGE:
-    case CS_EXT_RISING_EDGE:
-      return true;
-    case CS_PRESCALE_BY_32:
-    case CS_PRESCALE_BY_128:
-    default:
-      return false;
-    }
+  const uint8_t bits = get_clk_select_bits (t, c);
+  if (bits == CLOCK_SELECT_INVALID)
+    return -1;
+
+  *reg = (*reg & ~(CLK_SELECT_MASK)) | (bits << (CS00));
+  return 0;
 }
 
-// FIXME: clk selection is different depending on which timer you're using.
-void
+int8_t
 clk_set_clk_select_mode_bits (PWMTimerCntr_t *pwm, TimerCounterSelect_t t,
                               ClockSelect_t c)
 {
-  switch (t)
-    {
-    case TCNTRS_0:
-    case TCNTRS_1:
-      set_tcntr0_or_1_clk_select_mode_bits (pwm, c);
-      break;
-    case TCNTRS_2:
-      set_tcntr2_clk_select_mode_bits (pwm, c);
-      break;
-    }
-}
-
-void
-set_tcntr0_or_1_clk_select_mode_bits (PWMTimerCntr_t *pwm, ClockSelect_t c)
-{
-  switch (c)
-    {
-    case CS_NONE:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_NO_PRESCALING:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_8:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_64:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_256:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_1024:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_EXT_FALLING_EDGE:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_EXT_RISING_EDGE:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_32:
-    case CS_PRESCALE_BY_128:
-      return;
-    }
-}
-
-void
-set_tcntr2_clk_select_mode_bits (PWMTimerCntr_t *pwm, ClockSelect_t c)
-{
-  switch (c)
-    {
-    case CS_NONE:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_NO_PRESCALING:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_8:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_32:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_64:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_128:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_256:
-      pwm->control_register_b &= ~(1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_PRESCALE_BY_1024:
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_0));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_1));
-      pwm->control_register_b |= (1 << (CLOCK_SELECT_BIT_2));
-      break;
-    case CS_EXT_FALLING_EDGE:
-    case CS_EXT_RISING_EDGE:
-      return;
-    }
+  return clk_set_clk_select_bits (&pwm->control_register_b, t, c);
 }
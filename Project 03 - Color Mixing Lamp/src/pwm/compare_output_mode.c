@@ -1,141 +1,61 @@
 #include "pwm/compare_output_mode.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 #define COMPARE_MATCH_OUTPUT_A_MODE_BIT_0 (COM0A0)
 #define COMPARE_MATCH_OUTPUT_A_MODE_BIT_1 (COM0A1)
 #define COMPARE_MATCH_OUTPUT_B_MODE_BIT_0 (COM0B0)
 #define COMPARE_MATCH_OUTPUT_B_MODE_BIT_1 (COM0B1)
 
-static void set_com_non_pwm_mode (PWMTimerCntr_t *pwm, CompareOutputMode_t c);
-static void set_com_fast_pwm_mode (PWMTimerCntr_t *pwm, CompareOutputMode_t c);
-static void set_com_phase_correct_pmw_mode (PWMTimerCntr_t *pwm,
-                                            CompareOutputMode_t c);
+#define COM_A(c) ((c) << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0))
+#define COM_B(c) ((c) << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0))
+#define COM_CTRL_REG_A_MASK (COM_A (0x3) | COM_B (0x3))
+
+typedef enum WaveformClass_e
+{
+  WC_NON_PWM,
+  WC_PWM,
+} WaveformClass_t;
+
+/*
+ *  COMnA1:0/COMnB1:0 encodings, indexed by waveform class and
+ *  `CompareOutputMode_t`. In the PWM modes the toggle setting is only defined
+ *  for channel A, so channel B is left disconnected.
+ *  see: pp. 128-9, ATmega328P data sheet.
+ */
+static const uint8_t COM_ENCODINGS[][COM_SET + 1] PROGMEM = {
+  [WC_NON_PWM] = {
+    [COM_NORMAL] = COM_A (COM_NORMAL) | COM_B (COM_NORMAL),
+    [COM_TOGGLE] = COM_A (COM_TOGGLE) | COM_B (COM_TOGGLE),
+    [COM_CLEAR] = COM_A (COM_CLEAR) | COM_B (COM_CLEAR),
+    [COM_SET] = COM_A (COM_SET) | COM_B (COM_SET),
+  },
+  [WC_PWM] = {
+    [COM_NORMAL] = COM_A (COM_NORMAL) | COM_B (COM_NORMAL),
+    [COM_TOGGLE] = COM_A (COM_TOGGLE),
+    [COM_CLEAR] = COM_A (COM_CLEAR) | COM_B (COM_CLEAR),
+    [COM_SET] = COM_A (COM_SET) | COM_B (COM_SET),
+  },
+};
 
 bool
 cmp_is_valid_cmp_output_mode (CompareOutputMode_t c)
 {
-  switch (c)
-    {
-    case COM_NORMAL:
-    case COM_TOGGLE:
-    case COM_CLEAR:
-    case COM_SET:
-      return true;
-    default:
-      return false;
-    }
+  return (unsigned)c <= COM_SET;
 }
 
-void
+int8_t
 cmp_set_cmp_output_mode (PWMTimerCntr_t *pwm, WaveformGenerationMode_t w,
                          CompareOutputMode_t c)
 {
-  switch (w)
-    {
-    case WGM_MODE_0:
-    case WGM_MODE_2:
-      set_com_non_pwm_mode (pwm, c);
-      break;
-    case WGM_MODE_1:
-    case WGM_MODE_5:
-      set_com_phase_correct_pmw_mode (pwm, c);
-      break;
-    case WGM_MODE_3:
-    case WGM_MODE_7:
-      set_com_fast_pwm_mode (pwm, c);
-      break;
-    }
-}
+  if (!cmp_is_valid_cmp_output_mode (c))
+    return -1;
 
-void
-set_com_non_pwm_mode (PWMTimerCntr_t *pwm, CompareOutputMode_t c)
-{
-  switch (c)
-    {
-    case COM_NORMAL:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_TOGGLE:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_CLEAR:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_SET:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    }
-}
+  const WaveformClass_t wc
+      = (w == WGM_MODE_0 || w == WGM_MODE_2) ? WC_NON_PWM : WC_PWM;
 
-void
-set_com_fast_pwm_mode (PWMTimerCntr_t *pwm, CompareOutputMode_t c)
-{
-  switch (c)
-    {
-    case COM_NORMAL:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_TOGGLE:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      break;
-    case COM_CLEAR:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_SET:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    }
-}
-
-void
-set_com_phase_correct_pmw_mode (PWMTimerCntr_t *pwm, CompareOutputMode_t c)
-{
-  switch (c)
-    {
-    case COM_NORMAL:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_TOGGLE:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      break;
-    case COM_CLEAR:
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a &= ~(1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    case COM_SET:
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_A_MODE_BIT_1));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (COMPARE_MATCH_OUTPUT_B_MODE_BIT_1));
-      break;
-    }
+  pwm->control_register_a = (pwm->control_register_a & ~(COM_CTRL_REG_A_MASK))
+                            | pgm_read_byte (&COM_ENCODINGS[wc][c]);
+  return 0;
 }
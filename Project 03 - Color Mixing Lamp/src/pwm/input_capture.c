@@ -0,0 +1,254 @@
+#include "pwm/input_capture.h"
+#include "gpio.h"
+#include "power.h"
+#include "pwm/pwm_config.h"
+#include "pwm/pwm_frequency.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdlib.h>
+#include <util/atomic.h>
+
+#define TCNTR1_CTRL_REGISTER_A (TCCR1A)
+#define TCNTR1_CTRL_REGISTER_B (TCCR1B)
+#define TCNTR1_COUNTER_REGISTER (TCNT1)
+#define TCNTR1_OUTPUT_COMPARE_REGISTER_B (OCR1B)
+#define TCNTR1_INPUT_CAPTURE_REGISTER (ICR1)
+#define TCNTR1_NOISE_CANCELER_BIT (ICNC1)
+#define TCNTR1_EDGE_SELECT_BIT (ICES1)
+#define TCNTR1_INTERRUPT_MASK_REGISTER (TIMSK1)
+#define TCNTR1_CAPTURE_INTERRUPT_ENABLE_BIT (ICIE1)
+#define TCNTR1_COMPARE_B_INTERRUPT_ENABLE_BIT (OCIE1B)
+#define TCNTR1_INTERRUPT_FLAG_REGISTER (TIFR1)
+#define TCNTR1_CAPTURE_FLAG_BIT (ICF1)
+#define TCNTR1_COMPARE_B_FLAG_BIT (OCF1B)
+
+#define ICP1_PIN B, 0
+
+__extension__ _Static_assert (((ICP_QUEUE_SIZE) & ((ICP_QUEUE_SIZE)-1)) == 0,
+                              "ICP_QUEUE_SIZE must be a power of two");
+
+static ICPCapture_t queue[(ICP_QUEUE_SIZE)];
+static volatile uint8_t queue_head = 0;
+static volatile uint8_t queue_tail = 0;
+static volatile uint16_t dropped_captures = 0;
+static volatile bool queue_gap = false;
+
+/* The upper 16 bits of the timestamps. */
+static volatile uint16_t overflows = 0;
+
+static ICPEdges_t capture_edges = ICP_RISING_EDGES;
+static uint32_t tick_hz = 0;
+/* Whether this module holds Timer/Counter1 powered. */
+static bool running = false;
+
+/* `icp_measure` state, carried between calls. */
+static bool have_period_edge = false;
+static uint32_t last_period_edge = 0;
+static uint32_t pending_high_ticks = 0;
+
+static void reset_measurement (void);
+
+/*
+ *  Timer/Counter1 Compare Match B Interrupt
+ *  Counts overflows. With OCR1B at 0 this fires as the counter wraps to
+ *  BOTTOM, like the overflow interrupt, which `pwm_stream` already defines.
+ */
+ISR (TIMER1_COMPB_vect) { overflows++; }
+
+/*
+ *  Timer/Counter1 Capture Event Interrupt
+ *  The capture vector has priority over compare match B, so an overflow
+ *  can still be pending here. If so, and the capture is from just after the
+ *  wrap (the low half of the count), it belongs to the next overflow.
+ */
+ISR (TIMER1_CAPT_vect)
+{
+  const uint16_t captured = TCNTR1_INPUT_CAPTURE_REGISTER;
+  const uint8_t ctrl = TCNTR1_CTRL_REGISTER_B;
+  uint16_t high = overflows;
+
+  if ((TCNTR1_INTERRUPT_FLAG_REGISTER & (1 << (TCNTR1_COMPARE_B_FLAG_BIT)))
+      && captured < 0x8000)
+    high++;
+
+  /*
+   *  Capturing both edges means flipping the edge select after each one,
+   *  which can set the capture flag, so it is cleared after the flip.
+   *  see: Section 15.6.3, ATmega328P data sheet.
+   */
+  if (capture_edges == ICP_BOTH_EDGES)
+    {
+      TCNTR1_CTRL_REGISTER_B = ctrl ^ (1 << (TCNTR1_EDGE_SELECT_BIT));
+      TCNTR1_INTERRUPT_FLAG_REGISTER = (1 << (TCNTR1_CAPTURE_FLAG_BIT));
+    }
+
+  const uint8_t head = queue_head;
+  const uint8_t next = (head + 1) & ((ICP_QUEUE_SIZE)-1);
+  if (next == queue_tail)
+    {
+      dropped_captures++;
+      queue_gap = true;
+      return;
+    }
+
+  queue[head].ticks = ((uint32_t)high << 16) | captured;
+  queue[head].flags
+      = ((ctrl & (1 << (TCNTR1_EDGE_SELECT_BIT))) ? (ICP_RISING_EDGE) : 0)
+        | (queue_gap ? (ICP_AFTER_GAP) : 0);
+  queue_gap = false;
+  queue_head = next;
+}
+
+int8_t
+icp_start (ClockSelect_t prescale, ICPEdges_t edges, bool noise_canceler)
+{
+  if (prescale == CS_NONE || prescale >= CS_EXT_FALLING_EDGE
+      || !PWM_CFG_CLK_IS_VALID (TCNTRS_1, prescale)
+      || (unsigned)edges > ICP_BOTH_EDGES)
+    return -1;
+
+  icp_stop ();
+
+  /* Without a pull-up; the sensor drives the pin. */
+  GPIO_MAKE_INPUT (ICP1_PIN);
+  GPIO_CLEAR (ICP1_PIN);
+
+  capture_edges = edges;
+  tick_hz = (F_CPU) / PWM_CLK_DIVISOR (prescale);
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    queue_head = 0;
+    queue_tail = 0;
+    queue_gap = false;
+    dropped_captures = 0;
+    overflows = 0;
+    reset_measurement ();
+
+    /* Its own claim, apart from the PWM code's. */
+    pwr_acquire (PWR_TIM1);
+    running = true;
+
+    /* Normal mode (WGM1 0b0000), outputs disconnected. */
+    TCNTR1_CTRL_REGISTER_A = 0;
+    TCNTR1_COUNTER_REGISTER = 0;
+    TCNTR1_OUTPUT_COMPARE_REGISTER_B = 0;
+    TCNTR1_INTERRUPT_FLAG_REGISTER = (1 << (TCNTR1_CAPTURE_FLAG_BIT))
+                                     | (1 << (TCNTR1_COMPARE_B_FLAG_BIT));
+    TCNTR1_INTERRUPT_MASK_REGISTER
+        = (1 << (TCNTR1_CAPTURE_INTERRUPT_ENABLE_BIT))
+          | (1 << (TCNTR1_COMPARE_B_INTERRUPT_ENABLE_BIT));
+    TCNTR1_CTRL_REGISTER_B
+        = (noise_canceler ? (1 << (TCNTR1_NOISE_CANCELER_BIT)) : 0)
+          | (edges != ICP_FALLING_EDGES ? (1 << (TCNTR1_EDGE_SELECT_BIT))
+                                        : 0)
+          | PWM_CFG_CLK_BITS (TCNTRS_1, prescale);
+  }
+
+  return 0;
+}
+
+void
+icp_stop (void)
+{
+  if (!running)
+    return;
+
+  TCNTR1_INTERRUPT_MASK_REGISTER
+      &= ~((1 << (TCNTR1_CAPTURE_INTERRUPT_ENABLE_BIT))
+           | (1 << (TCNTR1_COMPARE_B_INTERRUPT_ENABLE_BIT)));
+  TCNTR1_CTRL_REGISTER_B &= ~(CLK_SELECT_MASK);
+  pwr_release (PWR_TIM1);
+  running = false;
+  tick_hz = 0;
+}
+
+uint32_t
+icp_tick_hz (void)
+{
+  return tick_hz;
+}
+
+bool
+icp_read_capture (ICPCapture_t *capture)
+{
+  if (capture == NULL)
+    return false;
+
+  const uint8_t tail = queue_tail;
+  if (tail == queue_head)
+    return false;
+
+  *capture = queue[tail];
+  queue_tail = (tail + 1) & ((ICP_QUEUE_SIZE)-1);
+
+  return true;
+}
+
+int8_t
+icp_measure (ICPMeasurement_t *m)
+{
+  ICPCapture_t c;
+  bool updated = false;
+
+  while (icp_read_capture (&c))
+    {
+      if (c.flags & (ICP_AFTER_GAP))
+        reset_measurement ();
+
+      /* Falling edges only mark the end of the high time. */
+      if (capture_edges == ICP_BOTH_EDGES && !(c.flags & (ICP_RISING_EDGE)))
+        {
+          if (have_period_edge)
+            pending_high_ticks = c.ticks - last_period_edge;
+          continue;
+        }
+
+      if (have_period_edge)
+        {
+          m->period_ticks = c.ticks - last_period_edge;
+          m->high_ticks = pending_high_ticks;
+          updated = true;
+        }
+
+      have_period_edge = true;
+      last_period_edge = c.ticks;
+      pending_high_ticks = 0;
+    }
+
+  if (!updated || m->period_ticks == 0)
+    return -1;
+
+  m->frequency_hz = (tick_hz + m->period_ticks / 2) / m->period_ticks;
+
+  /* Scaled down as far as needed to keep `high * 1000` in 32 bits. */
+  uint32_t period = m->period_ticks;
+  uint32_t high = m->high_ticks;
+  while (period > UINT32_MAX / 1000)
+    {
+      period >>= 1;
+      high >>= 1;
+    }
+  m->duty_permille = (high * 1000 + period / 2) / period;
+
+  return 0;
+}
+
+uint16_t
+icp_dropped_captures (void)
+{
+  uint16_t count;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { count = dropped_captures; }
+
+  return count;
+}
+
+void
+reset_measurement (void)
+{
+  have_period_edge = false;
+  last_period_edge = 0;
+  pending_high_ticks = 0;
+}
@@ -0,0 +1,195 @@
+#include "pwm/pwm_frequency.h"
+#include "pwm/pwm_hal.h"
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Marks candidates whose TOP is solved for and written to OCRnA. */
+#define TOP_IS_OCRA (0)
+
+#define TCNTR_8_BIT_MAX_TOP (0xFF)
+
+typedef struct PWMCandidate_s
+{
+  WaveformGenerationMode_t mode;
+  uint16_t top;
+  bool phase_correct; // Dual-slope: half the frequency for the same TOP.
+} PWMCandidate_t;
+
+/** see: Table 14-8, pg. 86 and Table 17-8, pg. 130, ATmega328P data sheet. */
+static const PWMCandidate_t TCNTR0_OR_2_CANDIDATES[] PROGMEM = {
+  { WGM_MODE_3, 0xFF, false },
+  { WGM_MODE_1, 0xFF, true },
+  { WGM_MODE_7, TOP_IS_OCRA, false },
+  { WGM_MODE_5, TOP_IS_OCRA, true },
+};
+
+/*
+ *  Timer/Counter1 numbers its modes differently; these are the fixed-TOP
+ *  PWM modes reachable through `WaveformGenerationMode_t` (WGM13 = 0).
+ *  see: Table 15-5, pg. 109, ATmega328P data sheet.
+ */
+static const PWMCandidate_t TCNTR1_CANDIDATES[] PROGMEM = {
+  { WGM_MODE_5, 0xFF, false },  // Fast PWM, 8-bit
+  { WGM_MODE_7, 0x3FF, false }, // Fast PWM, 10-bit
+  { WGM_MODE_1, 0xFF, true },   // PWM, phase correct, 8-bit
+  { WGM_MODE_3, 0x3FF, true },  // PWM, phase correct, 10-bit
+};
+
+static const uint8_t PRESCALERS[] PROGMEM = {
+  CS_NO_PRESCALING,  CS_PRESCALE_BY_8,   CS_PRESCALE_BY_32,
+  CS_PRESCALE_BY_64, CS_PRESCALE_BY_128, CS_PRESCALE_BY_256,
+  CS_PRESCALE_BY_1024,
+};
+
+static uint32_t pwm_frequency (uint32_t divisor, uint16_t top,
+                               bool phase_correct);
+static uint16_t solve_top (uint32_t divisor, uint32_t target_hz,
+                           bool phase_correct);
+static uint8_t resolution_bits (uint16_t top);
+
+int8_t
+pwm_solve_for (TimerCounterSelect_t timer, uint32_t target_hz,
+               uint8_t min_bits, bool need_channel_a,
+               PWMSolution_t *solution)
+{
+  if (solution == NULL || target_hz < (PWM_FLICKER_FUSION_HZ)
+      || target_hz > (PWM_MAX_HZ) || (unsigned)timer > TCNTRS_2)
+    return -1;
+
+  const PWMCandidate_t *candidates = TCNTR0_OR_2_CANDIDATES;
+  uint8_t candidate_count = sizeof (TCNTR0_OR_2_CANDIDATES)
+                            / sizeof (TCNTR0_OR_2_CANDIDATES[0]);
+  if (timer == TCNTRS_1)
+    {
+      candidates = TCNTR1_CANDIDATES;
+      candidate_count
+          = sizeof (TCNTR1_CANDIDATES) / sizeof (TCNTR1_CANDIDATES[0]);
+    }
+
+  bool found = false;
+  uint32_t best_error = UINT32_MAX;
+
+  for (uint8_t i = 0; i < candidate_count; i++)
+    {
+      PWMCandidate_t candidate;
+      memcpy_P (&candidate, &candidates[i], sizeof (candidate));
+
+      const bool top_is_ocra = candidate.top == TOP_IS_OCRA;
+      if (top_is_ocra && need_channel_a)
+        continue;
+
+      for (uint8_t j = 0; j < sizeof (PRESCALERS); j++)
+        {
+          const ClockSelect_t prescale = pgm_read_byte (&PRESCALERS[j]);
+          if (!PWM_CFG_CLK_IS_VALID (timer, prescale))
+            continue;
+
+          const uint32_t divisor = PWM_CLK_DIVISOR (prescale);
+          const uint16_t top
+              = top_is_ocra
+                    ? solve_top (divisor, target_hz, candidate.phase_correct)
+                    : candidate.top;
+          const uint8_t bits = resolution_bits (top);
+          if (top == 0 || bits < min_bits)
+            continue;
+
+          const uint32_t hz
+              = pwm_frequency (divisor, top, candidate.phase_correct);
+          if (hz < (PWM_FLICKER_FUSION_HZ))
+            continue;
+
+          const uint32_t error
+              = hz > target_hz ? hz - target_hz : target_hz - hz;
+          /* On a tie prefer resolution, then the earlier (fixed-TOP) mode. */
+          if (found
+              && (error > best_error
+                  || (error == best_error
+                      && bits <= solution->resolution_bits)))
+            continue;
+
+          found = true;
+          best_error = error;
+          solution->waveform_gen_mode = candidate.mode;
+          solution->prescale = prescale;
+          solution->top = top;
+          solution->top_is_ocra = top_is_ocra;
+          solution->frequency_hz = hz;
+          solution->resolution_bits = bits;
+        }
+    }
+
+  return found ? 0 : -1;
+}
+
+int8_t
+pwm_configure_for (TimerCounterSelect_t timer, uint32_t target_hz,
+                   uint8_t min_bits, bool need_channel_a,
+                   PWMSolution_t *solution)
+{
+  if (pwm_solve_for (timer, target_hz, min_bits, need_channel_a, solution)
+      != 0)
+    return -1;
+
+  if (pwm_init (timer, solution->waveform_gen_mode, COM_CLEAR, false, false,
+                solution->prescale)
+      != 0)
+    return -1;
+
+  if (solution->top_is_ocra)
+    pwm_set_compare (timer, PWMC_A, solution->top);
+
+  return 0;
+}
+
+/** see: pp. 79-81, ATmega328P data sheet. */
+uint32_t
+pwm_frequency (uint32_t divisor, uint16_t top, bool phase_correct)
+{
+  if (phase_correct)
+    return (F_CPU) / (2 * divisor * top);
+
+  return (F_CPU) / (divisor * (top + 1UL));
+}
+
+/*
+ *  @param  target_hz  at most `PWM_MAX_HZ`
+ *  @return the rounded TOP for `target_hz`, or 0 if it does not fit.
+ */
+uint16_t
+solve_top (uint32_t divisor, uint32_t target_hz, bool phase_correct)
+{
+  /*
+   *  Divided down to the timer clock first: `divisor * target_hz` overflows
+   *  32 bits at /1024 past ~4 MHz. F_CPU is a multiple of every divisor.
+   */
+  const uint32_t timer_hz = (F_CPU) / divisor;
+  uint32_t top;
+
+  if (phase_correct)
+    top = (timer_hz + target_hz) / (2 * target_hz);
+  else
+    {
+      top = (2 * timer_hz + target_hz) / (2 * target_hz);
+      if (top > 0)
+        top--;
+    }
+
+  return top > (TCNTR_8_BIT_MAX_TOP) ? 0 : top;
+}
+
+uint8_t
+resolution_bits (uint16_t top)
+{
+  uint8_t bits = 0;
+  uint32_t steps = top + 1UL;
+
+  while (steps > 1)
+    {
+      steps >>= 1;
+      bits++;
+    }
+
+  return bits;
+}
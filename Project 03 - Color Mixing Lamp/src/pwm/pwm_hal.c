@@ -1,18 +1,12 @@
 #include "pwm/pwm_hal.h"
+#include "metrics.h"
+#include "power.h"
 #include "uart_hal.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 #include <stdint.h>
 
-#define TCNTR0_CONTROL_REGISTER_A (TCCR0A)
-#define TCNTR0_CONTROL_REGISTER_B (TCCR0B)
-
-#define TCNTR1_CONTROL_REGISTER_A (TCCR1A)
-#define TCNTR1_CONTROL_REGISTER_B (TCCR1B)
-
-#define TCNTR2_CONTROL_REGISTER_A (TCCR2A)
-#define TCNTR2_CONTROL_REGISTER_B (TCCR2B)
-
 #define TCNTR0_OUTPUT_COMPARE_REGISTER_A (OCR0A)
 #define TCNTR0_OUTPUT_COMPARE_REGISTER_B (OCR0B)
 
@@ -28,13 +22,21 @@
 #define FORCE_OUTPUT_COMPARE_B_BIT (FOC0B)
 /***************************/
 
-#define POWER_REDUCTION_REGISTER (PRR)
+/* Release images keep the checks, but not the messages. */
+#ifndef NDEBUG
+#define REPORT_ERROR(msg) uart_send_string (msg)
+#else
+#define REPORT_ERROR(msg) ((void)0)
+#endif /* NDEBUG */
 
-/* Power Reduction Register Bits */
-#define TCNTR0_POWER_REDUCTION_BIT (PRTIM0)
-#define TCNTR1_POWER_REDUCTION_BIT (PRTIM1)
-#define TCNTR2_POWER_REDUCTION_BIT (PRTIM2)
-/***************************/
+static const PWMTimerDesc_t TIMER_DESCRIPTORS[] PROGMEM = {
+  [TCNTRS_0] = { &TCCR0A, &TCCR0B, &TCCR0B, PWR_TIM0 },
+  [TCNTRS_1] = { &TCCR1A, &TCCR1B, &TCCR1C, PWR_TIM1 },
+  [TCNTRS_2] = { &TCCR2A, &TCCR2B, &TCCR2B, PWR_TIM2 },
+};
+
+/* Bit n is set while the PWM code holds Timer/Countern powered. */
+static uint8_t powered_timers = 0;
 
 static int8_t validate_init_input (TimerCounterSelect_t t,
                                    WaveformGenerationMode_t w,
@@ -42,14 +44,12 @@ static int8_t validate_init_input (TimerCounterSelect_t t,
                                    bool force_output_cmp_a,
                                    bool force_output_cmp_b, ClockSelect_t s);
 static bool is_valid_timer (TimerCounterSelect_t t);
-static void get_control_regs_from_selection (TimerCounterSelect_t t,
-                                             uint16_t *ctrl_reg_a,
-                                             uint16_t *ctrl_reg_b);
+static int8_t write_control_registers (TimerCounterSelect_t t,
+                                       const PWMTimerCntr_t *pwm);
 static void set_force_output_compare_bits (PWMTimerCntr_t *pwm,
                                            WaveformGenerationMode_t w,
                                            bool force_output_cmp_a,
                                            bool force_output_cmp_b);
-static void enable_tcntr (TimerCounterSelect_t t);
 
 int8_t
 pwm_init (TimerCounterSelect_t timer,
@@ -64,9 +64,7 @@ pwm_init (TimerCounterSelect_t timer,
       return -1;
     }
 
-  PWMTimerCntr_t pwm;
-  get_control_regs_from_selection (timer, &pwm.control_register_a,
-                                   &pwm.control_register_b);
+  PWMTimerCntr_t pwm = { 0 };
   /*
    *  Doing this first as "this bit must be set to zero when
    *  [TCNTR0_CONTROL_REGISTER_B] is written when operating in PWM mode."
@@ -74,14 +72,98 @@ pwm_init (TimerCounterSelect_t timer,
    */
   set_force_output_compare_bits (&pwm, waveform_gen_mode, force_output_cmp_a,
                                  force_output_cmp_b);
-  wgm_set_waveform_gen_mode (&pwm, waveform_gen_mode);
-  cmp_set_cmp_output_mode (&pwm, waveform_gen_mode, cmp_output_mode);
-  clk_set_clk_select_mode_bits (&pwm, timer, prescale);
+  if (wgm_set_waveform_gen_mode (&pwm, waveform_gen_mode) != 0
+      || cmp_set_cmp_output_mode (&pwm, waveform_gen_mode, cmp_output_mode)
+             != 0
+      || clk_set_clk_select_mode_bits (&pwm, timer, prescale) != 0)
+    return -1;
 
-  enable_tcntr (timer);
+  return write_control_registers (timer, &pwm);
+}
+
+void
+pwm_apply_config (const PWMConfig_t *cfg)
+{
+  const PWMTimerCntr_t pwm = { cfg->control_register_a,
+                               cfg->control_register_b,
+                               cfg->force_output_cmp };
+
+  /* `PWM_DEFINE_CONFIG` has already checked the timer. */
+  write_control_registers (cfg->timer, &pwm);
+}
+
+int8_t
+pwm_set_prescaler (TimerCounterSelect_t timer, ClockSelect_t prescale)
+{
+  if (!is_valid_timer (timer) || !clk_is_valid_clock_select (timer, prescale))
+    {
+      REPORT_ERROR ("Error: Invalid clock prescaler provided!\r\n");
+      return -1;
+    }
+
+  volatile uint8_t *ctrl_reg_b
+      = pgm_read_ptr (&TIMER_DESCRIPTORS[timer].control_register_b);
+  clk_set_clk_select_bits (ctrl_reg_b, timer, prescale);
+  METRIC_INC (pwm_reconfigs);
   return 0;
 }
 
+void
+pwm_set_compare (TimerCounterSelect_t timer, PWMChannel_t channel,
+                 uint16_t value)
+{
+  switch (timer)
+    {
+    case TCNTRS_0:
+      if (channel == PWMC_A)
+        TCNTR0_OUTPUT_COMPARE_REGISTER_A = value;
+      else
+        TCNTR0_OUTPUT_COMPARE_REGISTER_B = value;
+      break;
+    case TCNTRS_1:
+      if (channel == PWMC_A)
+        TCNTR1_OUTPUT_COMPARE_REGISTER_A = value;
+      else
+        TCNTR1_OUTPUT_COMPARE_REGISTER_B = value;
+      break;
+    case TCNTRS_2:
+      if (channel == PWMC_A)
+        TCNTR2_OUTPUT_COMPARE_REGISTER_A = value;
+      else
+        TCNTR2_OUTPUT_COMPARE_REGISTER_B = value;
+      break;
+    }
+}
+
+void
+pwm_power_up (TimerCounterSelect_t timer)
+{
+  if ((unsigned)timer > TCNTRS_2 || (powered_timers & (1 << timer)))
+    return;
+
+  /*
+   *  "Writing a logic one to this bit shuts down the [Timer/CounterN] module.
+   *  When the [Timer/CounterN] is enabled, operation will continue like before
+   *  the shutdown." (pg. 39, ATmega328P data sheet).
+   */
+  pwr_acquire (pgm_read_byte (&TIMER_DESCRIPTORS[timer].power_peripheral));
+  powered_timers |= (1 << timer);
+}
+
+void
+pwm_power_down (TimerCounterSelect_t timer)
+{
+  if ((unsigned)timer > TCNTRS_2 || !(powered_timers & (1 << timer)))
+    return;
+
+  volatile uint8_t *ctrl_reg_b
+      = pgm_read_ptr (&TIMER_DESCRIPTORS[timer].control_register_b);
+  *ctrl_reg_b &= ~(CLK_SELECT_MASK);
+
+  pwr_release (pgm_read_byte (&TIMER_DESCRIPTORS[timer].power_peripheral));
+  powered_timers &= ~(1 << timer);
+}
+
 int8_t
 validate_init_input (TimerCounterSelect_t t, WaveformGenerationMode_t w,
                      CompareOutputMode_t c, bool force_output_cmp_a,
@@ -89,18 +171,17 @@ validate_init_input (TimerCounterSelect_t t, WaveformGenerationMode_t w,
 {
   if (!is_valid_timer (t))
     {
-      uart_send_string ("Error: Invalid timer selection provided!\r\n");
+      REPORT_ERROR ("Error: Invalid timer selection provided!\r\n");
       return -1;
     }
   else if (!wgm_is_valid_waveform_gen_mode (w))
     {
-      uart_send_string (
-          "Error: Invalid waveform generation mode provided!\r\n");
+      REPORT_ERROR ("Error: Invalid waveform generation mode provided!\r\n");
       return -1;
     }
   else if (!cmp_is_valid_cmp_output_mode (c))
     {
-      uart_send_string ("Error: Invalid compare output mode provided!\r\n");
+      REPORT_ERROR ("Error: Invalid compare output mode provided!\r\n");
       return -1;
     }
   /*
@@ -110,13 +191,13 @@ validate_init_input (TimerCounterSelect_t t, WaveformGenerationMode_t w,
   else if (w != WGM_MODE_0 && w != WGM_MODE_2
            && (force_output_cmp_a || force_output_cmp_b))
     {
-      uart_send_string ("Error: Conflict between given waveform generation "
-                        "mode and force output compare flag.\r\n");
+      REPORT_ERROR ("Error: Conflict between given waveform generation "
+                    "mode and force output compare flag.\r\n");
       return -1;
     }
   else if (!clk_is_valid_clock_select (t, s))
     {
-      uart_send_string ("Error: Invalid clock prescaler provided!\r\n");
+      REPORT_ERROR ("Error: Invalid clock prescaler provided!\r\n");
       return -1;
     }
 
@@ -137,25 +218,29 @@ is_valid_timer (TimerCounterSelect_t t)
     }
 }
 
-void
-get_control_regs_from_selection (TimerCounterSelect_t t, uint16_t *ctrl_reg_a,
-                                 uint16_t *ctrl_reg_b)
+/*
+ *  Writes each control register once, with the clock select bits (in TCCRnB)
+ *  last so that the timer starts fully configured.
+ */
+int8_t
+write_control_registers (TimerCounterSelect_t t, const PWMTimerCntr_t *pwm)
 {
-  switch (t)
-    {
-    case TCNTRS_0:
-      *ctrl_reg_a = TCNTR0_CONTROL_REGISTER_A;
-      *ctrl_reg_b = TCNTR0_CONTROL_REGISTER_B;
-      break;
-    case TCNTRS_1:
-      *ctrl_reg_a = TCNTR1_CONTROL_REGISTER_A;
-      *ctrl_reg_b = TCNTR1_CONTROL_REGISTER_B;
-      break;
-    case TCNTRS_2:
-      *ctrl_reg_a = TCNTR2_CONTROL_REGISTER_A;
-      *ctrl_reg_b = TCNTR2_CONTROL_REGISTER_B;
-      break;
-    }
+  if (!is_valid_timer (t))
+    return -1;
+
+  const PWMTimerDesc_t *desc = &TIMER_DESCRIPTORS[t];
+  volatile uint8_t *ctrl_reg_a = pgm_read_ptr (&desc->control_register_a);
+  volatile uint8_t *ctrl_reg_b = pgm_read_ptr (&desc->control_register_b);
+  volatile uint8_t *foc_reg = pgm_read_ptr (&desc->force_output_register);
+
+  pwm_power_up (t);
+
+  *ctrl_reg_a = pwm->control_register_a;
+  *ctrl_reg_b = pwm->control_register_b;
+  if (pwm->force_output_cmp)
+    *foc_reg |= pwm->force_output_cmp;
+  METRIC_INC (pwm_reconfigs);
+  return 0;
 }
 
 void
@@ -163,48 +248,14 @@ set_force_output_compare_bits (PWMTimerCntr_t *pwm, WaveformGenerationMode_t w,
                                bool force_output_cmp_a,
                                bool force_output_cmp_b)
 {
-  switch (w)
+  /* FOCnA/B are strobes which are only honoured in the non-PWM modes. */
+  if (w != WGM_MODE_0 && w != WGM_MODE_2)
     {
-    case WGM_MODE_0:
-    case WGM_MODE_2:
-      if (force_output_cmp_a)
-        pwm->control_register_b |= (1 << (FORCE_OUTPUT_COMPARE_A_BIT));
-      else if (!force_output_cmp_a)
-        pwm->control_register_b &= ~(1 << (FORCE_OUTPUT_COMPARE_A_BIT));
-
-      if (force_output_cmp_b)
-        pwm->control_register_b |= (1 << (FORCE_OUTPUT_COMPARE_B_BIT));
-      else if (!force_output_cmp_b)
-        pwm->control_register_b &= ~(1 << (FORCE_OUTPUT_COMPARE_B_BIT));
-      break;
-    case WGM_MODE_1:
-    case WGM_MODE_5:
-    case WGM_MODE_3:
-    case WGM_MODE_7:
-      pwm->control_register_b &= ~(1 << (FORCE_OUTPUT_COMPARE_A_BIT));
-      pwm->control_register_b &= ~(1 << (FORCE_OUTPUT_COMPARE_B_BIT));
-      break;
+      pwm->force_output_cmp = 0;
+      return;
     }
-}
 
-void
-enable_tcntr (TimerCounterSelect_t t)
-{
-  /*
-   *  "Writing a logic one to this bit shuts down the [Timer/CounterN] module.
-   *  When the [Timer/CounterN] is enabled, operation will continue like before
-   *  the shutdown." (pg. 39, ATmega328P data sheet).
-   */
-  switch (t)
-    {
-    case TCNTRS_0:
-      POWER_REDUCTION_REGISTER &= ~(1 << (TCNTR0_POWER_REDUCTION_BIT));
-      break;
-    case TCNTRS_1:
-      POWER_REDUCTION_REGISTER &= ~(1 << (TCNTR1_POWER_REDUCTION_BIT));
-      break;
-    case TCNTRS_2:
-      POWER_REDUCTION_REGISTER &= ~(1 << (TCNTR2_POWER_REDUCTION_BIT));
-      break;
-    }
+  pwm->force_output_cmp
+      = (force_output_cmp_a ? (1 << (FORCE_OUTPUT_COMPARE_A_BIT)) : 0)
+        | (force_output_cmp_b ? (1 << (FORCE_OUTPUT_COMPARE_B_BIT)) : 0);
 }
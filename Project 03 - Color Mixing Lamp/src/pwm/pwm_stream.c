@@ -0,0 +1,195 @@
+#include "pwm/pwm_stream.h"
+#include "gpio.h"
+#include "pwm/pwm_config.h"
+#include "pwm/pwm_hal.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <util/atomic.h>
+
+#define TCNTR1_OUTPUT_COMPARE_REGISTER_A (OCR1A)
+#define TCNTR1_INTERRUPT_MASK_REGISTER (TIMSK1)
+#define TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT (TOIE1)
+#define TCNTR1_INTERRUPT_FLAG_REGISTER (TIFR1)
+#define TCNTR1_OVERFLOW_FLAG_BIT (TOV1)
+
+#define OC1A_PIN B, 1
+
+#define MID_SCALE (0x80)
+#define SLOT_COUNT (2)
+
+typedef struct PWMStreamSlot_s
+{
+  const uint8_t *samples;
+  uint16_t length;
+  uint8_t flags;
+  volatile bool queued;
+} PWMStreamSlot_t;
+
+/* 8-bit fast PWM (WGM1 0b0101, Table 15-5, pg. 109), non-inverting OC1A. */
+PWM_DEFINE_CONFIG (STREAM_PWM_CONFIG, TCNTRS_1, WGM_MODE_5, COM_CLEAR, false,
+                   false, CS_NO_PRESCALING);
+
+static PWMStreamSlot_t slots[(SLOT_COUNT)];
+static volatile uint8_t active_slot = 0;
+static volatile uint16_t sample_pos = 0;
+static volatile uint8_t ticks_per_sample = 1;
+static volatile uint8_t ticks_left = 1;
+static volatile uint16_t underruns = 0;
+static bool started = false;
+
+static void start_sample_clock (void);
+static void stop_sample_clock (void);
+
+/*
+ *  Timer/Counter1 Overflow Interrupt
+ *  Fires at the carrier rate while a buffer is queued; every
+ *  `ticks_per_sample`-th overflow outputs the next sample. The new duty cycle
+ *  is latched at the next BOTTOM. Once both buffers have played, the
+ *  interrupt turns itself off until the next `pwm_stream_queue`.
+ */
+ISR (TIMER1_OVF_vect)
+{
+  if (--ticks_left != 0)
+    return;
+  ticks_left = ticks_per_sample;
+
+  const uint8_t current = active_slot;
+  PWMStreamSlot_t *slot = &slots[current];
+  if (!slot->queued)
+    {
+      stop_sample_clock ();
+      return;
+    }
+
+  uint16_t pos = sample_pos;
+  TCNTR1_OUTPUT_COMPARE_REGISTER_A = (slot->flags & (PWM_STREAM_IN_FLASH))
+                                         ? pgm_read_byte (&slot->samples[pos])
+                                         : slot->samples[pos];
+
+  if (++pos >= slot->length)
+    {
+      pos = 0;
+      if (!(slot->flags & (PWM_STREAM_LOOP)) || slots[current ^ 1].queued)
+        {
+          slot->queued = false;
+          active_slot = current ^ 1;
+          if (!slots[current ^ 1].queued)
+            {
+              if (!(slot->flags & (PWM_STREAM_END)))
+                underruns++;
+              stop_sample_clock ();
+            }
+        }
+    }
+  sample_pos = pos;
+}
+
+uint16_t
+pwm_stream_init (uint16_t sample_rate_hz)
+{
+  if (sample_rate_hz == 0 || sample_rate_hz > (PWM_STREAM_CARRIER_HZ))
+    return 0;
+
+  const uint32_t ticks = ((PWM_STREAM_CARRIER_HZ) + sample_rate_hz / 2)
+                         / sample_rate_hz;
+  if (ticks > UINT8_MAX)
+    return 0;
+
+  pwm_stream_stop ();
+  ticks_per_sample = ticks;
+  underruns = 0;
+
+  pwm_apply_config (&STREAM_PWM_CONFIG);
+  /* OC1x must be set up before the pin is made an output. */
+  GPIO_MAKE_OUTPUT (OC1A_PIN);
+  started = true;
+
+  return (PWM_STREAM_CARRIER_HZ) / ticks;
+}
+
+int8_t
+pwm_stream_queue (const uint8_t *samples, uint16_t length, uint8_t flags)
+{
+  if (samples == NULL || length == 0 || !started)
+    return -1;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    const uint8_t current = active_slot;
+    const uint8_t target = slots[current].queued ? current ^ 1 : current;
+    PWMStreamSlot_t *slot = &slots[target];
+    if (slot->queued)
+      return -1;
+
+    slot->samples = samples;
+    slot->length = length;
+    slot->flags = flags;
+    slot->queued = true;
+    if (target == current)
+      {
+        sample_pos = 0;
+        start_sample_clock ();
+      }
+  }
+
+  return 0;
+}
+
+bool
+pwm_stream_can_queue (void)
+{
+  return !slots[0].queued || !slots[1].queued;
+}
+
+bool
+pwm_stream_is_idle (void)
+{
+  return !slots[0].queued && !slots[1].queued;
+}
+
+uint16_t
+pwm_stream_underruns (void)
+{
+  uint16_t count;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { count = underruns; }
+
+  return count;
+}
+
+void
+pwm_stream_stop (void)
+{
+  stop_sample_clock ();
+  started = false;
+
+  slots[0].queued = false;
+  slots[1].queued = false;
+  active_slot = 0;
+  sample_pos = 0;
+
+  /* Undoes `pwm_stream_init`, leaving OCR1A at mid-scale for the next. */
+  GPIO_MAKE_INPUT (OC1A_PIN);
+  TCNTR1_OUTPUT_COMPARE_REGISTER_A = (MID_SCALE);
+  pwm_power_down (TCNTRS_1);
+}
+
+/* Starts counting from a whole sample period, without a stale overflow. */
+void
+start_sample_clock (void)
+{
+  ticks_left = ticks_per_sample;
+  TCNTR1_INTERRUPT_FLAG_REGISTER = (1 << (TCNTR1_OVERFLOW_FLAG_BIT));
+  TCNTR1_INTERRUPT_MASK_REGISTER
+      |= (1 << (TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT));
+}
+
+void
+stop_sample_clock (void)
+{
+  TCNTR1_INTERRUPT_MASK_REGISTER
+      &= ~(1 << (TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT));
+}
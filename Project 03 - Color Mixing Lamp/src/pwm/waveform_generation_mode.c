@@ -1,63 +1,60 @@
 #include "pwm/waveform_generation_mode.h"
 
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 #define WAVEFORM_GENERATION_MODE_BIT_0 (WGM00)
 #define WAVEFORM_GENERATION_MODE_BIT_1 (WGM01)
 
 #define WAVEFORM_GENERATION_MODE_BIT_2 (WGM02)
 
+#define WGM_CTRL_REG_A_MASK                                                   \
+  ((1 << (WAVEFORM_GENERATION_MODE_BIT_0))                                    \
+   | (1 << (WAVEFORM_GENERATION_MODE_BIT_1)))
+#define WGM_CTRL_REG_B_MASK (1 << (WAVEFORM_GENERATION_MODE_BIT_2))
+
+/* Marks the reserved modes (0b100 and 0b110). */
+#define WGM_INVALID (0xFF)
+
+typedef struct WGMEncoding_s
+{
+  uint8_t control_register_a;
+  uint8_t control_register_b;
+} WGMEncoding_t;
+
+/** see: Table 17-8, pg. 130, ATmega328P data sheet. */
+static const WGMEncoding_t WGM_ENCODINGS[] PROGMEM = {
+  [WGM_MODE_0] = { 0, 0 },
+  [WGM_MODE_1] = { (1 << (WAVEFORM_GENERATION_MODE_BIT_0)), 0 },
+  [WGM_MODE_2] = { (1 << (WAVEFORM_GENERATION_MODE_BIT_1)), 0 },
+  [WGM_MODE_3] = { WGM_CTRL_REG_A_MASK, 0 },
+  [0x4] = { WGM_INVALID, WGM_INVALID },
+  [WGM_MODE_5] = { (1 << (WAVEFORM_GENERATION_MODE_BIT_0)),
+                   WGM_CTRL_REG_B_MASK },
+  [0x6] = { WGM_INVALID, WGM_INVALID },
+  [WGM_MODE_7] = { WGM_CTRL_REG_A_MASK, WGM_CTRL_REG_B_MASK },
+};
+
 bool
 wgm_is_valid_waveform_gen_mode (WaveformGenerationMode_t w)
 {
-  switch (w)
-    {
-    case WGM_MODE_0:
-    case WGM_MODE_1:
-    case WGM_MODE_2:
-    case WGM_MODE_3:
-    case WGM_MODE_5:
-    case WGM_MODE_7:
-      return true;
-    default:
-      return false;
-    }
+  return (unsigned)w < sizeof (WGM_ENCODINGS) / sizeof (WGM_ENCODINGS[0])
+         && pgm_read_byte (&WGM_ENCODINGS[w].control_register_a)
+                != WGM_INVALID;
 }
 
-void
+int8_t
 wgm_set_waveform_gen_mode (PWMTimerCntr_t *pwm, WaveformGenerationMode_t w)
 {
-  switch (w)
-    {
-    case WGM_MODE_0:
-      pwm->control_register_a &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    case WGM_MODE_1:
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    case WGM_MODE_2:
-      pwm->control_register_a &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    case WGM_MODE_3:
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    case WGM_MODE_5:
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a &= ~(1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b |= (1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    case WGM_MODE_7:
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_0));
-      pwm->control_register_a |= (1 << (WAVEFORM_GENERATION_MODE_BIT_1));
-      pwm->control_register_b |= (1 << (WAVEFORM_GENERATION_MODE_BIT_2));
-      break;
-    }
+  if (!wgm_is_valid_waveform_gen_mode (w))
+    return -1;
+
+  const uint8_t a = pgm_read_byte (&WGM_ENCODINGS[w].control_register_a);
+  const uint8_t b = pgm_read_byte (&WGM_ENCODINGS[w].control_register_b);
+
+  pwm->control_register_a
+      = (pwm->control_register_a & ~(WGM_CTRL_REG_A_MASK)) | a;
+  pwm->control_register_b
+      = (pwm->control_register_b & ~(WGM_CTRL_REG_B_MASK)) | b;
+  return 0;
 }
@@ -0,0 +1,14 @@
+# Compares two bench_results.csv files, keyed on image and benchmark name.
+# Usage: awk -F, -f compare.awk BASELINE.csv RESULTS.csv
+FNR == 1 { next }
+NR == FNR { before[$2 "," $3] = $4; next }
+{
+  key = $2 "," $3
+  if (!(key in before))
+    printf "%-40s %10s %10d       new\n", key, "-", $4
+  else if (before[key] == 0)
+    printf "%-40s %10d %10d\n", key, before[key], $4
+  else
+    printf "%-40s %10d %10d %+8.1f%%\n", key, before[key], $4,
+           100.0 * ($4 - before[key]) / before[key]
+}
@@ -0,0 +1,63 @@
+/*
+ *  Benchmark Harness
+ *  Counts CPU cycles spent in firmware hot paths. Each benchmark image runs
+ *  a handful of calls under simavr (see: bench/Makefile), so no board is
+ *  needed and the counts are exact and repeatable.
+ *
+ *  Timer/Counter1 runs at clk/1 with its overflows counted, giving 32-bit
+ *  cycle stamps; images must leave Timer/Counter1 alone. Results go out over
+ *  USART0 as one line per benchmark:
+ *
+ *    BENCH,<image>,<name>,<cycles per call>,<calls>
+ *
+ *  Cycles per call exclude the cost of taking the stamps, but include the
+ *  loop around the calls; the "loop_overhead" line reported by
+ *  `bench_init` is that cost.
+ */
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+
+#define BENCH_BAUD_RATE (115200)
+
+/*
+ *  Times `calls` runs of `stmt` and reports the average.
+ *  @param  name   the benchmark's name in the results
+ *  @param  calls  how many times to run `stmt`, 1-65535
+ *  @param  stmt   the statement to time
+ */
+#define BENCH_RUN(name, calls, stmt)                                          \
+  do                                                                          \
+    {                                                                         \
+      const uint32_t bench_start_ = bench_cycles ();                          \
+      for (uint16_t bench_i_ = 0; bench_i_ < (calls); bench_i_++)             \
+        {                                                                     \
+          stmt;                                                               \
+        }                                                                     \
+      bench_report ((name), bench_cycles () - bench_start_, (calls));         \
+    }                                                                         \
+  while (0)
+
+/*
+ *  Starts the cycle counter and the serial connection, and reports the
+ *  overhead of `BENCH_RUN` itself.
+ *  @param  image  the image's name in the results
+ */
+void bench_init (const char *image);
+
+/* @return cycles since `bench_init`. */
+uint32_t bench_cycles (void);
+
+/*
+ *  Reports a benchmark's cycles per call.
+ *  @param  name    the benchmark's name
+ *  @param  cycles  the total cycles taken, including the stamp overhead
+ *  @param  calls   the number of calls `cycles` covers
+ */
+void bench_report (const char *name, uint32_t cycles, uint16_t calls);
+
+/* Waits for the results to go out, then stops the CPU, ending simavr. */
+void bench_done (void) __attribute__ ((noreturn));
+
+#endif /* _BENCH_H_ */
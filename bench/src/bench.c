@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "power.h"
+#include "uart_hal.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <stdio.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+#define TCNTR1_CTRL_REGISTER_A (TCCR1A)
+#define TCNTR1_CTRL_REGISTER_B (TCCR1B)
+#define TCNTR1_COUNTER_REGISTER (TCNT1)
+#define TCNTR1_INTERRUPT_MASK_REGISTER (TIMSK1)
+#define TCNTR1_INTERRUPT_FLAG_REGISTER (TIFR1)
+#define TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT (TOIE1)
+#define TCNTR1_OVERFLOW_FLAG_BIT (TOV1)
+#define CLOCK_SELECT_BIT_0 (CS10)
+
+#define LINE_BUFFER_SIZE (64)
+#define OVERHEAD_CALLS (64)
+/* Long enough for the last byte (~87 us at 115200 baud) to go out. */
+#define DRAIN_DELAY_US (200)
+
+static volatile uint16_t overflows = 0;
+static const char *image_name = "";
+static uint16_t stamp_overhead = 0;
+
+/* Timer/Counter1 Overflow Interrupt */
+ISR (TIMER1_OVF_vect) { overflows++; }
+
+void
+bench_init (const char *image)
+{
+  image_name = image;
+
+  uart_init ((BENCH_BAUD_RATE), true);
+
+  /* Normal mode (WGM1 0b0000), clk/1. */
+  pwr_acquire (PWR_TIM1);
+  TCNTR1_CTRL_REGISTER_A = 0;
+  TCNTR1_COUNTER_REGISTER = 0;
+  TCNTR1_INTERRUPT_FLAG_REGISTER = (1 << (TCNTR1_OVERFLOW_FLAG_BIT));
+  TCNTR1_INTERRUPT_MASK_REGISTER
+      = (1 << (TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT));
+  TCNTR1_CTRL_REGISTER_B = (1 << (CLOCK_SELECT_BIT_0));
+
+  sei ();
+
+  const uint32_t start = bench_cycles ();
+  stamp_overhead = bench_cycles () - start;
+
+  /* The empty barrier keeps the loop from being optimized away. */
+  BENCH_RUN ("loop_overhead", (OVERHEAD_CALLS), __asm__ volatile ("" ::));
+}
+
+/*
+ *  An overflow can be pending when the count is read. If so, and the count
+ *  is from just after the wrap, the overflow is counted here instead.
+ */
+uint32_t
+bench_cycles (void)
+{
+  uint16_t high;
+  uint16_t low;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    low = TCNTR1_COUNTER_REGISTER;
+    high = overflows;
+    if ((TCNTR1_INTERRUPT_FLAG_REGISTER & (1 << (TCNTR1_OVERFLOW_FLAG_BIT)))
+        && low < 0x8000)
+      high++;
+  }
+
+  return ((uint32_t)high << 16) | low;
+}
+
+void
+bench_report (const char *name, uint32_t cycles, uint16_t calls)
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  cycles = cycles > stamp_overhead ? cycles - stamp_overhead : 0;
+  snprintf (line, sizeof (line), "BENCH,%s,%s,%lu,%u\r\n", image_name, name,
+            (unsigned long)((cycles + calls / 2) / calls), calls);
+  uart_send_string (line);
+}
+
+/* simavr quits when the CPU sleeps with interrupts disabled. */
+void
+bench_done (void)
+{
+  _delay_us (DRAIN_DELAY_US);
+
+  cli ();
+  set_sleep_mode (SLEEP_MODE_PWR_DOWN);
+  sleep_enable ();
+  for (;;)
+    sleep_cpu ();
+}
@@ -0,0 +1,34 @@
+/*
+ *  ADC hot paths: a bare conversion, and `ai_analog_read` with and without
+ *  the ADC being reconfigured for a different input.
+ */
+#include "adc.h"
+#include "analog_input.h"
+#include "bench.h"
+
+#define CONVERSION_CALLS (16)
+
+int
+main (void)
+{
+  AnalogInput_t inputs[2] = { 0 };
+  uint16_t value = 0;
+  uint8_t next = 0;
+
+  bench_init ("adc");
+
+  if (ai_create_analog_input (&inputs[0], ADCC_ADC0) != ADC_INIT_SUCCESS
+      || ai_create_analog_input (&inputs[1], ADCC_ADC1) != ADC_INIT_SUCCESS)
+    bench_done ();
+
+  /* The first conversion after enabling the ADC is longer; keep it out. */
+  adc_start (true);
+
+  BENCH_RUN ("adc_start", (CONVERSION_CALLS), value += adc_start (true));
+  BENCH_RUN ("ai_analog_read_same_channel", (CONVERSION_CALLS),
+             ai_analog_read (&inputs[0], &value));
+  BENCH_RUN ("ai_analog_read_other_channel", (CONVERSION_CALLS),
+             ai_analog_read (&inputs[next ^= 1], &value));
+
+  bench_done ();
+}
@@ -0,0 +1,48 @@
+/*
+ *  Report formatting: Project 03's `l_format_report` and Project 02's
+ *  `love_o_meter_format_report`, linked from the projects' own sources.
+ */
+#include "bench.h"
+#include "lamp.h"
+#include "love_o_meter.h"
+
+#define FORMAT_CALLS (8)
+
+/* Volatile, so the compiler can't fold the formatting away. */
+static volatile uint16_t sensor_val = 153;
+static volatile uint32_t timestamp_us = 4000000;
+
+static char buffer[256];
+
+static void lamp_report (void);
+static void love_o_meter_report (void);
+
+int
+main (void)
+{
+  bench_init ("format");
+
+  BENCH_RUN ("lamp_format_report", (FORMAT_CALLS), lamp_report ());
+  BENCH_RUN ("love_o_meter_format_report", (FORMAT_CALLS),
+             love_o_meter_report ());
+
+  bench_done ();
+}
+
+void
+lamp_report (void)
+{
+  const ADCSample_t sample = { .value = sensor_val,
+                               .timestamp_us = timestamp_us };
+
+  l_format_report (buffer, sizeof (buffer), &sample, &sample, &sample);
+}
+
+void
+love_o_meter_report (void)
+{
+  const ADCSample_t sample = { .value = sensor_val,
+                               .timestamp_us = timestamp_us };
+
+  love_o_meter_format_report (buffer, sizeof (buffer), &sample, sensor_val);
+}
@@ -0,0 +1,25 @@
+/*
+ *  Runtime PWM configuration, as `pwm_configure_for` does it. Timer/Counter1
+ *  is the cycle counter, so Timer/Counter0 and 2 stand in for it.
+ */
+#include "bench.h"
+#include "pwm/pwm_hal.h"
+
+#define INIT_CALLS (16)
+
+int
+main (void)
+{
+  bench_init ("pwm");
+
+  BENCH_RUN ("pwm_init_timer0", (INIT_CALLS),
+             pwm_init (TCNTRS_0, WGM_MODE_3, COM_CLEAR, false, false,
+                       CS_PRESCALE_BY_64));
+  BENCH_RUN ("pwm_init_timer2", (INIT_CALLS),
+             pwm_init (TCNTRS_2, WGM_MODE_3, COM_CLEAR, false, false,
+                       CS_PRESCALE_BY_64));
+  BENCH_RUN ("pwm_set_compare", (INIT_CALLS),
+             pwm_set_compare (TCNTRS_2, PWMC_A, 128));
+
+  bench_done ();
+}
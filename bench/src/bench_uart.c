@@ -0,0 +1,29 @@
+/*
+ *  UART transmit paths, per byte. Sending blocks on the previous byte, so
+ *  these are bounded by the wire at `BENCH_BAUD_RATE`.
+ */
+#include "bench.h"
+#include "uart_hal.h"
+
+#define BYTE_CALLS (32)
+#define STRING_CALLS (4)
+
+/* As long as a typical report line; the terminating NUL is sent too. */
+static const char LINE[]
+    = "Raw sensor values - red: 512 green: 512 blue: 512\r\n";
+
+int
+main (void)
+{
+  bench_init ("uart");
+
+  BENCH_RUN ("uart_send_byte", (BYTE_CALLS), uart_send_byte ('\0'));
+
+  const uint32_t start = bench_cycles ();
+  for (uint8_t i = 0; i < (STRING_CALLS); i++)
+    uart_send_string (LINE);
+  bench_report ("uart_send_string_per_byte", bench_cycles () - start,
+                (STRING_CALLS) * sizeof (LINE));
+
+  bench_done ();
+}
@@ -0,0 +1,83 @@
+# The shared HAL library. Every project's Makefile includes this after
+# setting its CC, CFLAGS, LDFLAGS, SIZE and HOST_* variables, then links
+# $(HAL_LIB) (or $(HOST_HAL_LIB) for `make host`).
+#
+# All of common/ goes into the library, compiled with the project's own
+# flags, since those pick what the profiler, latency tracking and so on
+# build in. The linker only takes the modules a project uses.
+#
+# A project may add its own modules which it only links when used, as
+# HAL_PROJECT_MODULES (paths under $(SRC_DIR), without the .c), e.g. those
+# defining interrupt vectors, which --gc-sections can't drop. A project's
+# `make format` covers those, but not common/; the top-level Makefile's
+# `make format` does.
+AR = avr-gcc-ar
+NM = avr-nm
+HOST_AR = gcc-ar
+
+HAL_MODULES = adc analog_comparator config_store input latency \
+              led_pattern memory_monitor metrics power profiler scheduler \
+              timebase uart_hal watchdog
+HAL_PROJECT_SRC = $(HAL_PROJECT_MODULES:%=$(SRC_DIR)/%.c)
+HAL_SRC = $(HAL_MODULES:%=$(COMMON_DIR)/src/%.c) $(HAL_PROJECT_SRC)
+# A project's own headers come first; the profiler needs its regions.
+HAL_INCLUDES = $(if $(INCL_DIR),-I$(INCL_DIR)/) -I$(COMMON_DIR)/include/
+
+HAL_BUILD_DIR = hal
+HAL_OBJ = $(HAL_MODULES:%=$(HAL_BUILD_DIR)/%.o) \
+          $(HAL_PROJECT_MODULES:%=$(HAL_BUILD_DIR)/%.o)
+HAL_LIB = libhal.a
+HOST_HAL_BUILD_DIR = $(HAL_BUILD_DIR)/host
+HOST_HAL_OBJ = $(HAL_MODULES:%=$(HOST_HAL_BUILD_DIR)/%.o) \
+               $(HAL_PROJECT_MODULES:%=$(HOST_HAL_BUILD_DIR)/%.o)
+HOST_HAL_LIB = libhal_host.a
+
+# Each function and variable gets its own section, so unused ones are
+# dropped at link time.
+CFLAGS += -ffunction-sections -fdata-sections
+LDFLAGS += -Wl,--gc-sections
+# `make RELEASE=1` compiles out debug-only error messages (NDEBUG), though
+# not the argument checks themselves, and optimizes for size across the
+# whole image at link time, so small HAL functions are inlined into the
+# projects' hot paths. The objects carry compiled code as well as LTO
+# bytecode, or `make memory` would size every module at zero.
+ifdef RELEASE
+CFLAGS += -DNDEBUG -Os -flto -ffat-lto-objects
+LDFLAGS += -Os -flto
+endif
+
+# How many of the largest functions and variables `make report` lists.
+REPORT_SYMBOLS = 20
+
+$(HAL_LIB): $(HAL_OBJ)
+	$(AR) rcs $@ $^
+
+$(HAL_BUILD_DIR)/%.o: $(COMMON_DIR)/src/%.c
+	@mkdir -p $(HAL_BUILD_DIR)
+	$(CC) -c $(CFLAGS) $(HAL_INCLUDES) -o $@ $<
+
+$(HAL_BUILD_DIR)/%.o: $(SRC_DIR)/%.c
+	@mkdir -p $(@D)
+	$(CC) -c $(CFLAGS) $(HAL_INCLUDES) -o $@ $<
+
+$(HOST_HAL_LIB): $(HOST_HAL_OBJ)
+	$(HOST_AR) rcs $@ $^
+
+$(HOST_HAL_BUILD_DIR)/%.o: $(COMMON_DIR)/src/%.c
+	@mkdir -p $(HOST_HAL_BUILD_DIR)
+	$(HOST_CC) -c $(HOST_CFLAGS) $(HAL_INCLUDES) -o $@ $<
+
+$(HOST_HAL_BUILD_DIR)/%.o: $(SRC_DIR)/%.c
+	@mkdir -p $(@D)
+	$(HOST_CC) -c $(HOST_CFLAGS) $(HAL_INCLUDES) -o $@ $<
+
+# Flash and RAM use, then the largest functions and variables. Cycle counts
+# for the HAL hot paths come from bench/ (`make bench RELEASE=1`).
+report: $(HEX)
+	$(SIZE) -C --mcu=$(MCU) $(BIN)
+	$(NM) --size-sort -r -S $(BIN) | head -n $(REPORT_SYMBOLS)
+
+hal-clean:
+	rm -rf $(HAL_BUILD_DIR) $(HAL_LIB) $(HOST_HAL_LIB)
+
+.PHONY: report hal-clean
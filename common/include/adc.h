@@ -4,9 +4,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-/* Forward declarations. */
-struct AnalogInput_s;
-
 typedef enum ADCInitResult_e
 {
   ADC_INIT_SUCCESS,
@@ -49,10 +46,31 @@ typedef enum ADCPrescalerDivisor_e
   ADCP_BY_128,
 } ADCPrescalerDivisor_t;
 
+/* A conversion result and when it was taken. */
+typedef struct ADCSample_s
+{
+  uint16_t value;
+  uint32_t timestamp_us; // `time_now_us` when the conversion was started
+} ADCSample_t;
+
 ADCInitResult_t adc_init (ADCRefVoltage_t ref_voltage, bool right_adjusted,
                           ADCChannel_t channel,
                           ADCPrescalerDivisor_t prescaler);
-ADCInitResult_t adc_init_with_analog_input (struct AnalogInput_s *ai);
 uint16_t adc_start (bool right_adjusted);
 
+/*
+ *  As `adc_start`, but also records the time. The input is held 1.5 ADC clock
+ *  cycles after the timestamp (12 us at clk/128), see: pg. 208, ATmega328P
+ *  data sheet.
+ *  @param  right_adjusted  as for `adc_start`
+ *  @param  sample          where the result and its timestamp are stored
+ */
+void adc_sample (bool right_adjusted, ADCSample_t *sample);
+
+/*
+ *  Disables the ADC and lets the power manager shut it down. The
+ *  configuration is kept, and the next `adc_start` powers it back up.
+ */
+void adc_shutdown (void);
+
 #endif /* _ANALOG_TO_DIGITAL_CONVERTER_HAL_H_ */
@@ -0,0 +1,94 @@
+/*
+ *  Analog Comparator
+ *  Compares a sensor against a reference in hardware, raising an event
+ *  within a couple of clock cycles of a crossing instead of waiting for the
+ *  next ADC poll. The comparator only says which side of the reference the
+ *  input is on; take an ADC reading after an event to quantify it.
+ *
+ *  The positive input is AIN0 (PD6) or the internal 1.1 V bandgap. The
+ *  negative input is AIN1 (PD7), or any of ADC0-7 through the ADC
+ *  multiplexer. Using the multiplexer keeps the ADC powered (but disabled),
+ *  and it is lost while the ADC is enabled, so bracket conversions with
+ *  `acmp_suspend`/`acmp_resume`.
+ *
+ *  The comparator interrupt only wakes the CPU from idle sleep.
+ *  see: Section 23, ATmega328P data sheet.
+ */
+#ifndef _ANALOG_COMPARATOR_H_
+#define _ANALOG_COMPARATOR_H_
+
+#include "scheduler.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum AComparatorPositive_e
+{
+  ACMP_POS_AIN0,
+  ACMP_POS_BANDGAP, // Internal 1.1 V reference
+} AComparatorPositive_t;
+
+/* ADC0-7 match the MUX2:0 encodings. */
+typedef enum AComparatorNegative_e
+{
+  ACMP_NEG_ADC0,
+  ACMP_NEG_ADC1,
+  ACMP_NEG_ADC2,
+  ACMP_NEG_ADC3,
+  ACMP_NEG_ADC4,
+  ACMP_NEG_ADC5,
+  ACMP_NEG_ADC6,
+  ACMP_NEG_ADC7,
+  ACMP_NEG_AIN1,
+} AComparatorNegative_t;
+
+/*
+ *  Output transitions which raise an event; the values are the ACIS1:0
+ *  encodings. The output is high while positive > negative.
+ */
+typedef enum AComparatorEdge_e
+{
+  ACMP_ON_TOGGLE = 0x0,
+  ACMP_ON_FALLING = 0x2,
+  ACMP_ON_RISING = 0x3,
+} AComparatorEdge_t;
+
+/*
+ *  Powers up the comparator and enables its interrupt. AIN0/AIN1 are made
+ *  inputs, without pull-ups or digital input buffers, when selected; an ADC
+ *  channel is left to the caller, as for the ADC itself.
+ *  @param  pos       the positive (reference) input
+ *  @param  neg       the negative input
+ *  @param  edge      which output transitions raise an event
+ *  @param  listener  task rescheduled to run immediately on each event, or -1
+ *  @return 0 on success, -1 on an invalid argument.
+ */
+int8_t acmp_init (AComparatorPositive_t pos, AComparatorNegative_t neg,
+                  AComparatorEdge_t edge, TaskId_t listener);
+
+/* Disables the interrupt and turns the comparator off. */
+void acmp_shutdown (void);
+
+/*
+ *  Masks the interrupt and hands the ADC multiplexer back to the ADC. Call
+ *  before enabling the ADC when the negative input is an ADC channel.
+ */
+void acmp_suspend (void);
+
+/*
+ *  Undoes `acmp_suspend`, once the ADC has been disabled again. Any event
+ *  flagged in between is discarded, as it may have come from the ADC's use
+ *  of the multiplexer.
+ */
+void acmp_resume (void);
+
+/* @return true while the positive input is above the negative input. */
+bool acmp_output (void);
+
+/* @return the number of events since `acmp_init`. */
+uint32_t acmp_events (void);
+
+/* @return `time_now_us` at the most recent event. */
+uint32_t acmp_last_event_us (void);
+
+#endif /* _ANALOG_COMPARATOR_H_ */
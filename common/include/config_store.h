@@ -0,0 +1,84 @@
+/*
+ *  Configuration Store
+ *  Keeps a project's settings in EEPROM, so they can be changed at run time
+ *  and survive a reset. The settings are a plain struct owned by the
+ *  project: `cfg_load` fills it once at boot, and from then on it is read
+ *  directly, at no cost. After changing it, call `cfg_mark_dirty`; it is
+ *  written back once it has gone `CFG_SETTLE_MS` without further changes,
+ *  so a burst of changes costs one write, and no sooner than
+ *  `CFG_MIN_WRITE_INTERVAL_MS` after the last write.
+ *
+ *  Two copies are kept, each behind a header with a magic number, the
+ *  struct's layout version and size, a generation count and a CRC-16 of the
+ *  lot. Writes alternate between the copies, newest generation wins at
+ *  load, and the header goes last, so a write cut short by a reset leaves
+ *  the older copy to fall back on. Each cell is rated for 100,000 writes
+ *  (pg. 1, ATmega328P data sheet); alternating halves the wear on each, and
+ *  only bytes which differ are programmed.
+ *
+ *  Programming a byte takes ~3.4 ms, so the write back never waits on it:
+ *  it starts one byte per run of its task, `CFG_WRITE_STEP_MS` apart, and
+ *  leaves the EEPROM to finish it while other tasks run. A full 64-byte
+ *  copy takes ~0.3 s that way, rather than blocking for as long.
+ *
+ *  Settings go back to the project's defaults when nothing valid is stored,
+ *  or when what is stored has a different version. Bump the version when
+ *  the struct changes.
+ */
+#ifndef _CONFIG_STORE_H_
+#define _CONFIG_STORE_H_
+
+#include <stdint.h>
+
+/* The copies are kept from this EEPROM address up. */
+#define CFG_EEPROM_BASE (0)
+#define CFG_MAX_SIZE (64)
+
+#define CFG_SETTLE_MS (2000)
+#define CFG_MIN_WRITE_INTERVAL_MS (60000)
+#define CFG_WRITE_STEP_MS (4) // > ~3.4 ms, a byte's programming time
+
+/*
+ *  Loads the settings, or the defaults if there are none, and adds the task
+ *  which writes them back. Call once, after `sched_init`.
+ *  @param  config    the settings struct, filled in either way
+ *  @param  size      sizeof the settings, up to `CFG_MAX_SIZE`
+ *  @param  version   the settings' layout version
+ *  @param  defaults  the default settings, in program memory
+ *  @return 0 if stored settings were loaded, 1 if the defaults were, -1 on
+ *          an invalid size or a full task table.
+ */
+int8_t cfg_load (void *config, uint8_t size, uint8_t version,
+                 const void *defaults);
+
+/* Schedules the settings to be written back; see above. */
+void cfg_mark_dirty (void);
+
+/*
+ *  Writes the settings back now, if they've changed, regardless of
+ *  `CFG_MIN_WRITE_INTERVAL_MS`; e.g. before a planned reset. Finishes any
+ *  write back in progress first. Unlike the write back, this blocks, for
+ *  ~3.4 ms per byte programmed.
+ */
+void cfg_flush (void);
+
+/* Overwrites the settings with the defaults, and marks them dirty. */
+void cfg_restore_defaults (void);
+
+/* @return how many times the settings have been written, ever. */
+uint16_t cfg_generation (void);
+
+/*
+ *  Handles a one-byte serial command: 'k' prints a line
+ *
+ *    cfg,<version>,<generation>,<pending>
+ *
+ *  (pending is 1 while a change is waiting to be written), and 'w' writes
+ *  any change now (see: `cfg_flush`). Anything else is ignored.
+ *  @param  cmd    the byte received
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ *  @return 0 if `cmd` was a config store command, -1 if not.
+ */
+int8_t cfg_command (uint8_t cmd, void (*write) (const char *));
+
+#endif /* _CONFIG_STORE_H_ */
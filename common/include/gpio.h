@@ -0,0 +1,104 @@
+/*
+ *  Compile-Time GPIO
+ *  A pin is a `port, bit` pair of constants, e.g. `#define GREEN_LED D, 3`.
+ *  The single pin operations expand to a constant bit set/clear on an I/O
+ *  register, which avr-gcc emits as one `sbi`/`cbi` (or `out` for toggles),
+ *  so they are atomic and need no interrupt masking. Pins which aren't
+ *  constants, or bits out of range, fail to compile.
+ *
+ *  Groups are masks of pins on one port (`GPIO_GROUP_MASK`), updated with a
+ *  single store by `gpio_write_group`.
+ */
+#ifndef _GPIO_H_
+#define _GPIO_H_
+
+#include <avr/io.h>
+#include <stdint.h>
+#include <util/atomic.h>
+
+#define GPIO_PORT_ID_B (0)
+#define GPIO_PORT_ID_C (1)
+#define GPIO_PORT_ID_D (2)
+
+/*
+ *  The pin macros are variadic, with an extra level of expansion, so that a
+ *  pin macro passed in splits into its port and bit arguments.
+ */
+#define GPIO_DDR(...) GPIO_DDR_ (__VA_ARGS__)
+#define GPIO_DDR_(port, bit) (DDR##port)
+#define GPIO_OUT(...) GPIO_OUT_ (__VA_ARGS__)
+#define GPIO_OUT_(port, bit) (PORT##port)
+#define GPIO_IN(...) GPIO_IN_ (__VA_ARGS__)
+#define GPIO_IN_(port, bit) (PIN##port)
+#define GPIO_BIT(...) GPIO_BIT_ (__VA_ARGS__)
+#define GPIO_BIT_(port, bit) (bit)
+#define GPIO_PORT_ID(...) GPIO_PORT_ID_ (__VA_ARGS__)
+#define GPIO_PORT_ID_(port, bit) (GPIO_PORT_ID_##port)
+
+#define GPIO_MASK(...) (1 << GPIO_BIT (__VA_ARGS__))
+
+#define GPIO_PIN_OP_(reg, bit, op)                                            \
+  do                                                                          \
+    {                                                                         \
+      __extension__ _Static_assert ((bit) >= 0 && (bit) < 8,                  \
+                                    "GPIO bits must be constants from 0-7");  \
+      reg op (1 << (bit));                                                    \
+    }                                                                         \
+  while (0)
+
+/* Single pins: one instruction each. */
+#define GPIO_MAKE_OUTPUT(...) GPIO_MAKE_OUTPUT_ (__VA_ARGS__)
+#define GPIO_MAKE_OUTPUT_(port, bit) GPIO_PIN_OP_ (DDR##port, bit, |=)
+#define GPIO_MAKE_INPUT(...) GPIO_MAKE_INPUT_ (__VA_ARGS__)
+#define GPIO_MAKE_INPUT_(port, bit) GPIO_PIN_OP_ (DDR##port, bit, &= ~)
+#define GPIO_SET(...) GPIO_SET_ (__VA_ARGS__)
+#define GPIO_SET_(port, bit) GPIO_PIN_OP_ (PORT##port, bit, |=)
+#define GPIO_CLEAR(...) GPIO_CLEAR_ (__VA_ARGS__)
+#define GPIO_CLEAR_(port, bit) GPIO_PIN_OP_ (PORT##port, bit, &= ~)
+
+/* Writing a one to PINxn toggles PORTxn (pg. 85, ATmega328P data sheet). */
+#define GPIO_TOGGLE(...) GPIO_TOGGLE_ (__VA_ARGS__)
+#define GPIO_TOGGLE_(port, bit) GPIO_PIN_OP_ (PIN##port, bit, =)
+
+/* An input's pull-up is its PORTxn bit. */
+#define GPIO_ENABLE_PULLUP(...) GPIO_SET (__VA_ARGS__)
+
+#define GPIO_READ(...)                                                        \
+  ((GPIO_IN (__VA_ARGS__) & GPIO_MASK (__VA_ARGS__)) != 0)
+
+/*
+ *  Masks of several pins. Pins on different ports fail to compile (a
+ *  negative array size), as the mask would be meaningless.
+ */
+#define GPIO_CHECK_SAME_PORT_(port_id_a, port_id_b)                           \
+  (0 * sizeof (char[(port_id_a) == (port_id_b) ? 1 : -1]))
+#define GPIO_GROUP_MASK(pin_a, pin_b)                                         \
+  ((uint8_t)(GPIO_MASK (pin_a) | GPIO_MASK (pin_b)                            \
+             | GPIO_CHECK_SAME_PORT_ (GPIO_PORT_ID (pin_a),                   \
+                                      GPIO_PORT_ID (pin_b))))
+#define GPIO_GROUP_MASK3(pin_a, pin_b, pin_c)                                 \
+  ((uint8_t)(GPIO_MASK (pin_a) | GPIO_MASK (pin_b) | GPIO_MASK (pin_c)        \
+             | GPIO_CHECK_SAME_PORT_ (GPIO_PORT_ID (pin_a),                   \
+                                      GPIO_PORT_ID (pin_b))                   \
+             | GPIO_CHECK_SAME_PORT_ (GPIO_PORT_ID (pin_a),                   \
+                                      GPIO_PORT_ID (pin_c))))
+
+/*
+ *  Sets the `mask` bits of a port register to those of `value`, leaving the
+ *  others alone, as one store. Interrupts are held off for the
+ *  read-modify-write so that an ISR touching the same port can't be undone.
+ *  Inlined, so constant arguments fold into a load, two ALU ops and a store.
+ *  @param  reg    the port register, e.g. `&GPIO_OUT (GREEN_LED)` or `&DDRD`
+ *  @param  mask   the bits to update
+ *  @param  value  their new values
+ */
+static inline void
+gpio_write_group (volatile uint8_t *reg, uint8_t mask, uint8_t value)
+{
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    *reg = (*reg & ~mask) | (value & mask);
+  }
+}
+
+#endif /* _GPIO_H_ */
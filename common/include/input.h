@@ -0,0 +1,84 @@
+/*
+ *  Debounced Button Input
+ *  Buttons on PD2/PD3 use INT0/INT1, and those on any other pin of ports B,
+ *  C and D use the pin change interrupts, so nothing is polled. The first
+ *  edge masks the pin's interrupt, and a scheduler task reads the settled
+ *  level `INPUT_DEBOUNCE_MS` later. Press, release, long-press and repeat
+ *  events are queued for a listener task.
+ *
+ *  Pin change interrupts can wake the CPU from any sleep mode; INT0/INT1
+ *  edges need the I/O clock, so only wake it from idle (see: pg. 70,
+ *  ATmega328P data sheet).
+ */
+#ifndef _INPUT_H_
+#define _INPUT_H_
+
+#include "scheduler.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define INPUT_MAX_BUTTONS (4)
+#define INPUT_DEBOUNCE_MS (20)
+#define INPUT_LONG_PRESS_MS (1000)
+#define INPUT_REPEAT_MS (250)
+#define INPUT_QUEUE_SIZE (8) // Must be a power of two
+
+typedef enum InputPort_e
+{
+  INP_PORT_B,
+  INP_PORT_C,
+  INP_PORT_D
+} InputPort_t;
+
+typedef enum InputEventType_e
+{
+  INPUT_PRESS,
+  INPUT_RELEASE,
+  INPUT_LONG_PRESS, // Held for `INPUT_LONG_PRESS_MS`
+  INPUT_REPEAT      // Still held, every `INPUT_REPEAT_MS` after a long press
+} InputEventType_t;
+
+/* Index of a button, or -1 when a button couldn't be added. */
+typedef int8_t ButtonId_t;
+
+typedef struct InputEvent_s
+{
+  ButtonId_t button;
+  InputEventType_t type;
+  uint32_t time_ms; // First edge for presses/releases, else detection time
+} InputEvent_t;
+
+/*
+ *  Sets up the debounce task. Must be called after `sched_init`, and before
+ *  any buttons are added.
+ *  @param  listener  task to run whenever events are queued, or -1
+ *  @return 0 on success, -1 if the task table is full.
+ */
+int8_t input_init (TaskId_t listener);
+
+/*
+ *  Configures a pin as a button input and enables its interrupt.
+ *  @param  port        the pin's port
+ *  @param  pin         the pin's bit number within the port
+ *  @param  active_low  if true, the pull-up is enabled and a low level
+ *                      means pressed (button to GND); otherwise an external
+ *                      pull-down is assumed (button to VCC)
+ *  @return the button's id, or -1 if the pin is invalid or the button table
+ *          is full.
+ */
+ButtonId_t input_add_button (InputPort_t port, uint8_t pin, bool active_low);
+
+/*
+ *  Takes the oldest queued event.
+ *  @return false if the queue was empty.
+ */
+bool input_get_event (InputEvent_t *event);
+
+/* @return whether button `b` is (after debouncing) held down. */
+bool input_is_pressed (ButtonId_t b);
+
+/* @return the number of events lost to a full queue. */
+uint16_t input_dropped_events (void);
+
+#endif /* _INPUT_H_ */
@@ -0,0 +1,89 @@
+/*
+ *  Latency Histograms
+ *  Log-scaled histograms of durations in microseconds, cheap enough to fill
+ *  on every run of a task: bucket 0 counts zeros and bucket b the durations
+ *  in [2^(b-1), 2^b), with the last bucket open-ended. Percentiles are read
+ *  back as the upper edge of the bucket they fall in (so to within a factor
+ *  of two, and never above the exact maximum, which is kept alongside).
+ *
+ *  Everything here compiles out unless LATENCY_TRACKING is defined (`make
+ *  LATENCY=1`), and always in release (NDEBUG) builds. With it, the
+ *  scheduler can fill a pair of histograms per task (see:
+ *  `sched_track_latency`), and those added to the report are printed
+ *  periodically.
+ */
+#ifndef _LATENCY_H_
+#define _LATENCY_H_
+
+#include <stdint.h>
+
+#if defined(LATENCY_TRACKING) && !defined(NDEBUG)
+#define LAT_ENABLED (1)
+#else
+#define LAT_ENABLED (0)
+#endif /* LATENCY_TRACKING */
+
+#if LAT_ENABLED
+
+/* Covers up to ~262 ms exactly; longer durations share the last bucket. */
+#define LAT_BUCKET_COUNT (20)
+
+/* Histograms the periodic report can hold (see: `lat_add_to_report`). */
+#define LAT_MAX_REPORTED (4)
+
+typedef struct LatencyHistogram_s
+{
+  uint16_t buckets[(LAT_BUCKET_COUNT)]; // Saturate rather than wrap
+  uint16_t count;
+  uint32_t max_us;
+} LatencyHistogram_t;
+
+/* Adds one duration to `h`. */
+void lat_record (LatencyHistogram_t *h, uint32_t us);
+
+/* Empties `h`. */
+void lat_reset (LatencyHistogram_t *h);
+
+/*
+ *  @param  percent  1-100
+ *  @return an upper bound on the `percent`th percentile of `h`, in
+ *          microseconds, or 0 if `h` is empty.
+ */
+uint32_t lat_percentile (const LatencyHistogram_t *h, uint8_t percent);
+
+/*
+ *  Prints `h` as one line, in microseconds:
+ *
+ *    lat,<name>,<count>,<p50>,<p99>,<max>
+ *
+ *  @param  name   what `h` measures
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ */
+void lat_report (const LatencyHistogram_t *h, const char *name,
+                 void (*write) (const char *));
+
+/*
+ *  Adds `h` to those `lat_report_all` prints.
+ *  @param  name  what `h` measures, as `lat_report` prints it
+ *  @return 0 on success, -1 if `LAT_MAX_REPORTED` already have been.
+ */
+int8_t lat_add_to_report (LatencyHistogram_t *h, const char *name);
+
+/*
+ *  Prints each histogram added with `lat_add_to_report`, a `lat_report`
+ *  line each, then empties it, so every report covers the time since the
+ *  last.
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ */
+void lat_report_all (void (*write) (const char *));
+
+/*
+ *  Runs `lat_report_all` from a scheduler task every `period_ms`. Later
+ *  calls only change `write`.
+ *  @return 0 on success, -1 if the task table is full.
+ */
+int8_t lat_start_reports (uint16_t period_ms, void (*write) (const char *));
+
+#endif /* LAT_ENABLED */
+
+#endif /* _LATENCY_H_ */
@@ -0,0 +1,63 @@
+/*
+ *  LED Pattern Sequencer
+ *  Plays patterns, tables of (value, duration) steps kept in flash, on groups
+ *  of pins of one port. Each step is a single masked write of the whole group,
+ *  and steps are timed by a scheduler task, so starting or stopping a pattern
+ *  takes effect immediately instead of when a blocking loop gets round to it.
+ */
+#ifndef _LED_PATTERN_H_
+#define _LED_PATTERN_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LED_PATTERN_MAX_PLAYERS (2)
+
+/* A step duration which holds the step until the pattern is changed. */
+#define LED_PATTERN_HOLD (0)
+
+#define LED_PATTERN_LENGTH(steps) (sizeof (steps) / sizeof ((steps)[0]))
+
+typedef struct LedPatternStep_s
+{
+  uint8_t value;        // Port bits to output; only the player's mask is used
+  uint16_t duration_ms; // Or `LED_PATTERN_HOLD`
+} LedPatternStep_t;
+
+/* Index of a player, or -1 when a player couldn't be added. */
+typedef int8_t LedPlayerId_t;
+
+/*
+ *  Sets up the sequencer task. Must be called after `sched_init`.
+ *  @return 0 on success, -1 if the task table is full.
+ */
+int8_t led_pattern_init (void);
+
+/*
+ *  Adds a player driving the `mask` bits of `port`, and outputs `idle_value`
+ *  on them. The pins must already be configured as outputs.
+ *  @param  port        the port's data register, e.g. `&PORTD`
+ *  @param  mask        the bits of `port` the player owns
+ *  @param  idle_value  output while no pattern is playing
+ *  @return the player's id, or -1 if the player table is full.
+ */
+LedPlayerId_t led_pattern_add_player (volatile uint8_t *port, uint8_t mask,
+                                      uint8_t idle_value);
+
+/*
+ *  Starts a pattern, replacing any which is playing. The first step is output
+ *  before this returns.
+ *  @param  steps       the pattern, in flash (`PROGMEM`)
+ *  @param  step_count  the number of steps
+ *  @param  repeat      whether to loop; otherwise the last step is held
+ */
+void led_pattern_play (LedPlayerId_t p, const LedPatternStep_t *steps,
+                       uint8_t step_count, bool repeat);
+
+/* Stops the pattern and outputs the player's idle value immediately. */
+void led_pattern_stop (LedPlayerId_t p);
+
+/* @return whether a pattern is playing (or holding its last step). */
+bool led_pattern_is_playing (LedPlayerId_t p);
+
+#endif /* _LED_PATTERN_H_ */
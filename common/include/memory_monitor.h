@@ -0,0 +1,63 @@
+/*
+ *  Memory Monitor
+ *  Tracks how close the stack comes to the statically allocated RAM (.data
+ *  and .bss) below it. At boot, before `main`, every free byte between the
+ *  end of .bss and the top of RAM is painted with `MEM_PAINT_BYTE`, except
+ *  the lowest two, which hold a canary. The deepest the stack has been is
+ *  then the lowest byte no longer painted, and a stack which has run into
+ *  .bss has crushed the canary on the way.
+ *
+ *  No heap is assumed (nothing here calls malloc). On the host backend there
+ *  is no AVR memory map, so the figures all read 0 and the canary is always
+ *  intact.
+ */
+#ifndef _MEMORY_MONITOR_H_
+#define _MEMORY_MONITOR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MEM_PAINT_BYTE (0xC5)
+#define MEM_CANARY (0xA55A)
+
+/* @return bytes of RAM taken by .data and .bss together. */
+uint16_t mem_static_bytes (void);
+
+/*
+ *  Scans up from the canary for the first byte the stack has written, so
+ *  takes time proportional to the headroom (~5 cycles a byte).
+ *  @return the most stack used since boot, in bytes.
+ */
+uint16_t mem_stack_peak (void);
+
+/* @return bytes the stack has never reached; see `mem_stack_peak`. */
+uint16_t mem_stack_headroom (void);
+
+/* @return bytes currently free between the canary and the stack pointer. */
+uint16_t mem_free_now (void);
+
+/*
+ *  Constant time, so cheap enough to call from a frequent task.
+ *  @return whether the canary below the stack is still intact.
+ */
+bool mem_canary_intact (void);
+
+/*
+ *  Prints the figures above as one line, in bytes:
+ *
+ *    mem,<static>,<stack peak>,<headroom>,<free now>,<canary ok|smashed>
+ *
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ */
+void mem_report (void (*write) (const char *));
+
+/*
+ *  Handles a one-byte serial command: 's' reports (see: `mem_report`).
+ *  Anything else is ignored.
+ *  @param  cmd    the byte received
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ *  @return 0 if `cmd` was a memory command, -1 if not.
+ */
+int8_t mem_command (uint8_t cmd, void (*write) (const char *));
+
+#endif /* _MEMORY_MONITOR_H_ */
@@ -0,0 +1,65 @@
+/*
+ *  Runtime Metrics
+ *  Event counters bumped by the HALs as they work, always built in: each
+ *  counter is its own statically allocated variable, so `METRIC_INC` is a
+ *  load, add and store at a fixed address. Counters wrap.
+ *
+ *  An increment isn't atomic, so each counter is bumped from one context
+ *  only: main code or a single ISR. Reads (`metrics_get`, `metrics_dump`)
+ *  are atomic.
+ */
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdint.h>
+
+/* X (name, counter type), in dump order. */
+#define METRICS_COUNTERS(X)                                                   \
+  X (adc_conversions, uint32_t)                                               \
+  X (adc_channel_switches, uint16_t)                                          \
+  X (uart_tx_bytes, uint32_t)                                                 \
+  X (uart_rx_bytes, uint32_t)                                                 \
+  X (uart_rx_overruns, uint16_t)                                              \
+  X (pwm_reconfigs, uint16_t)
+
+#define METRIC_ID_(name, type) METRIC_##name,
+#define METRIC_DECLARE_(name, type) extern type metric_##name;
+
+typedef enum Metric_e
+{
+  METRICS_COUNTERS (METRIC_ID_) METRIC_COUNT
+} Metric_t;
+
+METRICS_COUNTERS (METRIC_DECLARE_)
+
+/* Counts one event; `name` is the bare counter name, e.g. `uart_rx_bytes`. */
+#define METRIC_INC(name) ((void)metric_##name++)
+
+/*
+ *  Reads a counter.
+ *  @return its value, or 0 if `id` is out of range.
+ */
+uint32_t metrics_get (Metric_t id);
+
+/* Zeroes every counter. */
+void metrics_reset (void);
+
+/*
+ *  Prints one line per counter:
+ *
+ *    metric,<name>,<value>
+ *
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ */
+void metrics_dump (void (*write) (const char *));
+
+/*
+ *  Handles a one-byte serial command: 'm' dumps (see: `metrics_dump`), 'c'
+ *  clears. Anything else is ignored.
+ *  @param  cmd    the byte received
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ *  @return 0 if `cmd` was a metrics command, -1 if not.
+ */
+int8_t metrics_command (uint8_t cmd, void (*write) (const char *));
+
+#endif /* _METRICS_H_ */
@@ -0,0 +1,91 @@
+/*
+ *  Power Manager
+ *  Reference counts the users of each peripheral so that its Power Reduction
+ *  Register bit is only cleared while something needs it, and puts the CPU to
+ *  sleep in the deepest mode which keeps every peripheral in use running.
+ */
+#ifndef _POWER_H_
+#define _POWER_H_
+
+#include <stdint.h>
+
+typedef enum PowerPeripheral_e
+{
+  PWR_ADC,
+  PWR_USART0,
+  PWR_SPI,
+  PWR_TIM0,
+  PWR_TIM1,
+  PWR_TIM2,
+  PWR_TWI,
+  PWR_PERIPHERAL_COUNT
+} PowerPeripheral_t;
+
+/* Ordered from shallowest to deepest. */
+typedef enum PowerMode_e
+{
+  PWR_MODE_ACTIVE,
+  PWR_MODE_IDLE,
+  PWR_MODE_ADC_NOISE_REDUCTION,
+  PWR_MODE_POWER_SAVE,
+  PWR_MODE_POWER_DOWN,
+  PWR_MODE_COUNT
+} PowerMode_t;
+
+typedef struct PowerModeStats_s
+{
+  uint32_t entries;      // Times the mode was entered (0 for active)
+  uint32_t residency_ms; // Time spent in the mode
+  uint16_t typical_ua;   // Estimated MCU supply current in the mode
+} PowerModeStats_t;
+
+/*
+ *  Shuts down every peripheral which has no users. Peripherals are powered
+ *  out of reset, so call this once everything has been initialized.
+ */
+void pwr_init (void);
+
+/*
+ *  Registers a user of `p`, powering it up if it was the first.
+ *  @return 0 on success, -1 if `p` is invalid or has too many users.
+ */
+int8_t pwr_acquire (PowerPeripheral_t p);
+
+/*
+ *  Drops a user of `p`, shutting it down if it was the last. The caller must
+ *  leave the peripheral in a state fit for shutdown first (e.g. the ADC must
+ *  be disabled, see: pg. 40, ATmega328P data sheet).
+ *  @return 0 on success, -1 if `p` is invalid or had no users.
+ */
+int8_t pwr_release (PowerPeripheral_t p);
+
+/* @return the number of users of `p`. */
+uint8_t pwr_users (PowerPeripheral_t p);
+
+/* @return the deepest sleep mode the peripherals in use allow. */
+PowerMode_t pwr_sleep_mode (void);
+
+/*
+ *  Sleeps in `pwr_sleep_mode` until the next interrupt. Interrupts must be
+ *  enabled, or this never returns.
+ */
+void pwr_sleep (void);
+
+/*
+ *  Credits time to a sleep mode. Residency is measured with the timebase,
+ *  which stops in every mode deeper than idle (Timer/Counter0 can only be
+ *  shut down once it has no users); whoever arranges the wake-up in those
+ *  modes (e.g. the watchdog) knows how long was slept and reports it here.
+ */
+void pwr_add_residency (PowerMode_t mode, uint32_t ms);
+
+/*
+ *  Reports the time spent in, and the estimated current draw of, each mode.
+ *  @param  stats  array of `PWR_MODE_COUNT` entries, indexed by `PowerMode_t`
+ */
+void pwr_get_stats (PowerModeStats_t *stats);
+
+/* @return the residency-weighted average of the per-mode current estimates. */
+uint32_t pwr_estimated_average_ua (void);
+
+#endif /* _POWER_H_ */
@@ -0,0 +1,116 @@
+/*
+ *  Cycle Profiler
+ *  Shows where loop time goes on the board. Code is bracketed with
+ *  `PROF_BEGIN (id)` and `PROF_END (id)`; each region keeps its call count
+ *  and min/average/max CPU cycles in a static table, and with
+ *  `PROF_TRACE_SIZE` set, the most recent begin/end events are kept in a
+ *  circular trace. `prof_dump` prints both.
+ *
+ *  Regions are named by the project, in its own "prof_regions.h":
+ *
+ *    #define PROF_REGIONS(X) X (PROF_SAMPLE, "sample") X (PROF_REPORT, ...)
+ *
+ *  Everything here compiles out unless PROFILING is defined (`make
+ *  PROFILE=1`), and always in release (NDEBUG) builds.
+ *
+ *  Cycles are read from the timebase, in steps of `TIME_US_PER_COUNT` (64
+ *  cycles at 16 MHz), unless PROF_CLOCK_TIMER1 is defined, in which case the
+ *  profiler takes Timer/Counter1 over at clk/1 and counts exactly. A
+ *  project which drives Timer/Counter1 itself defines PROF_TIMER1_IN_USE in
+ *  its "prof_regions.h", which makes PROF_CLOCK_TIMER1 a build error. On
+ *  the timebase, a region shorter than a step reads as 0 or one step, so
+ *  only averages over many calls mean much; the dump starts with the step.
+ *  Regions of the same id can't nest, and markers are for the main context
+ *  only (not ISRs). Counting exactly, the cost of the markers themselves is
+ *  measured once and taken off; on the timebase it's under a step and isn't.
+ */
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <stdint.h>
+
+#if defined(PROFILING) && !defined(NDEBUG)
+#define PROF_ENABLED (1)
+#else
+#define PROF_ENABLED (0)
+#endif /* PROFILING */
+
+#if PROF_ENABLED
+
+#include "prof_regions.h"
+
+#if defined(PROF_CLOCK_TIMER1) && defined(PROF_TIMER1_IN_USE)
+#error "PROF_CLOCK_TIMER1 needs Timer/Counter1, which this project drives"
+#endif /* PROF_CLOCK_TIMER1 */
+
+/* Events kept in the trace; 0 for none, else a power of two up to 128. */
+#ifndef PROF_TRACE_SIZE
+#define PROF_TRACE_SIZE (32)
+#endif /* PROF_TRACE_SIZE */
+
+#define PROF_REGION_ENUM_(id, name) id,
+
+typedef enum ProfRegion_e
+{
+  PROF_REGIONS (PROF_REGION_ENUM_) PROF_REGION_COUNT
+} ProfRegion_t;
+
+typedef struct ProfStats_s
+{
+  uint32_t calls;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+} ProfStats_t;
+
+#define PROF_BEGIN(id) prof_begin (id)
+#define PROF_END(id) prof_end (id)
+
+/*
+ *  Starts the cycle clock and measures the markers' own cost. With the
+ *  timebase as the clock, call after `time_init`.
+ */
+void prof_init (void);
+
+/* Use `PROF_BEGIN`/`PROF_END` rather than these. */
+void prof_begin (ProfRegion_t id);
+void prof_end (ProfRegion_t id);
+
+/*
+ *  Copies a region's statistics.
+ *  @return 0 on success, -1 if `id` is out of range.
+ */
+int8_t prof_stats (ProfRegion_t id, ProfStats_t *stats);
+
+/* Zeroes the statistics and empties the trace. */
+void prof_reset (void);
+
+/*
+ *  Prints the clock's resolution, one line per region, then the trace,
+ *  oldest first:
+ *
+ *    prof_clock,<cycles per step>
+ *    prof,<region>,<calls>,<min>,<avg>,<max>
+ *    trace,<cycle stamp>,<region>,<begin|end>
+ *
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ */
+void prof_dump (void (*write) (const char *));
+
+/*
+ *  Handles a one-byte serial command: 'p' dumps (see: `prof_dump`), 'r'
+ *  resets. Anything else is ignored.
+ *  @param  cmd    the byte received
+ *  @param  write  prints a string, e.g. `uart_send_string`
+ *  @return 0 if `cmd` was a profiler command, -1 if not.
+ */
+int8_t prof_command (uint8_t cmd, void (*write) (const char *));
+
+#else
+
+#define PROF_BEGIN(id) ((void)0)
+#define PROF_END(id) ((void)0)
+
+#endif /* PROF_ENABLED */
+
+#endif /* _PROFILER_H_ */
@@ -0,0 +1,94 @@
+/*
+ *  Cooperative Task Scheduler
+ *  A run-to-completion scheduler driven by the timebase's 1 ms tick. Tasks
+ *  are plain functions which are either periodic or one-shot; `sched_run`
+ *  dispatches them from the main loop and idles the CPU while none are due.
+ *  Tasks must return promptly, as nothing preempts them.
+ */
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "latency.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHED_MAX_TASKS (8)
+#define SCHED_NO_DEADLINE (0)
+
+typedef void (*TaskFunction_t) (void);
+
+/* Index into the task table, or -1 when a task couldn't be added. */
+typedef int8_t TaskId_t;
+
+/*
+ *  Starts the timebase (see: timebase.h). Interrupts have to be enabled
+ *  (`sei`) before the tick starts counting.
+ */
+void sched_init (void);
+
+/*
+ *  Adds a task.
+ *  @param  fn           the task function
+ *  @param  delay_ms     time until the first run
+ *  @param  period_ms    time between runs, or 0 for a one-shot task
+ *  @param  deadline_ms  how late a run may start before it is counted as a
+ *                       missed deadline, or `SCHED_NO_DEADLINE`
+ *  @return the task's id, or -1 if the task table is full.
+ */
+TaskId_t sched_add_task (TaskFunction_t fn, uint16_t delay_ms,
+                         uint16_t period_ms, uint16_t deadline_ms);
+
+/*
+ *  Removes a task. A task may remove itself.
+ *  @return 0 on success, -1 if `id` is not an active task.
+ */
+int8_t sched_remove_task (TaskId_t id);
+
+/*
+ *  Moves a task's next run to `delay_ms` from now, re-arming it if it was a
+ *  one-shot task which has already run. Unlike the rest of the API, this may
+ *  be called from an ISR, to hand work off to a task.
+ *  @return 0 on success, -1 if `id` is not a valid task.
+ */
+int8_t sched_reschedule (TaskId_t id, uint16_t delay_ms);
+
+/*
+ *  As `sched_reschedule`, but only ever brings a task's next run forward: a
+ *  run already due sooner than `delay_ms` from now is left alone. May also
+ *  be called from an ISR.
+ *  @return 0 on success, -1 if `id` is not a valid task.
+ */
+int8_t sched_reschedule_sooner (TaskId_t id, uint16_t delay_ms);
+
+/*
+ *  Changes the time between a task's runs, from its next run on; 0 makes it
+ *  a one-shot task.
+ *  @return 0 on success, -1 if `id` is not a valid task.
+ */
+int8_t sched_set_period (TaskId_t id, uint16_t period_ms);
+
+/* @return the number of runs of task `id` which started past its deadline. */
+uint16_t sched_missed_deadlines (TaskId_t id);
+
+/* @return the number of missed deadlines across all tasks. */
+uint16_t sched_total_missed_deadlines (void);
+
+#if LAT_ENABLED
+/*
+ *  Records each run of task `id` from now on: how late it started relative
+ *  to when it was due (its jitter), and how long it ran. Either histogram may
+ *  be NULL. Tracking stops when the task is removed.
+ *  @return 0 on success, -1 if `id` is not a valid task.
+ */
+int8_t sched_track_latency (TaskId_t id, LatencyHistogram_t *start_latency,
+                            LatencyHistogram_t *run_time);
+#endif /* LAT_ENABLED */
+
+/* @return milliseconds since `sched_init` (same clock as `time_now_ms`). */
+uint32_t sched_now_ms (void);
+
+/* Dispatches tasks forever, sleeping (see: `pwr_sleep`) when none are due. */
+void sched_run (void) __attribute__ ((noreturn));
+
+#endif /* _SCHEDULER_H_ */
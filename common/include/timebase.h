@@ -0,0 +1,32 @@
+/*
+ *  Monotonic Timebase
+ *  Timer/Counter0 counts at clk/64 (4 us per count at 16 MHz) and wraps every
+ *  millisecond in CTC mode; the compare match interrupt extends it to 32-bit
+ *  millisecond and microsecond clocks. Both wrap around (after ~49.7 days and
+ *  ~71.6 minutes respectively), so compare timestamps by subtraction.
+ */
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include <stdint.h>
+
+/* Resolution of `time_now_us`. */
+#define TIME_US_PER_COUNT (4)
+
+/*
+ *  Configures and starts Timer/Counter0. Interrupts have to be enabled (`sei`)
+ *  for the clocks to advance past the first millisecond.
+ */
+void time_init (void);
+
+/* @return milliseconds since `time_init`. */
+uint32_t time_now_ms (void);
+
+/*
+ *  Safe to call with interrupts disabled, including from an ISR, for as long
+ *  as the compare match interrupt isn't held off for more than 1 ms.
+ *  @return microseconds since `time_init`, in `TIME_US_PER_COUNT` steps.
+ */
+uint32_t time_now_us (void);
+
+#endif /* _TIMEBASE_H_ */
@@ -39,6 +39,18 @@ void uart_send_array (uint8_t *arr, uint16_t length);
  */
 void uart_send_string (const char *str);
 
+/* Blocks until every queued byte has been shifted out. */
+void uart_flush (void);
+
+/*
+ *  Flushes, then lets the power manager shut USART0 down; nothing can be
+ *  received until `uart_wake`. The configuration is kept.
+ */
+void uart_shutdown (void);
+
+/* Powers USART0 back up after `uart_shutdown`. */
+void uart_wake (void);
+
 /* @return the number of received bytes which have yet to be read. */
 uint16_t uart_read_count (void);
 
@@ -0,0 +1,52 @@
+/*
+ *  Watchdog Wake-up Timer
+ *  Runs the watchdog in interrupt mode (no system reset) as a wake-up source
+ *  which, unlike the timers, keeps going in power-down sleep. Periods come
+ *  from the 128 kHz watchdog oscillator, so are only accurate to about 10%.
+ *  `wdog_reset_system` is the one use of its system reset mode.
+ */
+#ifndef _WATCHDOG_H_
+#define _WATCHDOG_H_
+
+#include <stdint.h>
+
+/* Watchdog timeouts. The values are the WDP3:0 encodings (Table 10-3). */
+typedef enum WatchdogPeriod_e
+{
+  WDOG_16MS,
+  WDOG_32MS,
+  WDOG_64MS,
+  WDOG_125MS,
+  WDOG_250MS,
+  WDOG_500MS,
+  WDOG_1S,
+  WDOG_2S,
+  WDOG_4S,
+  WDOG_8S
+} WatchdogPeriod_t;
+
+/*
+ *  Starts the watchdog in interrupt mode. Each timeout raises the watchdog
+ *  interrupt, which wakes the CPU from any sleep mode.
+ *  @param  period  the time between interrupts
+ *  @return 0 on success, -1 if `period` is invalid.
+ */
+int8_t wdog_start (WatchdogPeriod_t period);
+
+/* Stops the watchdog. */
+void wdog_stop (void);
+
+/* @return the nominal length of `period` in milliseconds. */
+uint16_t wdog_period_ms (WatchdogPeriod_t period);
+
+/* @return the number of timeouts since `wdog_start`. */
+uint32_t wdog_timeouts (void);
+
+/*
+ *  Resets the MCU: switches the watchdog to system reset mode at its
+ *  shortest period and waits, with interrupts disabled, for it to fire.
+ *  For unrecoverable faults, where a clean restart beats running on.
+ */
+void wdog_reset_system (void) __attribute__ ((noreturn));
+
+#endif /* _WATCHDOG_H_ */
@@ -1,24 +1,30 @@
 #include "adc.h"
-#include "analog_input.h"
+#include "metrics.h"
+#include "power.h"
+#include "timebase.h"
 
 #include <avr/io.h>
 #include <stdint.h>
 
-#define POWER_REDUCTION_REGISTER (PRR)
-#define ADC_POWER_REDUCTION_BIT (PRADC)
-
 #define ADC_CTRL_STATUS_REGISTER_A (ADCSRA)
 #define ADC_ENABLE_BIT (ADEN)
 #define START_CONVERSION_BIT (ADSC)
+#define PRESCALER_SELECTION_MASK                                              \
+  ((1 << (ADPS2)) | (1 << (ADPS1)) | (1 << (ADPS0)))
 
 #define MULTIPLEXER_SELECTION_REGISTER (ADMUX)
 #define REF_SELECTION_BIT_0 (REFS0)
 #define REF_SELECTION_BIT_1 (REFS1)
 #define LEFT_ADJUST_RESULT_BIT (ADLAR)
+#define CHANNEL_SELECTION_MASK                                                \
+  ((1 << (MUX3)) | (1 << (MUX2)) | (1 << (MUX1)) | (1 << (MUX0)))
 
 #define ADC_CONVERSION_RESULT (ADC)
 #define ADC_DATA_REGISTER_HI (ADCH)
 
+static bool adc_is_powered = false;
+
+static void adc_power_up (void);
 static bool adc_is_busy (void);
 static bool adc_is_enabled (void);
 static uint8_t init_reference_voltage (ADCRefVoltage_t rv);
@@ -29,7 +35,7 @@ ADCInitResult_t
 adc_init (ADCRefVoltage_t ref_voltage, bool right_adjusted,
           ADCChannel_t channel, ADCPrescalerDivisor_t prescaler)
 {
-  POWER_REDUCTION_REGISTER &= ~(1 << (ADC_POWER_REDUCTION_BIT));
+  adc_power_up ();
 
   while (adc_is_busy ())
     ;
@@ -44,11 +50,13 @@ adc_init (ADCRefVoltage_t ref_voltage, bool right_adjusted,
 
   if (!is_valid_adc_channel (channel))
     return ADC_INIT_INVALID_CHANNEL_SELECTION;
-  MULTIPLEXER_SELECTION_REGISTER |= channel;
+  MULTIPLEXER_SELECTION_REGISTER
+      = (MULTIPLEXER_SELECTION_REGISTER & ~(CHANNEL_SELECTION_MASK)) | channel;
 
   if (!is_valid_prescaler_value (prescaler))
     return ADC_INIT_INVALID_PRESCALER_SELECTION;
-  ADC_CTRL_STATUS_REGISTER_A |= prescaler;
+  ADC_CTRL_STATUS_REGISTER_A
+      = (ADC_CTRL_STATUS_REGISTER_A & ~(PRESCALER_SELECTION_MASK)) | prescaler;
 
   if (!adc_is_enabled ())
     {
@@ -58,13 +66,6 @@ adc_init (ADCRefVoltage_t ref_voltage, bool right_adjusted,
   return ADC_INIT_SUCCESS;
 }
 
-ADCInitResult_t
-adc_init_with_analog_input (AnalogInput_t *ai)
-{
-  return adc_init (ai->ref_voltage, ai->right_adjusted, ai->channel,
-                   ai->prescaler);
-}
-
 bool
 adc_is_busy (void)
 {
@@ -144,10 +145,50 @@ adc_is_enabled (void)
 uint16_t
 adc_start (bool right_adjusted)
 {
+  /* The first conversion after enabling takes 25 cycles instead of 13. */
+  if (!adc_is_enabled ())
+    {
+      adc_power_up ();
+      ADC_CTRL_STATUS_REGISTER_A |= (1 << (ADC_ENABLE_BIT));
+    }
+
   ADC_CTRL_STATUS_REGISTER_A |= (1 << (START_CONVERSION_BIT));
 
   while (adc_is_busy ())
     ;
+  METRIC_INC (adc_conversions);
 
   return right_adjusted ? ADC_CONVERSION_RESULT : ADC_DATA_REGISTER_HI;
 }
+
+void
+adc_sample (bool right_adjusted, ADCSample_t *sample)
+{
+  sample->timestamp_us = time_now_us ();
+  sample->value = adc_start (right_adjusted);
+}
+
+void
+adc_shutdown (void)
+{
+  if (!adc_is_powered)
+    return;
+
+  while (adc_is_busy ())
+    ;
+
+  /* "The ADC must be disabled before shut down." (pg. 40) */
+  ADC_CTRL_STATUS_REGISTER_A &= ~(1 << (ADC_ENABLE_BIT));
+  pwr_release (PWR_ADC);
+  adc_is_powered = false;
+}
+
+void
+adc_power_up (void)
+{
+  if (adc_is_powered)
+    return;
+
+  pwr_acquire (PWR_ADC);
+  adc_is_powered = true;
+}
@@ -0,0 +1,194 @@
+#include "analog_comparator.h"
+#include "power.h"
+#include "timebase.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#define ANALOG_COMPARATOR_CTRL_STATUS_REGISTER (ACSR)
+#define ANALOG_COMPARATOR_DISABLE_BIT (ACD)
+#define ANALOG_COMPARATOR_BANDGAP_SELECT_BIT (ACBG)
+#define ANALOG_COMPARATOR_OUTPUT_BIT (ACO)
+#define ANALOG_COMPARATOR_INTERRUPT_FLAG_BIT (ACI)
+#define ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT (ACIE)
+#define ANALOG_COMPARATOR_INTERRUPT_MODE_BIT_0 (ACIS0)
+
+#define ADC_CTRL_STATUS_REGISTER_B (ADCSRB)
+#define ANALOG_COMPARATOR_MUX_ENABLE_BIT (ACME)
+
+#define MULTIPLEXER_SELECTION_REGISTER (ADMUX)
+#define MULTIPLEXER_CHANNEL_MASK (0x0F)
+
+#define DIGITAL_INPUT_DISABLE_REGISTER_1 (DIDR1)
+#define AIN0_DIGITAL_INPUT_DISABLE_BIT (AIN0D)
+#define AIN1_DIGITAL_INPUT_DISABLE_BIT (AIN1D)
+
+/* AIN0 is PD6 and AIN1 is PD7. */
+#define AIN_DATA_DIRECTION_REGISTER (DDRD)
+#define AIN_DATA_REGISTER (PORTD)
+#define AIN0_PIN (PORTD6)
+#define AIN1_PIN (PORTD7)
+
+static volatile uint32_t events = 0;
+static volatile uint32_t last_event_us = 0;
+static TaskId_t listener_task = -1;
+static AComparatorNegative_t negative_input = ACMP_NEG_AIN1;
+static bool holds_adc = false;
+
+static void release_adc (void);
+static void select_mux_channel (void);
+static void make_analog_input (uint8_t pin, uint8_t didr_bit);
+
+/* Analog Comparator */
+ISR (ANALOG_COMP_vect)
+{
+  events++;
+  last_event_us = time_now_us ();
+
+  if (listener_task >= 0)
+    sched_reschedule (listener_task, 0);
+}
+
+int8_t
+acmp_init (AComparatorPositive_t pos, AComparatorNegative_t neg,
+           AComparatorEdge_t edge, TaskId_t listener)
+{
+  if ((unsigned)pos > ACMP_POS_BANDGAP || (unsigned)neg > ACMP_NEG_AIN1
+      || (edge != ACMP_ON_TOGGLE && edge != ACMP_ON_FALLING
+          && edge != ACMP_ON_RISING))
+    return -1;
+
+  /*
+   *  The interrupt must be disabled while ACD and ACIS1:0 change, or
+   *  changing them can raise one. see: Section 23.3.2, ATmega328P data
+   *  sheet.
+   */
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      &= ~(1 << (ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT));
+
+  listener_task = listener;
+  negative_input = neg;
+
+  if (pos == ACMP_POS_AIN0)
+    make_analog_input (AIN0_PIN, AIN0_DIGITAL_INPUT_DISABLE_BIT);
+
+  if (neg == ACMP_NEG_AIN1)
+    {
+      make_analog_input (AIN1_PIN, AIN1_DIGITAL_INPUT_DISABLE_BIT);
+      release_adc ();
+      ADC_CTRL_STATUS_REGISTER_B &= ~(1 << (ANALOG_COMPARATOR_MUX_ENABLE_BIT));
+    }
+  else
+    {
+      /* The multiplexer is part of the ADC, so it has to stay powered. */
+      if (!holds_adc)
+        {
+          pwr_acquire (PWR_ADC);
+          holds_adc = true;
+        }
+      select_mux_channel ();
+      ADC_CTRL_STATUS_REGISTER_B |= (1 << (ANALOG_COMPARATOR_MUX_ENABLE_BIT));
+    }
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { events = 0; }
+
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      = ((pos == ACMP_POS_BANDGAP)
+             ? (1 << (ANALOG_COMPARATOR_BANDGAP_SELECT_BIT))
+             : 0)
+        | (edge << (ANALOG_COMPARATOR_INTERRUPT_MODE_BIT_0));
+
+  /* Discard anything flagged while the inputs were settling. */
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_INTERRUPT_FLAG_BIT));
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT));
+
+  return 0;
+}
+
+void
+acmp_shutdown (void)
+{
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      &= ~(1 << (ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT));
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_DISABLE_BIT));
+  ADC_CTRL_STATUS_REGISTER_B &= ~(1 << (ANALOG_COMPARATOR_MUX_ENABLE_BIT));
+  release_adc ();
+}
+
+void
+acmp_suspend (void)
+{
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      &= ~(1 << (ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT));
+}
+
+void
+acmp_resume (void)
+{
+  if (negative_input != ACMP_NEG_AIN1)
+    select_mux_channel ();
+
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_INTERRUPT_FLAG_BIT));
+  ANALOG_COMPARATOR_CTRL_STATUS_REGISTER
+      |= (1 << (ANALOG_COMPARATOR_INTERRUPT_ENABLE_BIT));
+}
+
+bool
+acmp_output (void)
+{
+  return (ANALOG_COMPARATOR_CTRL_STATUS_REGISTER)
+         & (1 << (ANALOG_COMPARATOR_OUTPUT_BIT));
+}
+
+uint32_t
+acmp_events (void)
+{
+  uint32_t count;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { count = events; }
+
+  return count;
+}
+
+uint32_t
+acmp_last_event_us (void)
+{
+  uint32_t time_us;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { time_us = last_event_us; }
+
+  return time_us;
+}
+
+void
+release_adc (void)
+{
+  if (!holds_adc)
+    return;
+
+  pwr_release (PWR_ADC);
+  holds_adc = false;
+}
+
+/* The ADC may have been pointed elsewhere; REFSn and ADLAR are left alone. */
+void
+select_mux_channel (void)
+{
+  MULTIPLEXER_SELECTION_REGISTER
+      = (MULTIPLEXER_SELECTION_REGISTER & ~(MULTIPLEXER_CHANNEL_MASK))
+        | negative_input;
+}
+
+/* An input without pull-up, whose digital input buffer only wastes power. */
+void
+make_analog_input (uint8_t pin, uint8_t didr_bit)
+{
+  AIN_DATA_DIRECTION_REGISTER &= ~(1 << pin);
+  AIN_DATA_REGISTER &= ~(1 << pin);
+  DIGITAL_INPUT_DISABLE_REGISTER_1 |= (1 << didr_bit);
+}
@@ -0,0 +1,336 @@
+#include "config_store.h"
+#include "scheduler.h"
+
+#include <avr/eeprom.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <util/crc16.h>
+
+#define CFG_MAGIC (0xC0F1)
+#define SLOT_COUNT (2)
+#define LINE_BUFFER_SIZE (32)
+
+#define STATUS_COMMAND ('k')
+#define WRITE_COMMAND ('w')
+
+typedef struct CfgHeader_s
+{
+  uint16_t magic;
+  uint8_t version;
+  uint8_t size;
+  uint16_t generation;
+  uint16_t crc; // Over the rest of the header, then the settings
+} CfgHeader_t;
+
+__extension__ _Static_assert ((CFG_EEPROM_BASE)
+                                      + (SLOT_COUNT)
+                                            * (sizeof (CfgHeader_t)
+                                               + (CFG_MAX_SIZE))
+                                  <= (E2END) + 1,
+                              "The config store doesn't fit in EEPROM");
+
+static void *settings = NULL;
+static uint8_t settings_size = 0;
+static uint8_t settings_version = 0;
+static const void *default_settings = NULL;
+
+static uint8_t active_slot = 0; // The copy last loaded or written
+static bool stored = false;     // Whether `active_slot` holds a valid copy
+static uint16_t generation = 0;
+static bool dirty = false;
+static bool written = false; // Since boot
+static uint32_t last_write_ms = 0;
+static TaskId_t write_back_task = -1;
+
+/*
+ *  The write in progress, if any: the settings, then `write_header`, into
+ *  `write_slot`, up to byte `write_pos`. `write_crc` covers what has been
+ *  written so far, so the header matches the bytes in EEPROM even if the
+ *  settings change part way through (which marks them dirty again).
+ */
+static bool writing = false;
+static uint8_t write_slot = 0;
+static uint8_t write_pos = 0;
+static CfgHeader_t write_header;
+static uint16_t write_crc = 0;
+
+static void write_back (void);
+static void begin_write (void);
+static void write_step (void);
+static uint16_t slot_address (uint8_t slot);
+static uint16_t header_crc (const CfgHeader_t *h);
+static uint16_t checksum (const CfgHeader_t *h);
+static int8_t read_slot (uint8_t slot, const CfgHeader_t *h);
+static bool matches_slot (uint8_t slot);
+
+int8_t
+cfg_load (void *config, uint8_t size, uint8_t version, const void *defaults)
+{
+  if (config == NULL || size == 0 || size > (CFG_MAX_SIZE))
+    return -1;
+
+  settings = config;
+  writing = false;
+  settings_size = size;
+  settings_version = version;
+  default_settings = defaults;
+
+  /* One-shot, and re-armed by each `cfg_mark_dirty`. */
+  write_back_task
+      = sched_add_task (write_back, (CFG_SETTLE_MS), 0, SCHED_NO_DEADLINE);
+  if (write_back_task < 0)
+    return -1;
+
+  CfgHeader_t headers[(SLOT_COUNT)];
+  for (uint8_t slot = 0; slot < (SLOT_COUNT); slot++)
+    eeprom_read_block (&headers[slot],
+                       (const void *)(uintptr_t)slot_address (slot),
+                       sizeof (CfgHeader_t));
+
+  /* The newer copy first, then the older to fall back on. */
+  const uint8_t newest
+      = (int16_t)(headers[1].generation - headers[0].generation) > 0;
+  for (uint8_t i = 0; i < (SLOT_COUNT); i++)
+    {
+      const uint8_t slot = newest ^ i;
+      if (read_slot (slot, &headers[slot]) == 0)
+        {
+          active_slot = slot;
+          generation = headers[slot].generation;
+          stored = true;
+          return 0;
+        }
+    }
+
+  memcpy_P (settings, default_settings, settings_size);
+  active_slot = (SLOT_COUNT)-1;
+  generation = 0;
+  stored = false;
+  return 1;
+}
+
+void
+cfg_mark_dirty (void)
+{
+  dirty = true;
+  /* A write in progress finishes first, then waits out the settle time. */
+  if (!writing)
+    sched_reschedule (write_back_task, (CFG_SETTLE_MS));
+}
+
+void
+cfg_flush (void)
+{
+  if (settings == NULL)
+    return;
+
+  while (writing)
+    write_step ();
+  if (!dirty)
+    return;
+
+  begin_write ();
+  while (writing)
+    write_step ();
+}
+
+void
+cfg_restore_defaults (void)
+{
+  if (settings == NULL)
+    return;
+
+  memcpy_P (settings, default_settings, settings_size);
+  cfg_mark_dirty ();
+}
+
+uint16_t
+cfg_generation (void)
+{
+  return generation;
+}
+
+int8_t
+cfg_command (uint8_t cmd, void (*write) (const char *))
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  switch (cmd)
+    {
+    case (STATUS_COMMAND):
+      snprintf (line, sizeof (line), "cfg,%u,%u,%u\r\n", settings_version,
+                generation, dirty || writing);
+      write (line);
+      return 0;
+    case (WRITE_COMMAND):
+      cfg_flush ();
+      return 0;
+    default:
+      return -1;
+    }
+}
+
+/*
+ *  Holds a write back until `CFG_MIN_WRITE_INTERVAL_MS` after the last, then
+ *  carries it out a step per run, `CFG_WRITE_STEP_MS` apart.
+ */
+void
+write_back (void)
+{
+  if (!writing)
+    {
+      if (!dirty)
+        return;
+
+      const uint32_t since_ms = sched_now_ms () - last_write_ms;
+      if (written && since_ms < (CFG_MIN_WRITE_INTERVAL_MS))
+        {
+          sched_reschedule (write_back_task,
+                            (uint16_t)((CFG_MIN_WRITE_INTERVAL_MS)-since_ms));
+          return;
+        }
+
+      begin_write ();
+      if (!writing)
+        return;
+    }
+
+  write_step ();
+  if (writing)
+    sched_reschedule (write_back_task, (CFG_WRITE_STEP_MS));
+  else if (dirty)
+    sched_reschedule (write_back_task, (CFG_SETTLE_MS));
+}
+
+/* Starts writing the settings into the older copy, unless they match. */
+void
+begin_write (void)
+{
+  dirty = false;
+
+  /* Changed, then changed back. */
+  if (stored && matches_slot (active_slot))
+    return;
+
+  write_slot = active_slot ^ 1;
+  write_pos = 0;
+  write_header = (CfgHeader_t){ (CFG_MAGIC), settings_version, settings_size,
+                                (uint16_t)(generation + 1), 0 };
+  write_crc = header_crc (&write_header);
+  writing = true;
+}
+
+/*
+ *  Moves the write on to the next byte which differs from what's in EEPROM
+ *  and starts programming it, which the EEPROM finishes by itself. The
+ *  header goes last, its CRC last of all, so a copy is only valid once
+ *  whole.
+ */
+void
+write_step (void)
+{
+  const uint8_t total = settings_size + sizeof (CfgHeader_t);
+
+  while (write_pos < total)
+    {
+      uint16_t addr = slot_address (write_slot);
+      uint8_t byte;
+
+      if (write_pos < settings_size)
+        {
+          byte = ((const uint8_t *)settings)[write_pos];
+          addr += sizeof (CfgHeader_t) + write_pos;
+          write_crc = _crc16_update (write_crc, byte);
+          write_header.crc = write_crc;
+        }
+      else
+        {
+          const uint8_t i = write_pos - settings_size;
+          byte = ((const uint8_t *)&write_header)[i];
+          addr += i;
+        }
+
+      write_pos++;
+      if (eeprom_read_byte ((const uint8_t *)(uintptr_t)addr) != byte)
+        {
+          eeprom_update_byte ((uint8_t *)(uintptr_t)addr, byte);
+          if (write_pos < total)
+            return;
+        }
+    }
+
+  writing = false;
+  active_slot = write_slot;
+  generation = write_header.generation;
+  stored = true;
+  written = true;
+  last_write_ms = sched_now_ms ();
+}
+
+uint16_t
+slot_address (uint8_t slot)
+{
+  return (CFG_EEPROM_BASE) + slot * (sizeof (CfgHeader_t) + settings_size);
+}
+
+/* CRC-16 (0xA001) of `h` up to its CRC. */
+uint16_t
+header_crc (const CfgHeader_t *h)
+{
+  const uint8_t *p = (const uint8_t *)h;
+  uint16_t crc = 0xFFFF;
+
+  for (uint8_t i = 0; i < offsetof (CfgHeader_t, crc); i++)
+    crc = _crc16_update (crc, p[i]);
+
+  return crc;
+}
+
+/* `header_crc`, carried on over the settings in RAM. */
+uint16_t
+checksum (const CfgHeader_t *h)
+{
+  const uint8_t *p = settings;
+  uint16_t crc = header_crc (h);
+
+  for (uint8_t i = 0; i < settings_size; i++)
+    crc = _crc16_update (crc, p[i]);
+
+  return crc;
+}
+
+/*
+ *  Reads `slot`'s settings into RAM.
+ *  @param  h  the slot's header, already read
+ *  @return 0 if they're valid and of this version and size, else -1.
+ */
+int8_t
+read_slot (uint8_t slot, const CfgHeader_t *h)
+{
+  if (h->magic != (CFG_MAGIC) || h->version != settings_version
+      || h->size != settings_size)
+    return -1;
+
+  eeprom_read_block (
+      settings, (const void *)(uintptr_t)(slot_address (slot) + sizeof (*h)),
+      settings_size);
+
+  return checksum (h) == h->crc ? 0 : -1;
+}
+
+/* @return true if `slot` holds the settings as they are in RAM. */
+bool
+matches_slot (uint8_t slot)
+{
+  const uint8_t *p = settings;
+  const uint16_t addr = slot_address (slot) + sizeof (CfgHeader_t);
+
+  for (uint8_t i = 0; i < settings_size; i++)
+    if (eeprom_read_byte ((const uint8_t *)(uintptr_t)(addr + i)) != p[i])
+      return false;
+
+  return true;
+}
@@ -0,0 +1,382 @@
+#include "input.h"
+#include "timebase.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+#include <util/atomic.h>
+
+#define EXT_INTERRUPT_CTRL_REGISTER (EICRA)
+#define EXT_INTERRUPT_MASK_REGISTER (EIMSK)
+#define EXT_INTERRUPT_FLAG_REGISTER (EIFR)
+#define PIN_CHANGE_INTERRUPT_CTRL_REGISTER (PCICR)
+
+/* INT0 is on PD2 and INT1 on PD3. */
+#define EXT_INTERRUPT_0_PIN (PORTD2)
+#define EXT_INTERRUPT_1_PIN (PORTD3)
+#define NO_EXT_INTERRUPT (-1)
+
+/* PC6 is RESET. */
+#define PORT_C_PIN_COUNT (6)
+#define PORT_PIN_COUNT (8)
+
+#define NO_WAIT (UINT16_MAX)
+
+__extension__ _Static_assert (((INPUT_QUEUE_SIZE) & ((INPUT_QUEUE_SIZE)-1))
+                                  == 0,
+                              "INPUT_QUEUE_SIZE must be a power of two");
+
+typedef struct InputPortDesc_s
+{
+  volatile uint8_t *input_register;
+  volatile uint8_t *data_direction_register;
+  volatile uint8_t *data_register;
+  volatile uint8_t *pin_change_mask_register;
+  uint8_t pin_change_interrupt_enable_bit;
+} InputPortDesc_t;
+
+typedef struct Button_s
+{
+  InputPort_t port;
+  uint8_t mask;        // The pin's bit in the port registers
+  int8_t ext_int;      // 0 or 1 for INT0/INT1, else `NO_EXT_INTERRUPT`
+  bool active_low;
+  bool pending;        // Interrupt masked, waiting for the level to settle
+  bool pressed;        // Debounced state
+  bool long_sent;
+  uint32_t edge_ms;
+  uint32_t next_hold_ms; // When the next long-press/repeat event is due
+} Button_t;
+
+static const InputPortDesc_t PORT_DESCRIPTORS[] PROGMEM = {
+  [INP_PORT_B] = { &PINB, &DDRB, &PORTB, &PCMSK0, PCIE0 },
+  [INP_PORT_C] = { &PINC, &DDRC, &PORTC, &PCMSK1, PCIE1 },
+  [INP_PORT_D] = { &PIND, &DDRD, &PORTD, &PCMSK2, PCIE2 },
+};
+
+static Button_t buttons[(INPUT_MAX_BUTTONS)];
+static uint8_t button_count = 0;
+
+static InputEvent_t queue[(INPUT_QUEUE_SIZE)];
+static uint8_t queue_head = 0;
+static uint8_t queue_tail = 0;
+static uint16_t dropped_events = 0;
+
+static TaskId_t service_task = -1;
+static TaskId_t listener_task = -1;
+
+static void service_buttons (void);
+static void on_external_interrupt (int8_t n);
+static void on_pin_change (InputPort_t port);
+static void start_debounce (Button_t *btn, uint32_t now);
+static void mask_interrupt (const Button_t *btn);
+static void unmask_interrupt (const Button_t *btn);
+static bool read_pressed (const Button_t *btn);
+static bool push_event (ButtonId_t b, InputEventType_t type, uint32_t time);
+static void schedule_service (void);
+
+/* External Interrupt Request 0 */
+ISR (INT0_vect) { on_external_interrupt (0); }
+
+/* External Interrupt Request 1 */
+ISR (INT1_vect) { on_external_interrupt (1); }
+
+/* Pin Change Interrupt Request 0 (port B) */
+ISR (PCINT0_vect) { on_pin_change (INP_PORT_B); }
+
+/* Pin Change Interrupt Request 1 (port C) */
+ISR (PCINT1_vect) { on_pin_change (INP_PORT_C); }
+
+/* Pin Change Interrupt Request 2 (port D) */
+ISR (PCINT2_vect) { on_pin_change (INP_PORT_D); }
+
+int8_t
+input_init (TaskId_t listener)
+{
+  listener_task = listener;
+
+  if (service_task < 0)
+    service_task
+        = sched_add_task (service_buttons, 0, 0, (INPUT_DEBOUNCE_MS) / 4);
+
+  return service_task < 0 ? -1 : 0;
+}
+
+ButtonId_t
+input_add_button (InputPort_t port, uint8_t pin, bool active_low)
+{
+  if ((unsigned)port > INP_PORT_D || button_count >= (INPUT_MAX_BUTTONS))
+    return -1;
+  if (pin >= (port == INP_PORT_C ? (PORT_C_PIN_COUNT) : (PORT_PIN_COUNT)))
+    return -1;
+
+  const ButtonId_t b = button_count;
+  Button_t *btn = &buttons[b];
+  const InputPortDesc_t *desc = &PORT_DESCRIPTORS[port];
+  volatile uint8_t *ddr = pgm_read_ptr (&desc->data_direction_register);
+  volatile uint8_t *data = pgm_read_ptr (&desc->data_register);
+
+  btn->port = port;
+  btn->mask = (1 << pin);
+  btn->active_low = active_low;
+  btn->pending = false;
+  btn->long_sent = false;
+  btn->ext_int = NO_EXT_INTERRUPT;
+  if (port == INP_PORT_D && pin == (EXT_INTERRUPT_0_PIN))
+    btn->ext_int = 0;
+  else if (port == INP_PORT_D && pin == (EXT_INTERRUPT_1_PIN))
+    btn->ext_int = 1;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    *ddr &= ~btn->mask;
+    if (active_low)
+      *data |= btn->mask;
+    else
+      *data &= ~btn->mask;
+
+    btn->pressed = read_pressed (btn);
+
+    if (btn->ext_int != (NO_EXT_INTERRUPT))
+      {
+        /* ISCn1:0 = 0b01, any logical change (Table 12-2, pg. 71). */
+        const uint8_t isc_shift = btn->ext_int == 0 ? (ISC00) : (ISC10);
+        EXT_INTERRUPT_CTRL_REGISTER
+            = (EXT_INTERRUPT_CTRL_REGISTER & ~(0x3 << isc_shift))
+              | (0x1 << isc_shift);
+      }
+    else
+      {
+        PIN_CHANGE_INTERRUPT_CTRL_REGISTER
+            |= (1 << pgm_read_byte (&desc->pin_change_interrupt_enable_bit));
+      }
+    unmask_interrupt (btn);
+
+    button_count++;
+  }
+
+  return b;
+}
+
+bool
+input_get_event (InputEvent_t *event)
+{
+  if (queue_head == queue_tail)
+    return false;
+
+  *event = queue[queue_tail];
+  queue_tail = (queue_tail + 1) & ((INPUT_QUEUE_SIZE)-1);
+  return true;
+}
+
+bool
+input_is_pressed (ButtonId_t b)
+{
+  return b >= 0 && b < button_count && buttons[b].pressed;
+}
+
+uint16_t
+input_dropped_events (void)
+{
+  return dropped_events;
+}
+
+/*
+ *  Reads the level of each button whose debounce period is over and turns
+ *  its interrupt back on, then emits long-press/repeat events for buttons
+ *  still held. Runs only when rescheduled by an edge or a pending hold.
+ */
+void
+service_buttons (void)
+{
+  const uint32_t now = time_now_ms ();
+  bool queued = false;
+
+  for (ButtonId_t b = 0; b < button_count; b++)
+    {
+      Button_t *btn = &buttons[b];
+      bool settled = false;
+      uint32_t edge_ms = 0;
+
+      ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+      {
+        edge_ms = btn->edge_ms;
+        settled = btn->pending
+                  && (int32_t)(now - edge_ms) >= (INPUT_DEBOUNCE_MS);
+        if (settled)
+          {
+            btn->pending = false;
+            unmask_interrupt (btn);
+          }
+      }
+
+      /*
+       *  The interrupt is back on before the level is read, so a change
+       *  after this point starts another debounce rather than being lost.
+       */
+      if (settled && read_pressed (btn) != btn->pressed)
+        {
+          btn->pressed = !btn->pressed;
+          btn->long_sent = false;
+          btn->next_hold_ms = edge_ms + (INPUT_LONG_PRESS_MS);
+          queued |= push_event (b, btn->pressed ? INPUT_PRESS : INPUT_RELEASE,
+                                edge_ms);
+        }
+
+      if (btn->pressed && (int32_t)(now - btn->next_hold_ms) >= 0)
+        {
+          queued |= push_event (
+              b, btn->long_sent ? INPUT_REPEAT : INPUT_LONG_PRESS, now);
+          btn->long_sent = true;
+          btn->next_hold_ms = now + (INPUT_REPEAT_MS);
+        }
+    }
+
+  schedule_service ();
+
+  if (queued && listener_task >= 0)
+    sched_reschedule (listener_task, 0);
+}
+
+/*
+ *  Reschedules `service_buttons` for the earliest settle or hold time. Done
+ *  with interrupts off, as an edge may arrive (and reschedule it) meanwhile.
+ */
+void
+schedule_service (void)
+{
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    const uint32_t now = time_now_ms ();
+    uint16_t wait_ms = (NO_WAIT);
+
+    for (ButtonId_t b = 0; b < button_count; b++)
+      {
+        const Button_t *btn = &buttons[b];
+        uint32_t due;
+
+        if (btn->pending)
+          due = btn->edge_ms + (INPUT_DEBOUNCE_MS);
+        else if (btn->pressed)
+          due = btn->next_hold_ms;
+        else
+          continue;
+
+        const int32_t until = (int32_t)(due - now);
+        if (until <= 0)
+          wait_ms = 0;
+        else if ((uint32_t)until < wait_ms)
+          wait_ms = until;
+      }
+
+    if (wait_ms != (NO_WAIT))
+      sched_reschedule (service_task, wait_ms);
+  }
+}
+
+void
+on_external_interrupt (int8_t n)
+{
+  const uint32_t now = time_now_ms ();
+
+  for (ButtonId_t b = 0; b < button_count; b++)
+    {
+      if (buttons[b].ext_int == n)
+        start_debounce (&buttons[b], now);
+    }
+}
+
+/*
+ *  Pin change interrupts don't say which pin changed, so every button on the
+ *  port starts debouncing; those which didn't change just read unchanged.
+ */
+void
+on_pin_change (InputPort_t port)
+{
+  const uint32_t now = time_now_ms ();
+
+  for (ButtonId_t b = 0; b < button_count; b++)
+    {
+      if (buttons[b].port == port && buttons[b].ext_int == (NO_EXT_INTERRUPT))
+        start_debounce (&buttons[b], now);
+    }
+}
+
+/* Called with interrupts off. */
+void
+start_debounce (Button_t *btn, uint32_t now)
+{
+  if (btn->pending)
+    return;
+
+  mask_interrupt (btn);
+  btn->pending = true;
+  btn->edge_ms = now;
+  /* Not later than another button's settle or hold time. */
+  sched_reschedule_sooner (service_task, (INPUT_DEBOUNCE_MS));
+}
+
+void
+mask_interrupt (const Button_t *btn)
+{
+  if (btn->ext_int != (NO_EXT_INTERRUPT))
+    {
+      EXT_INTERRUPT_MASK_REGISTER &= ~(1 << ((INT0) + btn->ext_int));
+    }
+  else
+    {
+      volatile uint8_t *pcmsk = pgm_read_ptr (
+          &PORT_DESCRIPTORS[btn->port].pin_change_mask_register);
+      *pcmsk &= ~btn->mask;
+    }
+}
+
+/*
+ *  INTFn is set by edges even while INTn is masked, so it is cleared first.
+ *  A masked pin doesn't set PCIFn, so there is nothing to clear there.
+ */
+void
+unmask_interrupt (const Button_t *btn)
+{
+  if (btn->ext_int != (NO_EXT_INTERRUPT))
+    {
+      EXT_INTERRUPT_FLAG_REGISTER = (1 << ((INTF0) + btn->ext_int));
+      EXT_INTERRUPT_MASK_REGISTER |= (1 << ((INT0) + btn->ext_int));
+    }
+  else
+    {
+      volatile uint8_t *pcmsk = pgm_read_ptr (
+          &PORT_DESCRIPTORS[btn->port].pin_change_mask_register);
+      *pcmsk |= btn->mask;
+    }
+}
+
+bool
+read_pressed (const Button_t *btn)
+{
+  volatile uint8_t *pin_reg
+      = pgm_read_ptr (&PORT_DESCRIPTORS[btn->port].input_register);
+  const bool high = (*pin_reg & btn->mask) != 0;
+
+  return btn->active_low ? !high : high;
+}
+
+/* @return false if the queue was full and the event was dropped. */
+bool
+push_event (ButtonId_t b, InputEventType_t type, uint32_t time)
+{
+  const uint8_t next_head = (queue_head + 1) & ((INPUT_QUEUE_SIZE)-1);
+
+  if (next_head == queue_tail)
+    {
+      dropped_events++;
+      return false;
+    }
+
+  queue[queue_head].button = b;
+  queue[queue_head].type = type;
+  queue[queue_head].time_ms = time;
+  queue_head = next_head;
+  return true;
+}
@@ -0,0 +1,140 @@
+#include "latency.h"
+
+#if LAT_ENABLED
+
+#include "scheduler.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define LINE_BUFFER_SIZE (80)
+
+typedef struct ReportedHistogram_s
+{
+  LatencyHistogram_t *histogram;
+  const char *name;
+} ReportedHistogram_t;
+
+static ReportedHistogram_t reported[(LAT_MAX_REPORTED)];
+static uint8_t reported_count = 0;
+static TaskId_t report_task = -1;
+static void (*report_write) (const char *) = NULL;
+
+static uint8_t bucket_of (uint32_t us);
+static void report_latency (void);
+
+void
+lat_record (LatencyHistogram_t *h, uint32_t us)
+{
+  uint16_t *bucket = &h->buckets[bucket_of (us)];
+
+  if (*bucket < UINT16_MAX)
+    (*bucket)++;
+  if (h->count < UINT16_MAX)
+    h->count++;
+  if (us > h->max_us)
+    h->max_us = us;
+}
+
+void
+lat_reset (LatencyHistogram_t *h)
+{
+  *h = (LatencyHistogram_t){ 0 };
+}
+
+uint32_t
+lat_percentile (const LatencyHistogram_t *h, uint8_t percent)
+{
+  uint32_t total = 0;
+
+  for (uint8_t b = 0; b < (LAT_BUCKET_COUNT); b++)
+    total += h->buckets[b];
+  if (total == 0)
+    return 0;
+
+  /* The rank of the sample wanted, rounded up: p50 of 3 samples is the 2nd. */
+  const uint32_t rank = (total * percent + 99) / 100;
+  uint32_t seen = 0;
+
+  for (uint8_t b = 0; b < (LAT_BUCKET_COUNT)-1; b++)
+    {
+      seen += h->buckets[b];
+      if (seen < rank)
+        continue;
+
+      const uint32_t upper = b == 0 ? 0 : (1UL << b) - 1;
+      return upper < h->max_us ? upper : h->max_us;
+    }
+
+  return h->max_us;
+}
+
+void
+lat_report (const LatencyHistogram_t *h, const char *name,
+            void (*write) (const char *))
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  snprintf (line, sizeof (line), "lat,%s,%u,%lu,%lu,%lu\r\n", name, h->count,
+            (unsigned long)lat_percentile (h, 50),
+            (unsigned long)lat_percentile (h, 99), (unsigned long)h->max_us);
+  write (line);
+}
+
+int8_t
+lat_add_to_report (LatencyHistogram_t *h, const char *name)
+{
+  if (reported_count >= (LAT_MAX_REPORTED))
+    return -1;
+
+  reported[reported_count].histogram = h;
+  reported[reported_count].name = name;
+  reported_count++;
+  return 0;
+}
+
+void
+lat_report_all (void (*write) (const char *))
+{
+  for (uint8_t i = 0; i < reported_count; i++)
+    {
+      lat_report (reported[i].histogram, reported[i].name, write);
+      lat_reset (reported[i].histogram);
+    }
+}
+
+int8_t
+lat_start_reports (uint16_t period_ms, void (*write) (const char *))
+{
+  report_write = write;
+  if (report_task >= 0)
+    return 0;
+
+  report_task = sched_add_task (report_latency, period_ms, period_ms,
+                                SCHED_NO_DEADLINE);
+  return report_task < 0 ? -1 : 0;
+}
+
+/* The task `lat_start_reports` schedules. */
+void
+report_latency (void)
+{
+  lat_report_all (report_write);
+}
+
+/* @return the bit length of `us`, capped to the last bucket. */
+uint8_t
+bucket_of (uint32_t us)
+{
+  uint8_t b = 0;
+
+  while (us != 0 && b < (LAT_BUCKET_COUNT)-1)
+    {
+      us >>= 1;
+      b++;
+    }
+
+  return b;
+}
+
+#endif /* LAT_ENABLED */
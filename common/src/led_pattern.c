@@ -0,0 +1,156 @@
+#include "led_pattern.h"
+#include "gpio.h"
+#include "scheduler.h"
+#include "timebase.h"
+
+#include <avr/pgmspace.h>
+#include <stdlib.h>
+
+#define NO_WAIT (UINT16_MAX)
+
+typedef struct LedPlayer_s
+{
+  volatile uint8_t *port;
+  uint8_t mask;
+  uint8_t idle_value;
+  const LedPatternStep_t *steps; // In flash
+  uint8_t step_count;
+  uint8_t step;
+  bool repeat;
+  bool playing;
+  bool holding;         // Current step lasts until the pattern changes
+  uint32_t next_ms;     // When the current step ends
+} LedPlayer_t;
+
+static LedPlayer_t players[(LED_PATTERN_MAX_PLAYERS)];
+static uint8_t player_count = 0;
+static TaskId_t sequencer_task = -1;
+
+static void run_sequencer (void);
+static void enter_step (LedPlayer_t *player, uint8_t step, uint32_t start_ms);
+static void write_group (const LedPlayer_t *player, uint8_t value);
+static bool is_valid_player (LedPlayerId_t p);
+
+int8_t
+led_pattern_init (void)
+{
+  if (sequencer_task < 0)
+    sequencer_task = sched_add_task (run_sequencer, 0, 0, SCHED_NO_DEADLINE);
+
+  return sequencer_task < 0 ? -1 : 0;
+}
+
+LedPlayerId_t
+led_pattern_add_player (volatile uint8_t *port, uint8_t mask,
+                        uint8_t idle_value)
+{
+  if (port == NULL || player_count >= (LED_PATTERN_MAX_PLAYERS))
+    return -1;
+
+  LedPlayer_t *player = &players[player_count];
+  player->port = port;
+  player->mask = mask;
+  player->idle_value = idle_value;
+  player->playing = false;
+  write_group (player, idle_value);
+
+  return player_count++;
+}
+
+void
+led_pattern_play (LedPlayerId_t p, const LedPatternStep_t *steps,
+                  uint8_t step_count, bool repeat)
+{
+  if (!is_valid_player (p) || steps == NULL || step_count == 0)
+    return;
+
+  LedPlayer_t *player = &players[p];
+  player->steps = steps;
+  player->step_count = step_count;
+  player->repeat = repeat;
+  player->playing = true;
+  enter_step (player, 0, time_now_ms ());
+
+  /* Let the sequencer work out when it is next needed. */
+  sched_reschedule (sequencer_task, 0);
+}
+
+void
+led_pattern_stop (LedPlayerId_t p)
+{
+  if (!is_valid_player (p))
+    return;
+
+  players[p].playing = false;
+  write_group (&players[p], players[p].idle_value);
+}
+
+bool
+led_pattern_is_playing (LedPlayerId_t p)
+{
+  return is_valid_player (p) && players[p].playing;
+}
+
+/* Advances every player whose step is over, then sleeps until the next. */
+void
+run_sequencer (void)
+{
+  const uint32_t now = time_now_ms ();
+  uint16_t wait_ms = (NO_WAIT);
+
+  for (uint8_t i = 0; i < player_count; i++)
+    {
+      LedPlayer_t *player = &players[i];
+
+      /* Catch up on (rather than skip) steps if we're running late. */
+      while (player->playing && !player->holding
+             && (int32_t)(now - player->next_ms) >= 0)
+        {
+          if (player->step + 1 < player->step_count)
+            enter_step (player, player->step + 1, player->next_ms);
+          else if (player->repeat)
+            enter_step (player, 0, player->next_ms);
+          else
+            player->holding = true;
+        }
+
+      if (!player->playing || player->holding)
+        continue;
+
+      const uint32_t until = player->next_ms - now;
+      if (until < wait_ms)
+        wait_ms = until;
+    }
+
+  if (wait_ms != (NO_WAIT))
+    sched_reschedule (sequencer_task, wait_ms);
+}
+
+/*
+ *  Outputs a step. Its end is counted from when the previous step should
+ *  have ended, not from now, so patterns don't drift.
+ */
+void
+enter_step (LedPlayer_t *player, uint8_t step, uint32_t start_ms)
+{
+  const LedPatternStep_t *s = &player->steps[step];
+  const uint16_t duration_ms = pgm_read_word (&s->duration_ms);
+
+  player->step = step;
+  player->holding = duration_ms == (LED_PATTERN_HOLD);
+  player->next_ms = start_ms + duration_ms;
+  write_group (player, pgm_read_byte (&s->value));
+}
+
+/* Writes the player's pins as one atomic store (see `gpio_write_group`). */
+void
+write_group (const LedPlayer_t *player, uint8_t value)
+{
+  gpio_write_group (player->port, player->mask, value);
+}
+
+bool
+is_valid_player (LedPlayerId_t p)
+{
+  return p >= 0 && p < player_count;
+}
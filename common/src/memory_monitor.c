@@ -0,0 +1,128 @@
+#include "memory_monitor.h"
+
+#include <avr/io.h>
+#include <stdio.h>
+
+#define LINE_BUFFER_SIZE (48)
+#define CANARY_SIZE (2)
+
+#define REPORT_COMMAND ('s')
+
+#ifdef __AVR__
+/* Defined by the linker: the first byte past .bss. */
+extern uint8_t _end;
+
+#define STATIC_END (&_end)
+#define RAM_START ((uint8_t *)(RAMSTART))
+#define RAM_END ((uint8_t *)(RAMEND))
+
+static void paint_stack (void)
+    __attribute__ ((naked, used, section (".init3")));
+static const uint8_t *lowest_touched (void);
+#endif /* __AVR__ */
+
+uint16_t
+mem_static_bytes (void)
+{
+#ifdef __AVR__
+  return STATIC_END - RAM_START;
+#else
+  return 0;
+#endif /* __AVR__ */
+}
+
+uint16_t
+mem_stack_peak (void)
+{
+#ifdef __AVR__
+  return RAM_END - lowest_touched () + 1;
+#else
+  return 0;
+#endif /* __AVR__ */
+}
+
+uint16_t
+mem_stack_headroom (void)
+{
+#ifdef __AVR__
+  return lowest_touched () - (STATIC_END + (CANARY_SIZE));
+#else
+  return 0;
+#endif /* __AVR__ */
+}
+
+uint16_t
+mem_free_now (void)
+{
+#ifdef __AVR__
+  /* SP points at the next free byte, so it is free too. */
+  const uint8_t *const stack_pointer = (const uint8_t *)SP;
+  return stack_pointer - (STATIC_END + (CANARY_SIZE)) + 1;
+#else
+  return 0;
+#endif /* __AVR__ */
+}
+
+bool
+mem_canary_intact (void)
+{
+#ifdef __AVR__
+  return STATIC_END[0] == ((MEM_CANARY) & 0xFF)
+         && STATIC_END[1] == ((MEM_CANARY) >> 8);
+#else
+  return true;
+#endif /* __AVR__ */
+}
+
+void
+mem_report (void (*write) (const char *))
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  snprintf (line, sizeof (line), "mem,%u,%u,%u,%u,%s\r\n",
+            mem_static_bytes (), mem_stack_peak (), mem_stack_headroom (),
+            mem_free_now (), mem_canary_intact () ? "ok" : "smashed");
+  write (line);
+}
+
+int8_t
+mem_command (uint8_t cmd, void (*write) (const char *))
+{
+  if (cmd != (REPORT_COMMAND))
+    return -1;
+
+  mem_report (write);
+  return 0;
+}
+
+#ifdef __AVR__
+/*
+ *  Runs from the .init3 section: after the stack pointer and zero register
+ *  are set up, before .data/.bss are, and with nothing on the stack yet.
+ */
+void
+paint_stack (void)
+{
+  STATIC_END[0] = (MEM_CANARY) & 0xFF;
+  STATIC_END[1] = (MEM_CANARY) >> 8;
+
+  for (uint8_t *p = STATIC_END + (CANARY_SIZE); p <= RAM_END; p++)
+    *p = (MEM_PAINT_BYTE);
+}
+
+/*
+ *  A local which happens to hold `MEM_PAINT_BYTE` looks untouched, so the
+ *  result can be a few bytes optimistic.
+ *  @return the lowest address the stack has written.
+ */
+const uint8_t *
+lowest_touched (void)
+{
+  const uint8_t *p = STATIC_END + (CANARY_SIZE);
+
+  while (p <= RAM_END && *p == (MEM_PAINT_BYTE))
+    p++;
+
+  return p;
+}
+#endif /* __AVR__ */
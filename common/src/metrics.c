@@ -0,0 +1,103 @@
+#include "metrics.h"
+
+#include <avr/pgmspace.h>
+#include <stdio.h>
+#include <util/atomic.h>
+
+#define LINE_BUFFER_SIZE (48)
+#define NAME_BUFFER_SIZE (24)
+
+#define DUMP_COMMAND ('m')
+#define CLEAR_COMMAND ('c')
+
+typedef struct MetricDescriptor_s
+{
+  const char *name; // In program memory
+  void *counter;
+  uint8_t size; // sizeof the counter: 2 or 4
+} MetricDescriptor_t;
+
+#define METRIC_DEFINE_(name, type) type metric_##name = 0;
+METRICS_COUNTERS (METRIC_DEFINE_)
+
+#define METRIC_NAME_(name, type)                                              \
+  static const char name##_NAME[] PROGMEM = #name;
+METRICS_COUNTERS (METRIC_NAME_)
+
+#define METRIC_DESCRIPTOR_(name, type)                                        \
+  [METRIC_##name] = { name##_NAME, &metric_##name, sizeof (type) },
+static const MetricDescriptor_t DESCRIPTORS[(METRIC_COUNT)] PROGMEM
+    = { METRICS_COUNTERS (METRIC_DESCRIPTOR_) };
+
+#define METRIC_SIZE_ASSERT_(name, type)                                       \
+  __extension__ _Static_assert (sizeof (type) == 2 || sizeof (type) == 4,     \
+                                #name " must be a 16- or 32-bit counter");
+METRICS_COUNTERS (METRIC_SIZE_ASSERT_)
+
+uint32_t
+metrics_get (Metric_t id)
+{
+  if ((unsigned)id >= (METRIC_COUNT))
+    return 0;
+
+  void *const counter = pgm_read_ptr (&DESCRIPTORS[id].counter);
+  const uint8_t size = pgm_read_byte (&DESCRIPTORS[id].size);
+  uint32_t value;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    value = size == 4 ? *(uint32_t *)counter : *(uint16_t *)counter;
+  }
+
+  return value;
+}
+
+void
+metrics_reset (void)
+{
+  for (uint8_t i = 0; i < (METRIC_COUNT); i++)
+    {
+      void *const counter = pgm_read_ptr (&DESCRIPTORS[i].counter);
+      const uint8_t size = pgm_read_byte (&DESCRIPTORS[i].size);
+
+      ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+      {
+        if (size == 4)
+          *(uint32_t *)counter = 0;
+        else
+          *(uint16_t *)counter = 0;
+      }
+    }
+}
+
+void
+metrics_dump (void (*write) (const char *))
+{
+  char line[(LINE_BUFFER_SIZE)];
+  char name[(NAME_BUFFER_SIZE)];
+
+  for (uint8_t i = 0; i < (METRIC_COUNT); i++)
+    {
+      strncpy_P (name, pgm_read_ptr (&DESCRIPTORS[i].name), sizeof (name) - 1);
+      name[sizeof (name) - 1] = '\0';
+      snprintf (line, sizeof (line), "metric,%s,%lu\r\n", name,
+                (unsigned long)metrics_get (i));
+      write (line);
+    }
+}
+
+int8_t
+metrics_command (uint8_t cmd, void (*write) (const char *))
+{
+  switch (cmd)
+    {
+    case (DUMP_COMMAND):
+      metrics_dump (write);
+      return 0;
+    case (CLEAR_COMMAND):
+      metrics_reset ();
+      return 0;
+    default:
+      return -1;
+    }
+}
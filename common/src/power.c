@@ -0,0 +1,253 @@
+#include "power.h"
+#include "timebase.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/sleep.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <util/atomic.h>
+
+#define POWER_REDUCTION_REGISTER (PRR)
+
+#define ASYNC_STATUS_REGISTER (ASSR)
+#define TCNTR2_ASYNC_BIT (AS2)
+
+#define MAX_USERS (UINT8_MAX)
+
+static const uint8_t POWER_REDUCTION_BITS[(PWR_PERIPHERAL_COUNT)] PROGMEM = {
+  [PWR_ADC] = (PRADC),   [PWR_USART0] = (PRUSART0), [PWR_SPI] = (PRSPI),
+  [PWR_TIM0] = (PRTIM0), [PWR_TIM1] = (PRTIM1),     [PWR_TIM2] = (PRTIM2),
+  [PWR_TWI] = (PRTWI),
+};
+
+/*
+ *  The deepest mode in which each peripheral still runs (and can wake the
+ *  CPU). Timer/Counter2 can go deeper when clocked asynchronously, see
+ *  `deepest_mode_for`.
+ *  see: Table 9-1, pg. 34, ATmega328P data sheet.
+ */
+static const uint8_t DEEPEST_MODES[(PWR_PERIPHERAL_COUNT)] PROGMEM = {
+  [PWR_ADC] = PWR_MODE_ADC_NOISE_REDUCTION,
+  [PWR_USART0] = PWR_MODE_IDLE,
+  [PWR_SPI] = PWR_MODE_IDLE,
+  [PWR_TIM0] = PWR_MODE_IDLE,
+  [PWR_TIM1] = PWR_MODE_IDLE,
+  [PWR_TIM2] = PWR_MODE_IDLE,
+  [PWR_TWI] = PWR_MODE_POWER_DOWN, // TWI address match
+};
+
+static const uint8_t SLEEP_MODE_BITS[(PWR_MODE_COUNT)] PROGMEM = {
+  [PWR_MODE_ACTIVE] = (SLEEP_MODE_IDLE),
+  [PWR_MODE_IDLE] = (SLEEP_MODE_IDLE),
+  [PWR_MODE_ADC_NOISE_REDUCTION] = (SLEEP_MODE_ADC),
+  [PWR_MODE_POWER_SAVE] = (SLEEP_MODE_PWR_SAVE),
+  [PWR_MODE_POWER_DOWN] = (SLEEP_MODE_PWR_DOWN),
+};
+
+/*
+ *  Rough MCU-only supply currents at 5 V and 16 MHz, with the watchdog
+ *  running and the BOD disabled while asleep. Board parts (regulator, USB
+ *  bridge, LEDs) aren't included and usually dominate.
+ *  see: Section 29, Typical Characteristics, ATmega328P data sheet.
+ */
+static const uint16_t TYPICAL_CURRENT_UA[(PWR_MODE_COUNT)] PROGMEM = {
+  [PWR_MODE_ACTIVE] = 9000,
+  [PWR_MODE_IDLE] = 2500,
+  [PWR_MODE_ADC_NOISE_REDUCTION] = 900,
+  [PWR_MODE_POWER_SAVE] = 8,
+  [PWR_MODE_POWER_DOWN] = 6,
+};
+
+static uint8_t users[(PWR_PERIPHERAL_COUNT)] = { 0 };
+static uint32_t entries[(PWR_MODE_COUNT)] = { 0 };
+static uint32_t residency_ms[(PWR_MODE_COUNT)] = { 0 };
+static uint16_t residency_us[(PWR_MODE_COUNT)] = { 0 }; // < 1000
+static uint32_t init_ms = 0;
+
+static bool is_valid_peripheral (PowerPeripheral_t p);
+static PowerMode_t deepest_mode_for (PowerPeripheral_t p);
+static void add_residency_us (PowerMode_t mode, uint32_t us);
+
+void
+pwr_init (void)
+{
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    for (uint8_t p = 0; p < (PWR_PERIPHERAL_COUNT); p++)
+      {
+        if (users[p] == 0)
+          POWER_REDUCTION_REGISTER
+              |= (1 << pgm_read_byte (&POWER_REDUCTION_BITS[p]));
+      }
+  }
+
+  init_ms = time_now_ms ();
+}
+
+int8_t
+pwr_acquire (PowerPeripheral_t p)
+{
+  if (!is_valid_peripheral (p))
+    return -1;
+
+  int8_t result = 0;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    if (users[p] == (MAX_USERS))
+      result = -1;
+    else if (users[p]++ == 0)
+      POWER_REDUCTION_REGISTER
+          &= ~(1 << pgm_read_byte (&POWER_REDUCTION_BITS[p]));
+  }
+
+  return result;
+}
+
+int8_t
+pwr_release (PowerPeripheral_t p)
+{
+  if (!is_valid_peripheral (p))
+    return -1;
+
+  int8_t result = 0;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    if (users[p] == 0)
+      result = -1;
+    else if (--users[p] == 0)
+      POWER_REDUCTION_REGISTER
+          |= (1 << pgm_read_byte (&POWER_REDUCTION_BITS[p]));
+  }
+
+  return result;
+}
+
+uint8_t
+pwr_users (PowerPeripheral_t p)
+{
+  return is_valid_peripheral (p) ? users[p] : 0;
+}
+
+PowerMode_t
+pwr_sleep_mode (void)
+{
+  PowerMode_t mode = PWR_MODE_POWER_DOWN;
+
+  for (uint8_t p = 0; p < (PWR_PERIPHERAL_COUNT); p++)
+    {
+      if (users[p] == 0)
+        continue;
+
+      const PowerMode_t deepest = deepest_mode_for (p);
+      if (deepest < mode)
+        mode = deepest;
+    }
+
+  return mode;
+}
+
+void
+pwr_sleep (void)
+{
+  const PowerMode_t mode = pwr_sleep_mode ();
+  const uint32_t start_us = time_now_us ();
+
+  set_sleep_mode (pgm_read_byte (&SLEEP_MODE_BITS[mode]));
+
+  /*
+   *  The BOD disable sequence is timed, and the instruction after `sei` runs
+   *  before any pending interrupt, so an interrupt from the `cli` on still
+   *  wakes the CPU. One which makes a task due earlier, after `sched_run`
+   *  found none due, isn't acted on until the next wake-up: at most a tick
+   *  (1 ms) late, as the timebase holds Timer/Counter0 running.
+   *  see: pg. 35, ATmega328P data sheet.
+   */
+  cli ();
+  sleep_enable ();
+  if (mode >= PWR_MODE_POWER_SAVE)
+    sleep_bod_disable ();
+  sei ();
+  sleep_cpu ();
+  sleep_disable ();
+
+  entries[mode]++;
+  add_residency_us (mode, time_now_us () - start_us);
+}
+
+void
+pwr_add_residency (PowerMode_t mode, uint32_t ms)
+{
+  if (mode <= PWR_MODE_ACTIVE || mode >= PWR_MODE_COUNT)
+    return;
+
+  residency_ms[mode] += ms;
+}
+
+void
+pwr_get_stats (PowerModeStats_t *stats)
+{
+  uint32_t asleep_ms = 0;
+
+  for (uint8_t m = 0; m < (PWR_MODE_COUNT); m++)
+    {
+      stats[m].entries = entries[m];
+      stats[m].residency_ms = residency_ms[m];
+      stats[m].typical_ua = pgm_read_word (&TYPICAL_CURRENT_UA[m]);
+      asleep_ms += residency_ms[m];
+    }
+
+  /* Time which wasn't spent asleep was spent running. */
+  const uint32_t elapsed_ms = time_now_ms () - init_ms;
+  stats[PWR_MODE_ACTIVE].residency_ms
+      = elapsed_ms > asleep_ms ? elapsed_ms - asleep_ms : 0;
+}
+
+uint32_t
+pwr_estimated_average_ua (void)
+{
+  PowerModeStats_t stats[(PWR_MODE_COUNT)];
+  float total_ms = 0.0;
+  float weighted = 0.0;
+
+  pwr_get_stats (stats);
+  for (uint8_t m = 0; m < (PWR_MODE_COUNT); m++)
+    {
+      total_ms += stats[m].residency_ms;
+      weighted += (float)stats[m].residency_ms * stats[m].typical_ua;
+    }
+
+  return total_ms > 0 ? (uint32_t)(weighted / total_ms)
+                      : pgm_read_word (&TYPICAL_CURRENT_UA[PWR_MODE_ACTIVE]);
+}
+
+bool
+is_valid_peripheral (PowerPeripheral_t p)
+{
+  return (unsigned)p < (PWR_PERIPHERAL_COUNT);
+}
+
+/*
+ *  "[Timer/Counter2] will keep running in [power-save] if [it] is clocked
+ *  asynchronously" (pg. 36, ATmega328P data sheet).
+ */
+PowerMode_t
+deepest_mode_for (PowerPeripheral_t p)
+{
+  if (p == PWR_TIM2
+      && (ASYNC_STATUS_REGISTER) & (1 << (TCNTR2_ASYNC_BIT)))
+    return PWR_MODE_POWER_SAVE;
+
+  return pgm_read_byte (&DEEPEST_MODES[p]);
+}
+
+void
+add_residency_us (PowerMode_t mode, uint32_t us)
+{
+  us += residency_us[mode];
+  residency_ms[mode] += us / 1000;
+  residency_us[mode] = us % 1000;
+}
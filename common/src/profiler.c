@@ -0,0 +1,276 @@
+#include "profiler.h"
+
+#if PROF_ENABLED
+
+#include "power.h"
+#include "timebase.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <util/atomic.h>
+
+#define TCNTR1_CTRL_REGISTER_A (TCCR1A)
+#define TCNTR1_CTRL_REGISTER_B (TCCR1B)
+#define TCNTR1_COUNTER_REGISTER (TCNT1)
+#define TCNTR1_INTERRUPT_MASK_REGISTER (TIMSK1)
+#define TCNTR1_INTERRUPT_FLAG_REGISTER (TIFR1)
+#define TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT (TOIE1)
+#define TCNTR1_OVERFLOW_FLAG_BIT (TOV1)
+#define CLOCK_SELECT_BIT_0 (CS10)
+
+#define CYCLES_PER_US ((F_CPU) / 1000000UL)
+/* Cycles per step of the clock `now_cycles` reads. */
+#ifdef PROF_CLOCK_TIMER1
+#define CLOCK_RESOLUTION_CYCLES (1UL)
+#else
+#define CLOCK_RESOLUTION_CYCLES ((TIME_US_PER_COUNT) * (CYCLES_PER_US))
+#endif /* PROF_CLOCK_TIMER1 */
+#define LINE_BUFFER_SIZE (80)
+#define NAME_BUFFER_SIZE (24)
+#define CALIBRATION_RUNS (4)
+
+#define DUMP_COMMAND ('p')
+#define RESET_COMMAND ('r')
+
+/* Trace events keep the region in the low bits and this flag for an end. */
+#define TRACE_END_FLAG (0x80)
+
+__extension__ _Static_assert ((PROF_REGION_COUNT) < (TRACE_END_FLAG),
+                              "Too many profiler regions");
+__extension__ _Static_assert (((PROF_TRACE_SIZE) & ((PROF_TRACE_SIZE)-1)) == 0
+                                  && (PROF_TRACE_SIZE) <= 128,
+                              "PROF_TRACE_SIZE must be a power of two <= 128");
+
+#define PROF_REGION_NAME_(id, name)                                           \
+  static const char id##_NAME[] PROGMEM = name;
+PROF_REGIONS (PROF_REGION_NAME_)
+
+#define PROF_REGION_NAME_ENTRY_(id, name) [id] = id##_NAME,
+static const char *const REGION_NAMES[(PROF_REGION_COUNT)] PROGMEM
+    = { PROF_REGIONS (PROF_REGION_NAME_ENTRY_) };
+
+static ProfStats_t stats[(PROF_REGION_COUNT)];
+static uint32_t begin_cycles[(PROF_REGION_COUNT)];
+static uint32_t marker_overhead = 0;
+
+#if PROF_TRACE_SIZE > 0
+typedef struct ProfEvent_s
+{
+  uint32_t cycles;
+  uint8_t region; // Or'd with TRACE_END_FLAG for an end
+} ProfEvent_t;
+
+static ProfEvent_t trace[(PROF_TRACE_SIZE)];
+static uint8_t trace_next = 0;
+static bool trace_wrapped = false;
+#endif /* PROF_TRACE_SIZE */
+
+#ifdef PROF_CLOCK_TIMER1
+static volatile uint16_t overflows = 0;
+
+/* Timer/Counter1 Overflow Interrupt */
+ISR (TIMER1_OVF_vect) { overflows++; }
+#endif /* PROF_CLOCK_TIMER1 */
+
+static uint32_t now_cycles (void);
+static void record_event (uint8_t region, uint32_t cycles);
+static void dump_trace (void (*write) (const char *));
+
+void
+prof_init (void)
+{
+#ifdef PROF_CLOCK_TIMER1
+  /* Normal mode (WGM1 0b0000), clk/1. */
+  pwr_acquire (PWR_TIM1);
+  TCNTR1_CTRL_REGISTER_A = 0;
+  TCNTR1_COUNTER_REGISTER = 0;
+  TCNTR1_INTERRUPT_FLAG_REGISTER = (1 << (TCNTR1_OVERFLOW_FLAG_BIT));
+  TCNTR1_INTERRUPT_MASK_REGISTER
+      = (1 << (TCNTR1_OVERFLOW_INTERRUPT_ENABLE_BIT));
+  TCNTR1_CTRL_REGISTER_B = (1 << (CLOCK_SELECT_BIT_0));
+
+  /* The cheapest of a few empty regions is the markers' own cost. */
+  marker_overhead = 0;
+  prof_reset ();
+  for (uint8_t i = 0; i < (CALIBRATION_RUNS); i++)
+    {
+      prof_begin (0);
+      prof_end (0);
+    }
+  marker_overhead = stats[0].min_cycles;
+#else
+  /* The markers cost less than a timebase step, which would round to 0. */
+  marker_overhead = 0;
+#endif /* PROF_CLOCK_TIMER1 */
+  prof_reset ();
+}
+
+void
+prof_begin (ProfRegion_t id)
+{
+  if ((unsigned)id >= (PROF_REGION_COUNT))
+    return;
+
+  const uint32_t now = now_cycles ();
+  record_event (id, now);
+  begin_cycles[id] = now;
+}
+
+void
+prof_end (ProfRegion_t id)
+{
+  const uint32_t now = now_cycles ();
+
+  if ((unsigned)id >= (PROF_REGION_COUNT))
+    return;
+
+  uint32_t cycles = now - begin_cycles[id];
+  cycles = cycles > marker_overhead ? cycles - marker_overhead : 0;
+
+  ProfStats_t *s = &stats[id];
+  if (s->calls == 0 || cycles < s->min_cycles)
+    s->min_cycles = cycles;
+  if (cycles > s->max_cycles)
+    s->max_cycles = cycles;
+  s->total_cycles += cycles;
+  s->calls++;
+
+  record_event (id | (TRACE_END_FLAG), now);
+}
+
+int8_t
+prof_stats (ProfRegion_t id, ProfStats_t *out)
+{
+  if ((unsigned)id >= (PROF_REGION_COUNT) || out == NULL)
+    return -1;
+
+  *out = stats[id];
+  return 0;
+}
+
+void
+prof_reset (void)
+{
+  for (uint8_t i = 0; i < (PROF_REGION_COUNT); i++)
+    stats[i] = (ProfStats_t){ 0 };
+
+#if PROF_TRACE_SIZE > 0
+  trace_next = 0;
+  trace_wrapped = false;
+#endif /* PROF_TRACE_SIZE */
+}
+
+void
+prof_dump (void (*write) (const char *))
+{
+  char line[(LINE_BUFFER_SIZE)];
+  char name[(NAME_BUFFER_SIZE)];
+
+  snprintf (line, sizeof (line), "prof_clock,%lu\r\n",
+            (unsigned long)(CLOCK_RESOLUTION_CYCLES));
+  write (line);
+
+  for (uint8_t i = 0; i < (PROF_REGION_COUNT); i++)
+    {
+      const ProfStats_t *s = &stats[i];
+      const uint32_t avg
+          = s->calls ? (uint32_t)(s->total_cycles / s->calls) : 0;
+
+      strncpy_P (name, pgm_read_ptr (&REGION_NAMES[i]), sizeof (name) - 1);
+      name[sizeof (name) - 1] = '\0';
+      snprintf (line, sizeof (line), "prof,%s,%lu,%lu,%lu,%lu\r\n", name,
+                (unsigned long)s->calls, (unsigned long)s->min_cycles,
+                (unsigned long)avg, (unsigned long)s->max_cycles);
+      write (line);
+    }
+
+  dump_trace (write);
+}
+
+int8_t
+prof_command (uint8_t cmd, void (*write) (const char *))
+{
+  switch (cmd)
+    {
+    case (DUMP_COMMAND):
+      prof_dump (write);
+      return 0;
+    case (RESET_COMMAND):
+      prof_reset ();
+      return 0;
+    default:
+      return -1;
+    }
+}
+
+uint32_t
+now_cycles (void)
+{
+#ifdef PROF_CLOCK_TIMER1
+  uint16_t high;
+  uint16_t low;
+
+  /* As in `time_now_us`: a pending overflow belongs to a low count. */
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    low = TCNTR1_COUNTER_REGISTER;
+    high = overflows;
+    if ((TCNTR1_INTERRUPT_FLAG_REGISTER & (1 << (TCNTR1_OVERFLOW_FLAG_BIT)))
+        && low < 0x8000)
+      high++;
+  }
+
+  return ((uint32_t)high << 16) | low;
+#else
+  return time_now_us () * (CYCLES_PER_US);
+#endif /* PROF_CLOCK_TIMER1 */
+}
+
+void
+record_event (uint8_t region, uint32_t cycles)
+{
+#if PROF_TRACE_SIZE > 0
+  trace[trace_next].cycles = cycles;
+  trace[trace_next].region = region;
+  trace_next = (trace_next + 1) & ((PROF_TRACE_SIZE)-1);
+  if (trace_next == 0)
+    trace_wrapped = true;
+#else
+  (void)region;
+  (void)cycles;
+#endif /* PROF_TRACE_SIZE */
+}
+
+void
+dump_trace (void (*write) (const char *))
+{
+#if PROF_TRACE_SIZE > 0
+  char line[(LINE_BUFFER_SIZE)];
+  char name[(NAME_BUFFER_SIZE)];
+  const uint8_t count = trace_wrapped ? (PROF_TRACE_SIZE) : trace_next;
+  uint8_t i = trace_wrapped ? trace_next : 0;
+
+  for (uint8_t n = 0; n < count; n++)
+    {
+      const ProfEvent_t *e = &trace[i];
+      const uint8_t region = e->region & ~(TRACE_END_FLAG);
+
+      strncpy_P (name, pgm_read_ptr (&REGION_NAMES[region]),
+                 sizeof (name) - 1);
+      name[sizeof (name) - 1] = '\0';
+      snprintf (line, sizeof (line), "trace,%lu,%s,%s\r\n",
+                (unsigned long)e->cycles, name,
+                (e->region & (TRACE_END_FLAG)) ? "end" : "begin");
+      write (line);
+
+      i = (i + 1) & ((PROF_TRACE_SIZE)-1);
+    }
+#else
+  (void)write;
+#endif /* PROF_TRACE_SIZE */
+}
+
+#endif /* PROF_ENABLED */
@@ -0,0 +1,265 @@
+#include "scheduler.h"
+#include "power.h"
+#include "timebase.h"
+
+#include <stdlib.h>
+#include <util/atomic.h>
+
+typedef struct Task_s
+{
+  TaskFunction_t fn;
+  uint32_t next_run_ms;
+  uint16_t period_ms;
+  uint16_t deadline_ms;
+  uint16_t missed_deadlines;
+  bool active;
+#if LAT_ENABLED
+  LatencyHistogram_t *start_latency;
+  LatencyHistogram_t *run_time;
+#endif /* LAT_ENABLED */
+} Task_t;
+
+static Task_t tasks[(SCHED_MAX_TASKS)];
+
+static bool claim_run (Task_t *t, uint32_t *due_ms);
+static void run_task (Task_t *t, uint32_t due_ms);
+static bool is_valid_task_id (TaskId_t id);
+static void idle (void);
+
+void
+sched_init (void)
+{
+  time_init ();
+}
+
+TaskId_t
+sched_add_task (TaskFunction_t fn, uint16_t delay_ms, uint16_t period_ms,
+                uint16_t deadline_ms)
+{
+  if (fn == NULL)
+    return -1;
+
+  for (TaskId_t id = 0; id < (SCHED_MAX_TASKS); id++)
+    {
+      Task_t *t = &tasks[id];
+      if (t->fn != NULL)
+        continue;
+
+      t->fn = fn;
+      t->next_run_ms = sched_now_ms () + delay_ms;
+      t->period_ms = period_ms;
+      t->deadline_ms = deadline_ms;
+      t->missed_deadlines = 0;
+      t->active = true;
+#if LAT_ENABLED
+      t->start_latency = NULL;
+      t->run_time = NULL;
+#endif /* LAT_ENABLED */
+      return id;
+    }
+
+  return -1;
+}
+
+int8_t
+sched_remove_task (TaskId_t id)
+{
+  if (!is_valid_task_id (id))
+    return -1;
+
+  tasks[id].fn = NULL;
+  tasks[id].active = false;
+#if LAT_ENABLED
+  tasks[id].start_latency = NULL;
+  tasks[id].run_time = NULL;
+#endif /* LAT_ENABLED */
+  return 0;
+}
+
+int8_t
+sched_reschedule (TaskId_t id, uint16_t delay_ms)
+{
+  if (!is_valid_task_id (id))
+    return -1;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    tasks[id].next_run_ms = sched_now_ms () + delay_ms;
+    tasks[id].active = true;
+  }
+
+  return 0;
+}
+
+int8_t
+sched_reschedule_sooner (TaskId_t id, uint16_t delay_ms)
+{
+  if (!is_valid_task_id (id))
+    return -1;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    Task_t *t = &tasks[id];
+    const uint32_t next_run_ms = sched_now_ms () + delay_ms;
+
+    /* Wrap-safe "next_run_ms < t->next_run_ms". */
+    if (!t->active || (int32_t)(next_run_ms - t->next_run_ms) < 0)
+      {
+        t->next_run_ms = next_run_ms;
+        t->active = true;
+      }
+  }
+
+  return 0;
+}
+
+int8_t
+sched_set_period (TaskId_t id, uint16_t period_ms)
+{
+  if (!is_valid_task_id (id))
+    return -1;
+
+  tasks[id].period_ms = period_ms;
+  return 0;
+}
+
+uint16_t
+sched_missed_deadlines (TaskId_t id)
+{
+  return is_valid_task_id (id) ? tasks[id].missed_deadlines : 0;
+}
+
+uint16_t
+sched_total_missed_deadlines (void)
+{
+  uint16_t total = 0;
+
+  for (TaskId_t id = 0; id < (SCHED_MAX_TASKS); id++)
+    total += tasks[id].missed_deadlines;
+
+  return total;
+}
+
+#if LAT_ENABLED
+int8_t
+sched_track_latency (TaskId_t id, LatencyHistogram_t *start_latency,
+                     LatencyHistogram_t *run_time)
+{
+  if (!is_valid_task_id (id))
+    return -1;
+
+  tasks[id].start_latency = start_latency;
+  tasks[id].run_time = run_time;
+  return 0;
+}
+#endif /* LAT_ENABLED */
+
+uint32_t
+sched_now_ms (void)
+{
+  return time_now_ms ();
+}
+
+void
+sched_run (void)
+{
+  while (true)
+    {
+      bool ran_task = false;
+
+      for (TaskId_t id = 0; id < (SCHED_MAX_TASKS); id++)
+        {
+          Task_t *t = &tasks[id];
+          uint32_t due_ms;
+          bool due;
+
+          /* Tasks may be rescheduled from an ISR (see: `sched_reschedule`). */
+          ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { due = claim_run (t, &due_ms); }
+          if (!due)
+            continue;
+
+          run_task (t, due_ms);
+          ran_task = true;
+        }
+
+      if (!ran_task)
+        idle ();
+    }
+}
+
+/*
+ *  If `t` is due, counts a missed deadline if need be and advances (or, for a
+ *  one-shot task, disarms) it.
+ *  @param  due_ms  set to when the run was due
+ *  @return whether `t` should run now.
+ */
+bool
+claim_run (Task_t *t, uint32_t *due_ms)
+{
+  const uint32_t now = sched_now_ms ();
+
+  /* Wrap-safe "now >= next_run_ms". */
+  if (!t->active || (int32_t)(now - t->next_run_ms) < 0)
+    return false;
+
+  *due_ms = t->next_run_ms;
+
+  if (t->deadline_ms != (SCHED_NO_DEADLINE)
+      && now - t->next_run_ms > t->deadline_ms)
+    t->missed_deadlines++;
+
+  if (t->period_ms == 0)
+    {
+      t->active = false;
+    }
+  else
+    {
+      /* Skip (rather than burst through) periods already missed. */
+      t->next_run_ms += t->period_ms;
+      if ((int32_t)(now - t->next_run_ms) >= 0)
+        t->next_run_ms = now + t->period_ms;
+    }
+
+  return true;
+}
+
+/*
+ *  Runs `t`, timing it if it is tracked. The microsecond clock is the
+ *  millisecond one times 1000, wrapped the same way, so the due time carries
+ *  over by multiplying.
+ */
+void
+run_task (Task_t *t, uint32_t due_ms)
+{
+#if LAT_ENABLED
+  LatencyHistogram_t *const run_time = t->run_time;
+  const uint32_t start_us = time_now_us ();
+
+  if (t->start_latency != NULL)
+    lat_record (t->start_latency, start_us - due_ms * 1000UL);
+
+  t->fn ();
+
+  if (run_time != NULL)
+    lat_record (run_time, time_now_us () - start_us);
+#else
+  (void)due_ms;
+  t->fn ();
+#endif /* LAT_ENABLED */
+}
+
+bool
+is_valid_task_id (TaskId_t id)
+{
+  return id >= 0 && id < (SCHED_MAX_TASKS) && tasks[id].fn != NULL;
+}
+
+/*
+ *  Sleeps until the next interrupt (at the latest, the next tick). The tick
+ *  keeps Timer/Counter0 in use, so this is idle mode at its deepest.
+ */
+void
+idle (void)
+{
+  pwr_sleep ();
+}
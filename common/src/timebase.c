@@ -0,0 +1,95 @@
+#include "timebase.h"
+#include "power.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdbool.h>
+#include <util/atomic.h>
+
+#define TCNTR0_CONTROL_REGISTER_A (TCCR0A)
+#define TCNTR0_CONTROL_REGISTER_B (TCCR0B)
+#define TCNTR0_OUTPUT_COMPARE_REGISTER_A (OCR0A)
+#define TCNTR0_INTERRUPT_MASK_REGISTER (TIMSK0)
+#define TCNTR0_INTERRUPT_FLAG_REGISTER (TIFR0)
+#define TCNTR0_COUNTER_REGISTER (TCNT0)
+
+#define WAVEFORM_GENERATION_MODE_BIT_1 (WGM01)
+#define CLOCK_SELECT_BIT_0 (CS00)
+#define CLOCK_SELECT_BIT_1 (CS01)
+#define OUTPUT_COMPARE_A_INTERRUPT_ENABLE_BIT (OCIE0A)
+#define OUTPUT_COMPARE_A_FLAG_BIT (OCF0A)
+
+/*
+ *  CTC mode, clk/64: 16 MHz / 64 / (249 + 1) = 1 kHz.
+ *  see: pg. 79, ATmega328P data sheet.
+ */
+#define TICK_PRESCALER (64UL)
+#define TICK_HZ (1000UL)
+#define TICK_TOP ((F_CPU) / (TICK_PRESCALER) / (TICK_HZ)-1)
+#define US_PER_TICK (1000000UL / (TICK_HZ))
+
+__extension__ _Static_assert (
+    (F_CPU) / (TICK_PRESCALER) == 1000000UL / (TIME_US_PER_COUNT),
+    "TIME_US_PER_COUNT doesn't match the timer clock");
+
+static volatile uint32_t tick_ms = 0;
+/* Kept alongside `tick_ms` so `time_now_us` needs no 32-bit multiply. */
+static volatile uint32_t tick_us = 0;
+
+/* Timer/Counter0 Compare Match A Interrupt */
+ISR (TIMER0_COMPA_vect)
+{
+  tick_ms++;
+  tick_us += (US_PER_TICK);
+}
+
+void
+time_init (void)
+{
+  pwr_acquire (PWR_TIM0);
+
+  TCNTR0_CONTROL_REGISTER_A = (1 << (WAVEFORM_GENERATION_MODE_BIT_1));
+  TCNTR0_OUTPUT_COMPARE_REGISTER_A = (TICK_TOP);
+  TCNTR0_COUNTER_REGISTER = 0;
+  TCNTR0_INTERRUPT_FLAG_REGISTER = (1 << (OUTPUT_COMPARE_A_FLAG_BIT));
+  TCNTR0_INTERRUPT_MASK_REGISTER
+      |= (1 << (OUTPUT_COMPARE_A_INTERRUPT_ENABLE_BIT));
+  TCNTR0_CONTROL_REGISTER_B
+      = (1 << (CLOCK_SELECT_BIT_0)) | (1 << (CLOCK_SELECT_BIT_1));
+}
+
+uint32_t
+time_now_ms (void)
+{
+  uint32_t now;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { now = tick_ms; }
+
+  return now;
+}
+
+uint32_t
+time_now_us (void)
+{
+  uint32_t base;
+  uint8_t count;
+  bool tick_pending;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    base = tick_us;
+    count = TCNTR0_COUNTER_REGISTER;
+    tick_pending = (TCNTR0_INTERRUPT_FLAG_REGISTER)
+                   & (1 << (OUTPUT_COMPARE_A_FLAG_BIT));
+  }
+
+  /*
+   *  The counter may have wrapped with the interrupt still pending (e.g.
+   *  interrupts are disabled here). A small count means the wrap happened
+   *  before the counter was read, so the pending tick belongs to this read.
+   */
+  if (tick_pending && count < (TICK_TOP) / 2)
+    base += (US_PER_TICK);
+
+  return base + (uint16_t)count * (TIME_US_PER_COUNT);
+}
@@ -1,6 +1,9 @@
 #include "uart_hal.h"
+#include "metrics.h"
+#include "power.h"
 
 #include <avr/interrupt.h>
+#include <util/atomic.h>
 
 #define USART_IO_DATA_REGISTER (UDR0)
 
@@ -8,6 +11,7 @@
 #define CONTROL_STATUS_REGISTER_0B (UCSR0B)
 
 /* USART Control and Status Register n A bits.*/
+#define DATA_OVERRUN_BIT (DOR0)
 #define DOUBLE_TRANSMISSION_SPEED_BIT (U2X0)
 
 /* USART Control and Status Register n B bits. */
@@ -26,13 +30,32 @@ static volatile uint8_t rx_buffer[(RX_BUFFER_SIZE)] = { 0 };
 
 static volatile uint16_t rx_count = 0;
 static volatile bool uart_tx_busy = false;
+static bool uart_is_powered = false;
 
-/* USART RX Complete Interrupt */
+/*
+ *  USART RX Complete Interrupt
+ *  A byte arriving to a full buffer is dropped, rather than overwriting one
+ *  yet to be read, and counted as an overrun along with any the hardware saw.
+ */
 ISR (USART_RX_vect)
 {
   static volatile uint16_t rx_write_pos = 0;
 
-  rx_buffer[rx_write_pos] = USART_IO_DATA_REGISTER;
+  /* DOR0 is only valid until UDR0 is read. */
+  const bool hardware_overrun
+      = CONTROL_STATUS_REGISTER_0A & (1 << (DATA_OVERRUN_BIT));
+  const uint8_t data = USART_IO_DATA_REGISTER;
+
+  METRIC_INC (uart_rx_bytes);
+  if (hardware_overrun)
+    METRIC_INC (uart_rx_overruns);
+  if (rx_count >= (RX_BUFFER_SIZE))
+    {
+      METRIC_INC (uart_rx_overruns);
+      return;
+    }
+
+  rx_buffer[rx_write_pos] = data;
   rx_count++;
   rx_write_pos++;
   if (rx_write_pos >= (RX_BUFFER_SIZE))
@@ -49,6 +72,8 @@ uart_init (uint32_t baud_rate, uint8_t high_speed)
 {
   uint8_t speed = 16;
 
+  uart_wake ();
+
   if (high_speed)
     {
       speed = 8;
@@ -79,6 +104,7 @@ uart_send_byte (uint8_t b)
   uart_tx_busy = true;
 
   USART_IO_DATA_REGISTER = b;
+  METRIC_INC (uart_tx_bytes);
 }
 
 void
@@ -111,10 +137,42 @@ uart_send_string (const char *str)
   uart_send_byte (str[i]);
 }
 
+void
+uart_flush (void)
+{
+  while (uart_tx_busy)
+    ;
+}
+
+void
+uart_shutdown (void)
+{
+  if (!uart_is_powered)
+    return;
+
+  uart_flush ();
+  pwr_release (PWR_USART0);
+  uart_is_powered = false;
+}
+
+void
+uart_wake (void)
+{
+  if (uart_is_powered)
+    return;
+
+  pwr_acquire (PWR_USART0);
+  uart_is_powered = true;
+}
+
 uint16_t
 uart_read_count (void)
 {
-  return rx_count;
+  uint16_t count;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { count = rx_count; }
+
+  return count;
 }
 
 uint8_t
@@ -125,7 +183,7 @@ uart_read (void)
 
   data = rx_buffer[rx_read_pos];
   rx_read_pos++;
-  rx_count--;
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { rx_count--; }
   if (rx_read_pos >= (RX_BUFFER_SIZE))
     {
       rx_read_pos = 0;
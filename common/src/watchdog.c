@@ -0,0 +1,117 @@
+#include "watchdog.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <util/atomic.h>
+#include <util/delay.h>
+
+#define MCU_STATUS_REGISTER (MCUSR)
+#define WATCHDOG_RESET_FLAG_BIT (WDRF)
+
+#define WATCHDOG_CONTROL_REGISTER (WDTCSR)
+#define WATCHDOG_INTERRUPT_ENABLE_BIT (WDIE)
+#define WATCHDOG_CHANGE_ENABLE_BIT (WDCE)
+#define WATCHDOG_SYSTEM_RESET_ENABLE_BIT (WDE)
+#define WATCHDOG_PRESCALER_BIT_3 (WDP3)
+
+static volatile uint32_t timeouts = 0;
+
+static uint8_t prescaler_bits (WatchdogPeriod_t period);
+static void write_control_register (uint8_t value);
+#ifdef __AVR__
+static void stop_after_reset (void)
+    __attribute__ ((naked, used, section (".init3")));
+#endif /* __AVR__ */
+
+/* Watchdog Time-out Interrupt */
+ISR (WDT_vect) { timeouts++; }
+
+int8_t
+wdog_start (WatchdogPeriod_t period)
+{
+  if ((unsigned)period > WDOG_8S)
+    return -1;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE)
+  {
+    timeouts = 0;
+    write_control_register ((1 << (WATCHDOG_INTERRUPT_ENABLE_BIT))
+                            | prescaler_bits (period));
+  }
+
+  return 0;
+}
+
+void
+wdog_stop (void)
+{
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { write_control_register (0); }
+}
+
+uint16_t
+wdog_period_ms (WatchdogPeriod_t period)
+{
+  return (uint16_t)16 << period;
+}
+
+uint32_t
+wdog_timeouts (void)
+{
+  uint32_t count;
+
+  ATOMIC_BLOCK (ATOMIC_RESTORESTATE) { count = timeouts; }
+
+  return count;
+}
+
+void
+wdog_reset_system (void)
+{
+  cli ();
+  write_control_register ((1 << (WATCHDOG_SYSTEM_RESET_ENABLE_BIT))
+                          | prescaler_bits (WDOG_16MS));
+
+  for (;;)
+    _delay_ms (1);
+}
+
+/* WDP3 sits apart from WDP2:0 in WDTCSR. */
+uint8_t
+prescaler_bits (WatchdogPeriod_t period)
+{
+  return (period & 0x7)
+         | ((period & 0x8) ? (1 << (WATCHDOG_PRESCALER_BIT_3)) : 0);
+}
+
+/*
+ *  Changing the watchdog configuration is a timed sequence: WDCE and WDE
+ *  have to be set, then the new value written within four cycles. WDRF
+ *  overrides WDE, so it is cleared first.
+ *  see: pg. 60, ATmega328P data sheet.
+ */
+void
+write_control_register (uint8_t value)
+{
+  wdt_reset ();
+  MCU_STATUS_REGISTER &= ~(1 << (WATCHDOG_RESET_FLAG_BIT));
+  WATCHDOG_CONTROL_REGISTER |= (1 << (WATCHDOG_CHANGE_ENABLE_BIT))
+                               | (1 << (WATCHDOG_SYSTEM_RESET_ENABLE_BIT));
+  WATCHDOG_CONTROL_REGISTER = value;
+}
+
+#ifdef __AVR__
+/*
+ *  A watchdog reset leaves the watchdog running at its shortest period, so
+ *  it is stopped before the C runtime starts, or the MCU would keep
+ *  resetting (pg. 61, ATmega328P data sheet). Runs from the .init3 section.
+ */
+void
+stop_after_reset (void)
+{
+  MCU_STATUS_REGISTER = 0;
+  WATCHDOG_CONTROL_REGISTER |= (1 << (WATCHDOG_CHANGE_ENABLE_BIT))
+                               | (1 << (WATCHDOG_SYSTEM_RESET_ENABLE_BIT));
+  WATCHDOG_CONTROL_REGISTER = 0;
+}
+#endif /* __AVR__ */
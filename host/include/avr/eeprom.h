@@ -0,0 +1,19 @@
+/*
+ *  Host EEPROM backend: the simulator holds the contents (see: host_sim.h).
+ *  Addresses are EEPROM addresses cast to pointers, as on the device.
+ */
+#ifndef _HOST_AVR_EEPROM_H_
+#define _HOST_AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint8_t eeprom_read_byte (const uint8_t *addr);
+void eeprom_read_block (void *dst, const void *src, size_t n);
+void eeprom_update_byte (uint8_t *addr, uint8_t value);
+void eeprom_update_block (const void *src, void *dst, size_t n);
+
+#define eeprom_is_ready() (1)
+#define eeprom_busy_wait() ((void)0)
+
+#endif /* _HOST_AVR_EEPROM_H_ */
@@ -0,0 +1,52 @@
+/*
+ *  Host interrupt backend.
+ *  ISRs become ordinary functions that the simulator calls when the matching
+ *  interrupt is enabled and the global interrupt flag (SREG I) is set.
+ */
+#ifndef _HOST_AVR_INTERRUPT_H_
+#define _HOST_AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define SREG_I_BIT (7)
+
+/* Enabling interrupts runs any that became pending while they were off. */
+void host_sim_sei (void);
+
+#define sei() host_sim_sei ()
+#define cli() (SREG &= ~(1 << (SREG_I_BIT)))
+
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define ISR_NAKED
+
+#define ISR(vector, ...)                                                      \
+  void vector (void);                                                         \
+  void vector (void)
+
+#define reti() return
+
+#define INT0_vect host_vect_INT0
+#define INT1_vect host_vect_INT1
+#define PCINT0_vect host_vect_PCINT0
+#define PCINT1_vect host_vect_PCINT1
+#define PCINT2_vect host_vect_PCINT2
+#define WDT_vect host_vect_WDT
+#define TIMER2_COMPA_vect host_vect_TIMER2_COMPA
+#define TIMER2_COMPB_vect host_vect_TIMER2_COMPB
+#define TIMER2_OVF_vect host_vect_TIMER2_OVF
+#define TIMER1_CAPT_vect host_vect_TIMER1_CAPT
+#define TIMER1_COMPA_vect host_vect_TIMER1_COMPA
+#define TIMER1_COMPB_vect host_vect_TIMER1_COMPB
+#define TIMER1_OVF_vect host_vect_TIMER1_OVF
+#define TIMER0_COMPA_vect host_vect_TIMER0_COMPA
+#define TIMER0_COMPB_vect host_vect_TIMER0_COMPB
+#define TIMER0_OVF_vect host_vect_TIMER0_OVF
+#define USART_RX_vect host_vect_USART_RX
+#define USART_UDRE_vect host_vect_USART_UDRE
+#define USART_TX_vect host_vect_USART_TX
+#define ADC_vect host_vect_ADC
+#define EE_READY_vect host_vect_EE_READY
+#define ANALOG_COMP_vect host_vect_ANALOG_COMP
+
+#endif /* _HOST_AVR_INTERRUPT_H_ */
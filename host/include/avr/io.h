@@ -0,0 +1,370 @@
+/*
+ *  Host register backend.
+ *  Maps the ATmega328P I/O registers used by the HALs onto simulated memory so
+ *  that the firmware modules build with the host compiler. Register addresses
+ *  are the data-space addresses from ch. 36 (Register Summary), ATmega328P
+ *  data sheet.
+ */
+#ifndef _HOST_AVR_IO_H_
+#define _HOST_AVR_IO_H_
+
+#include <stdint.h>
+
+typedef union HostSFR_u
+{
+  uint8_t b[0x100];
+  uint16_t w[0x80];
+} HostSFR_t;
+
+extern volatile HostSFR_t host_sfr;
+
+/*
+ *  Registers with side effects (data registers, write-one-to-clear flags)
+ *  are routed through the simulator, which settles the previous access
+ *  before handing out the next. PINx stay plain memory, as their addresses
+ *  go into static tables; the simulator refreshes them, and applies any
+ *  toggles written to them, each time it runs. see: host/src/host_sim.c.
+ */
+volatile uint8_t *host_sfr_access (uint8_t addr);
+
+#define _BV(bit) (1 << (bit))
+#define _SFR_MEM8(addr) (host_sfr.b[(addr)])
+#define _SFR_MEM16(addr) (host_sfr.w[(addr) >> 1])
+#define _SFR_HOOK8(addr) (*host_sfr_access (addr))
+#define _SFR_MEM_ADDR(sfr) ((uint16_t)((const volatile uint8_t *)&(sfr)      \
+                                       - host_sfr.b))
+
+#define PINB _SFR_MEM8 (0x23)
+#define DDRB _SFR_MEM8 (0x24)
+#define PORTB _SFR_MEM8 (0x25)
+#define PINC _SFR_MEM8 (0x26)
+#define DDRC _SFR_MEM8 (0x27)
+#define PORTC _SFR_MEM8 (0x28)
+#define PIND _SFR_MEM8 (0x29)
+#define DDRD _SFR_MEM8 (0x2A)
+#define PORTD _SFR_MEM8 (0x2B)
+#define TIFR0 _SFR_HOOK8 (0x35)
+#define TIFR1 _SFR_HOOK8 (0x36)
+#define TIFR2 _SFR_HOOK8 (0x37)
+#define PCIFR _SFR_HOOK8 (0x3B)
+#define EIFR _SFR_HOOK8 (0x3C)
+#define EIMSK _SFR_MEM8 (0x3D)
+#define GPIOR0 _SFR_MEM8 (0x3E)
+#define EECR _SFR_MEM8 (0x3F)
+#define EEDR _SFR_MEM8 (0x40)
+#define EEARL _SFR_MEM8 (0x41)
+#define EEARH _SFR_MEM8 (0x42)
+#define GTCCR _SFR_MEM8 (0x43)
+#define TCCR0A _SFR_MEM8 (0x44)
+#define TCCR0B _SFR_MEM8 (0x45)
+#define TCNT0 _SFR_MEM8 (0x46)
+#define OCR0A _SFR_MEM8 (0x47)
+#define OCR0B _SFR_MEM8 (0x48)
+#define GPIOR1 _SFR_MEM8 (0x4A)
+#define GPIOR2 _SFR_MEM8 (0x4B)
+#define ACSR _SFR_HOOK8 (0x50)
+#define SMCR _SFR_MEM8 (0x53)
+#define MCUSR _SFR_MEM8 (0x54)
+#define MCUCR _SFR_MEM8 (0x55)
+#define SPL _SFR_MEM8 (0x5D)
+#define SPH _SFR_MEM8 (0x5E)
+#define SREG _SFR_MEM8 (0x5F)
+#define WDTCSR _SFR_MEM8 (0x60)
+#define PRR _SFR_MEM8 (0x64)
+#define PCICR _SFR_MEM8 (0x68)
+#define EICRA _SFR_MEM8 (0x69)
+#define PCMSK0 _SFR_MEM8 (0x6B)
+#define PCMSK1 _SFR_MEM8 (0x6C)
+#define PCMSK2 _SFR_MEM8 (0x6D)
+#define TIMSK0 _SFR_MEM8 (0x6E)
+#define TIMSK1 _SFR_MEM8 (0x6F)
+#define TIMSK2 _SFR_MEM8 (0x70)
+#define ADC _SFR_MEM16 (0x78)
+#define ADCW ADC
+#define ADCL _SFR_MEM8 (0x78)
+#define ADCH _SFR_MEM8 (0x79)
+#define ADCSRA _SFR_HOOK8 (0x7A)
+#define ADCSRB _SFR_MEM8 (0x7B)
+#define ADMUX _SFR_MEM8 (0x7C)
+#define DIDR0 _SFR_MEM8 (0x7E)
+#define DIDR1 _SFR_MEM8 (0x7F)
+#define TCCR1A _SFR_MEM8 (0x80)
+#define TCCR1B _SFR_MEM8 (0x81)
+#define TCCR1C _SFR_MEM8 (0x82)
+#define TCNT1 _SFR_MEM16 (0x84)
+#define ICR1 _SFR_MEM16 (0x86)
+#define OCR1A _SFR_MEM16 (0x88)
+#define OCR1AL _SFR_MEM8 (0x88)
+#define OCR1B _SFR_MEM16 (0x8A)
+#define OCR1BL _SFR_MEM8 (0x8A)
+#define TCCR2A _SFR_MEM8 (0xB0)
+#define TCCR2B _SFR_MEM8 (0xB1)
+#define TCNT2 _SFR_MEM8 (0xB2)
+#define OCR2A _SFR_MEM8 (0xB3)
+#define OCR2B _SFR_MEM8 (0xB4)
+#define ASSR _SFR_MEM8 (0xB6)
+#define UCSR0A _SFR_MEM8 (0xC0)
+#define UCSR0B _SFR_MEM8 (0xC1)
+#define UCSR0C _SFR_MEM8 (0xC2)
+#define UBRR0L _SFR_MEM8 (0xC4)
+#define UBRR0H _SFR_MEM8 (0xC5)
+#define UDR0 _SFR_HOOK8 (0xC6)
+
+#define RAMEND 0x8FF
+#define E2END 0x3FF
+
+/* Port bits */
+#define PINB0 0
+#define PINB1 1
+#define PINB2 2
+#define PINB3 3
+#define PINB4 4
+#define PINB5 5
+#define PINB6 6
+#define PINB7 7
+#define DDB0 0
+#define DDB1 1
+#define DDB2 2
+#define DDB3 3
+#define DDB4 4
+#define DDB5 5
+#define DDB6 6
+#define DDB7 7
+#define PORTB0 0
+#define PORTB1 1
+#define PORTB2 2
+#define PORTB3 3
+#define PORTB4 4
+#define PORTB5 5
+#define PORTB6 6
+#define PORTB7 7
+#define PINC0 0
+#define PINC1 1
+#define PINC2 2
+#define PINC3 3
+#define PINC4 4
+#define PINC5 5
+#define PINC6 6
+#define DDC0 0
+#define DDC1 1
+#define DDC2 2
+#define DDC3 3
+#define DDC4 4
+#define DDC5 5
+#define DDC6 6
+#define PORTC0 0
+#define PORTC1 1
+#define PORTC2 2
+#define PORTC3 3
+#define PORTC4 4
+#define PORTC5 5
+#define PORTC6 6
+#define PIND0 0
+#define PIND1 1
+#define PIND2 2
+#define PIND3 3
+#define PIND4 4
+#define PIND5 5
+#define PIND6 6
+#define PIND7 7
+#define DDD0 0
+#define DDD1 1
+#define DDD2 2
+#define DDD3 3
+#define DDD4 4
+#define DDD5 5
+#define DDD6 6
+#define DDD7 7
+#define PORTD0 0
+#define PORTD1 1
+#define PORTD2 2
+#define PORTD3 3
+#define PORTD4 4
+#define PORTD5 5
+#define PORTD6 6
+#define PORTD7 7
+
+/* Timer/Counter interrupt flag and mask bits */
+#define TOV0 0
+#define OCF0A 1
+#define OCF0B 2
+#define TOIE0 0
+#define OCIE0A 1
+#define OCIE0B 2
+#define TOV1 0
+#define OCF1A 1
+#define OCF1B 2
+#define ICF1 5
+#define TOIE1 0
+#define OCIE1A 1
+#define OCIE1B 2
+#define ICIE1 5
+#define TOV2 0
+#define OCF2A 1
+#define OCF2B 2
+#define TOIE2 0
+#define OCIE2A 1
+#define OCIE2B 2
+
+/* External and pin change interrupts */
+#define INTF0 0
+#define INTF1 1
+#define INT0 0
+#define INT1 1
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+#define PCIF0 0
+#define PCIF1 1
+#define PCIF2 2
+
+/* EEPROM */
+#define EERE 0
+#define EEPE 1
+#define EEMPE 2
+#define EERIE 3
+
+/* General Timer/Counter Control Register */
+#define PSRSYNC 0
+#define PSRASY 1
+#define TSM 7
+
+/* Timer/Counter0 */
+#define WGM00 0
+#define WGM01 1
+#define COM0B0 4
+#define COM0B1 5
+#define COM0A0 6
+#define COM0A1 7
+#define CS00 0
+#define CS01 1
+#define CS02 2
+#define WGM02 3
+#define FOC0B 6
+#define FOC0A 7
+
+/* Timer/Counter1 */
+#define WGM10 0
+#define WGM11 1
+#define COM1B0 4
+#define COM1B1 5
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define ICES1 6
+#define ICNC1 7
+#define FOC1B 6
+#define FOC1A 7
+
+/* Timer/Counter2 */
+#define WGM20 0
+#define WGM21 1
+#define COM2B0 4
+#define COM2B1 5
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+#define FOC2B 6
+#define FOC2A 7
+
+/* Analog comparator */
+#define ACIS0 0
+#define ACIS1 1
+#define ACIC 2
+#define ACIE 3
+#define ACI 4
+#define ACO 5
+#define ACBG 6
+#define ACD 7
+#define ACME 6
+#define AIN0D 0
+#define AIN1D 1
+
+/* Sleep mode, MCU status and control */
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+#define PORF 0
+#define EXTRF 1
+#define BORF 2
+#define WDRF 3
+#define BODSE 5
+#define BODS 6
+
+/* Watchdog */
+#define WDP0 0
+#define WDP1 1
+#define WDP2 2
+#define WDE 3
+#define WDCE 4
+#define WDP3 5
+#define WDIE 6
+#define WDIF 7
+
+/* Power reduction */
+#define PRADC 0
+#define PRUSART0 1
+#define PRSPI 2
+#define PRTIM1 3
+#define PRTIM0 5
+#define PRTIM2 6
+#define PRTWI 7
+#define AS2 5
+#define TCR2BUB 0
+
+/* ADC */
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define ADTS0 0
+#define ADTS1 1
+#define ADTS2 2
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define ADC0D 0
+#define ADC1D 1
+#define ADC2D 2
+
+/* USART0 */
+#define MPCM0 0
+#define U2X0 1
+#define UPE0 2
+#define DOR0 3
+#define FE0 4
+#define UDRE0 5
+#define TXC0 6
+#define RXC0 7
+#define TXB80 0
+#define RXB80 1
+#define UCSZ02 2
+#define TXEN0 3
+#define RXEN0 4
+#define UDRIE0 5
+#define TXCIE0 6
+#define RXCIE0 7
+#define UCSZ00 1
+#define UCSZ01 2
+
+#endif /* _HOST_AVR_IO_H_ */
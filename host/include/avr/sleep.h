@@ -0,0 +1,35 @@
+/* Host sleep backend: sleeping advances simulated time to the next event. */
+#ifndef _HOST_AVR_SLEEP_H_
+#define _HOST_AVR_SLEEP_H_
+
+#include <avr/io.h>
+
+#define SLEEP_MODE_IDLE (0)
+#define SLEEP_MODE_ADC (1 << (SM0))
+#define SLEEP_MODE_PWR_DOWN (1 << (SM1))
+#define SLEEP_MODE_PWR_SAVE ((1 << (SM0)) | (1 << (SM1)))
+#define SLEEP_MODE_STANDBY ((1 << (SM1)) | (1 << (SM2)))
+#define SLEEP_MODE_EXT_STANDBY ((1 << (SM0)) | (1 << (SM1)) | (1 << (SM2)))
+
+void host_sim_sleep (void);
+
+#define set_sleep_mode(mode)                                                  \
+  (SMCR = (SMCR & ~((1 << (SM0)) | (1 << (SM1)) | (1 << (SM2)))) | (mode))
+#define sleep_enable() (SMCR |= (1 << (SE)))
+#define sleep_disable() (SMCR &= ~(1 << (SE)))
+#define sleep_cpu() host_sim_sleep ()
+#define sleep_mode()                                                          \
+  do                                                                          \
+    {                                                                         \
+      sleep_enable ();                                                        \
+      sleep_cpu ();                                                           \
+      sleep_disable ();                                                       \
+    }                                                                         \
+  while (0)
+#define sleep_bod_disable()                                                   \
+  do                                                                          \
+    {                                                                         \
+    }                                                                         \
+  while (0)
+
+#endif /* _HOST_AVR_SLEEP_H_ */
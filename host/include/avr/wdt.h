@@ -0,0 +1,9 @@
+/* Host watchdog backend: the watchdog is modelled by the simulator. */
+#ifndef _HOST_AVR_WDT_H_
+#define _HOST_AVR_WDT_H_
+
+void host_sim_wdt_reset (void);
+
+#define wdt_reset() host_sim_wdt_reset ()
+
+#endif /* _HOST_AVR_WDT_H_ */
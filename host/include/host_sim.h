@@ -0,0 +1,115 @@
+/*
+ *  Host Simulator
+ *  Stands in for the ATmega328P's peripherals when firmware is built with the
+ *  host compiler (`make host`). Registers live in plain memory (see
+ *  avr/io.h); the simulator adds just enough behaviour for the HALs to run:
+ *
+ *    * Timer/Counter0-2 count from the simulated clock in every waveform
+ *      mode used here, raising overflow/compare flags and interrupts.
+ *    * ADC conversions complete as soon as ADSC is polled, with values from
+ *      `host_sim_set_adc` or a source callback, and take their conversion
+ *      time out of the simulated clock.
+ *    * Bytes written to UDR0 go to a sink (stdout by default), and transmit
+ *      complete fires straight away, or after the byte's frame time when
+ *      paced; `host_sim_uart_receive` feeds the RX interrupt.
+ *    * EEPROM: 1 KiB, erased (0xFF) at start, each byte programmed taking
+ *      3.4 ms out of the simulated clock.
+ *    * External, pin change, watchdog and analog comparator interrupts.
+ *    * Sleep advances the clock to the next interrupt; nothing but the
+ *      watchdog and pin interrupts run in power-down.
+ *
+ *  Time only moves in delays, ADC conversions, EEPROM writes and sleep, so
+ *  code between them takes no simulated time. Runs as fast as the host
+ *  allows unless the environment variable HOST_SIM_REALTIME is set.
+ *  HOST_SIM_LIMIT_MS ends the program after that much simulated time. Other
+ *  variables:
+ *
+ *    HOST_SIM_ADC   "<value>" for every ADC channel, or
+ *                   "<low>:<high>[:<period ms>[:<noise>]]" to sweep each
+ *                   channel up and down between the two (a period of 10 s
+ *                   by default), a little out of step with the others and
+ *                   with up to +/-<noise> added.
+ *    HOST_SIM_BAUD  paces the UART: each byte takes its frame time at this
+ *                   rate, or at the rate set in UBRR0 for "auto".
+ *    HOST_SIM_PTY   serves the UART on a pseudo-terminal instead of
+ *                   stdout, linked from this path unless it's empty, so
+ *                   host tools can talk to the program as to a board.
+ *                   Output waits while nothing reads it. A symlink already
+ *                   at the path is replaced; anything else is an error.
+ *    HOST_SIM_EEPROM  keeps the EEPROM in this file: loaded at start, and
+ *                   saved after each write, so settings outlive a run.
+ */
+#ifndef _HOST_SIM_H_
+#define _HOST_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum HostPort_e
+{
+  HOST_PORT_B,
+  HOST_PORT_C,
+  HOST_PORT_D,
+  HOST_PORT_COUNT
+} HostPort_t;
+
+/* @return simulated microseconds since start up. */
+uint64_t host_sim_now_us (void);
+
+/*
+ *  Runs the simulated clock forward, clocking the timers and watchdog and
+ *  running any interrupts they raise.
+ *  @param  us  microseconds to advance by
+ */
+void host_sim_advance_us (uint32_t us);
+
+/* Runs the clock until an interrupt has been serviced; see `sleep_cpu`. */
+void host_sim_sleep (void);
+
+/*
+ *  Drives an input pin from outside, raising the external or pin change
+ *  interrupt if it is enabled for the pin. Undriven inputs read their
+ *  pull-up.
+ *  @param  port   the pin's port
+ *  @param  bit    the pin's bit, 0-7
+ *  @param  level  true for high
+ */
+void host_sim_set_pin (HostPort_t port, uint8_t bit, bool level);
+
+/*
+ *  Sets the reading of an ADC channel.
+ *  @param  channel  the MUX3:0 channel, 0-8
+ *  @param  value    the 10-bit (right adjusted) result
+ */
+void host_sim_set_adc (uint8_t channel, uint16_t value);
+
+/*
+ *  Takes ADC readings from a callback rather than `host_sim_set_adc`.
+ *  @param  source  called once per conversion with the MUX3:0 channel, or
+ *                  NULL to go back to the fixed values
+ */
+void host_sim_set_adc_source (uint16_t (*source) (uint8_t channel));
+
+/*
+ *  Redirects transmitted bytes.
+ *  @param  sink  called once per byte written to UDR0, or NULL for stdout
+ */
+void host_sim_set_uart_sink (void (*sink) (uint8_t byte));
+
+/*
+ *  Delivers a received byte through the RX complete interrupt. Bytes are
+ *  dropped while the receiver is disabled.
+ */
+void host_sim_uart_receive (uint8_t byte);
+
+/*
+ *  Sets the analog comparator output (ACO), raising its interrupt on the
+ *  edges selected by ACIS1:0.
+ *  @param  output  true while the positive input is above the negative
+ */
+void host_sim_set_comparator (bool output);
+
+/* Hands any byte still held in UDR0 to the sink. */
+void host_sim_flush (void);
+
+#endif /* _HOST_SIM_H_ */
@@ -0,0 +1,40 @@
+/* Host version of avr-libc's <util/atomic.h>. */
+#ifndef _HOST_UTIL_ATOMIC_H_
+#define _HOST_UTIL_ATOMIC_H_
+
+#include <avr/interrupt.h>
+#include <stdint.h>
+
+static inline uint8_t
+host_atomic_begin (void)
+{
+  const uint8_t sreg = SREG;
+  cli ();
+  return 1 | (uint8_t)(sreg & (1 << (SREG_I_BIT)));
+}
+
+static inline void
+host_atomic_restore (const uint8_t *s)
+{
+  if (*s & (1 << (SREG_I_BIT)))
+    sei ();
+}
+
+static inline void
+host_atomic_force_on (const uint8_t *s)
+{
+  (void)s;
+  sei ();
+}
+
+#define ATOMIC_RESTORESTATE                                                   \
+  uint8_t host_atomic_state __attribute__ ((cleanup (host_atomic_restore)))   \
+      = host_atomic_begin ()
+#define ATOMIC_FORCEON                                                        \
+  uint8_t host_atomic_state __attribute__ ((cleanup (host_atomic_force_on)))  \
+      = host_atomic_begin ()
+
+#define ATOMIC_BLOCK(type)                                                    \
+  for (type, host_atomic_once = 1; host_atomic_once; host_atomic_once = 0)
+
+#endif /* _HOST_UTIL_ATOMIC_H_ */
@@ -0,0 +1,17 @@
+/* Host CRC backend: the C equivalents given in avr-libc's util/crc16.h. */
+#ifndef _HOST_UTIL_CRC16_H_
+#define _HOST_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+static inline uint16_t
+_crc16_update (uint16_t crc, uint8_t a)
+{
+  crc ^= a;
+  for (uint8_t i = 0; i < 8; i++)
+    crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : (crc >> 1);
+
+  return crc;
+}
+
+#endif /* _HOST_UTIL_CRC16_H_ */
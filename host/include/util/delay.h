@@ -0,0 +1,12 @@
+/* Host busy-wait backend: delays advance simulated time instead. */
+#ifndef _HOST_UTIL_DELAY_H_
+#define _HOST_UTIL_DELAY_H_
+
+#include <stdint.h>
+
+void host_sim_advance_us (uint32_t us);
+
+#define _delay_ms(ms) host_sim_advance_us ((uint32_t)(ms) * 1000UL)
+#define _delay_us(us) host_sim_advance_us ((uint32_t)(us))
+
+#endif /* _HOST_UTIL_DELAY_H_ */
@@ -0,0 +1,1420 @@
+#define _XOPEN_SOURCE 600
+
+#include "host_sim.h"
+
+#include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define CYCLES_PER_US ((F_CPU) / 1000000UL)
+
+/* The clock advances in steps of this much, running interrupts in between. */
+#define STEP_US (16)
+
+/* A start bit, eight data bits and a stop bit. */
+#define UART_FRAME_BITS (10)
+/* Bytes read from the pseudo-terminal at once, and steps between reads. */
+#define PTY_QUEUE_SIZE (64)
+#define PTY_POLL_STEPS (64)
+/* The largest (10-bit, right adjusted) ADC reading. */
+#define ADC_MAX (1023)
+/* Swept channels are spread this many to a period. */
+#define ADC_SWEEP_PHASES (8)
+#define ADC_SWEEP_DEFAULT_PERIOD_MS (10000)
+/* Programming one EEPROM byte (erase and write) takes 3.4 ms (Table 8-1). */
+#define EEPROM_SIZE ((E2END) + 1)
+#define EEPROM_WRITE_US (3400)
+
+/* Data-space addresses of the registers the simulator acts on. */
+#define ADDR_PINB (0x23)
+#define ADDR_DDRB (0x24)
+#define ADDR_PORTB (0x25)
+#define ADDR_TIFR0 (0x35)
+#define ADDR_TIFR1 (0x36)
+#define ADDR_TIFR2 (0x37)
+#define ADDR_PCIFR (0x3B)
+#define ADDR_EIFR (0x3C)
+#define ADDR_EIMSK (0x3D)
+#define ADDR_EECR (0x3F)
+#define ADDR_TCCR0A (0x44)
+#define ADDR_TCCR0B (0x45)
+#define ADDR_TCNT0 (0x46)
+#define ADDR_OCR0A (0x47)
+#define ADDR_OCR0B (0x48)
+#define ADDR_ACSR (0x50)
+#define ADDR_SMCR (0x53)
+#define ADDR_MCUSR (0x54)
+#define ADDR_SREG (0x5F)
+#define ADDR_WDTCSR (0x60)
+#define ADDR_PRR (0x64)
+#define ADDR_PCICR (0x68)
+#define ADDR_EICRA (0x69)
+#define ADDR_PCMSK0 (0x6B)
+#define ADDR_TIMSK0 (0x6E)
+#define ADDR_TIMSK1 (0x6F)
+#define ADDR_TIMSK2 (0x70)
+#define ADDR_ADC (0x78)
+#define ADDR_ADCSRA (0x7A)
+#define ADDR_ADMUX (0x7C)
+#define ADDR_TCCR1A (0x80)
+#define ADDR_TCCR1B (0x81)
+#define ADDR_TCNT1 (0x84)
+#define ADDR_ICR1 (0x86)
+#define ADDR_OCR1A (0x88)
+#define ADDR_OCR1B (0x8A)
+#define ADDR_TCCR2A (0xB0)
+#define ADDR_TCCR2B (0xB1)
+#define ADDR_TCNT2 (0xB2)
+#define ADDR_OCR2A (0xB3)
+#define ADDR_OCR2B (0xB4)
+#define ADDR_UCSR0A (0xC0)
+#define ADDR_UCSR0B (0xC1)
+#define ADDR_UBRR0L (0xC4)
+#define ADDR_UBRR0H (0xC5)
+#define ADDR_UDR0 (0xC6)
+
+#define REG(addr) (host_sfr.b[(addr)])
+#define REG16(addr) (host_sfr.w[(addr) >> 1])
+
+#define NO_REGISTER (0)
+
+/*
+ *  In priority order, as in the vector table.
+ *  see: pg. 49, ATmega328P data sheet.
+ */
+typedef enum Vector_e
+{
+  V_INT0,
+  V_INT1,
+  V_PCINT0,
+  V_PCINT1,
+  V_PCINT2,
+  V_WDT,
+  V_TIMER2_COMPA,
+  V_TIMER2_COMPB,
+  V_TIMER2_OVF,
+  V_TIMER1_CAPT,
+  V_TIMER1_COMPA,
+  V_TIMER1_COMPB,
+  V_TIMER1_OVF,
+  V_TIMER0_COMPA,
+  V_TIMER0_COMPB,
+  V_TIMER0_OVF,
+  V_USART_RX,
+  V_USART_UDRE,
+  V_USART_TX,
+  V_ADC,
+  V_EE_READY,
+  V_ANALOG_COMP,
+  V_COUNT
+} Vector_t;
+
+/* Weak, so an image only needs to define the ISRs it uses. */
+#define WEAK __attribute__ ((weak))
+void host_vect_INT0 (void) WEAK;
+void host_vect_INT1 (void) WEAK;
+void host_vect_PCINT0 (void) WEAK;
+void host_vect_PCINT1 (void) WEAK;
+void host_vect_PCINT2 (void) WEAK;
+void host_vect_WDT (void) WEAK;
+void host_vect_TIMER2_COMPA (void) WEAK;
+void host_vect_TIMER2_COMPB (void) WEAK;
+void host_vect_TIMER2_OVF (void) WEAK;
+void host_vect_TIMER1_CAPT (void) WEAK;
+void host_vect_TIMER1_COMPA (void) WEAK;
+void host_vect_TIMER1_COMPB (void) WEAK;
+void host_vect_TIMER1_OVF (void) WEAK;
+void host_vect_TIMER0_COMPA (void) WEAK;
+void host_vect_TIMER0_COMPB (void) WEAK;
+void host_vect_TIMER0_OVF (void) WEAK;
+void host_vect_USART_RX (void) WEAK;
+void host_vect_USART_UDRE (void) WEAK;
+void host_vect_USART_TX (void) WEAK;
+void host_vect_ADC (void) WEAK;
+void host_vect_EE_READY (void) WEAK;
+void host_vect_ANALOG_COMP (void) WEAK;
+
+typedef struct HostVector_s
+{
+  void (*isr) (void);
+  uint8_t flag_addr; // NO_REGISTER if the interrupt has no flag
+  uint8_t flag_bit;
+  uint8_t mask_addr;
+  uint8_t mask_bit;
+  bool level; // Stays pending while its condition holds
+  const char *name;
+} HostVector_t;
+
+static const HostVector_t VECTORS[(V_COUNT)] = {
+  [V_INT0] = { host_vect_INT0, ADDR_EIFR, INTF0, ADDR_EIMSK, INT0, false,
+               "INT0" },
+  [V_INT1] = { host_vect_INT1, ADDR_EIFR, INTF1, ADDR_EIMSK, INT1, false,
+               "INT1" },
+  [V_PCINT0] = { host_vect_PCINT0, ADDR_PCIFR, PCIF0, ADDR_PCICR, PCIE0,
+                 false, "PCINT0" },
+  [V_PCINT1] = { host_vect_PCINT1, ADDR_PCIFR, PCIF1, ADDR_PCICR, PCIE1,
+                 false, "PCINT1" },
+  [V_PCINT2] = { host_vect_PCINT2, ADDR_PCIFR, PCIF2, ADDR_PCICR, PCIE2,
+                 false, "PCINT2" },
+  [V_WDT] = { host_vect_WDT, ADDR_WDTCSR, WDIF, ADDR_WDTCSR, WDIE, false,
+              "WDT" },
+  [V_TIMER2_COMPA] = { host_vect_TIMER2_COMPA, ADDR_TIFR2, OCF2A,
+                       ADDR_TIMSK2, OCIE2A, false, "TIMER2_COMPA" },
+  [V_TIMER2_COMPB] = { host_vect_TIMER2_COMPB, ADDR_TIFR2, OCF2B,
+                       ADDR_TIMSK2, OCIE2B, false, "TIMER2_COMPB" },
+  [V_TIMER2_OVF] = { host_vect_TIMER2_OVF, ADDR_TIFR2, TOV2, ADDR_TIMSK2,
+                     TOIE2, false, "TIMER2_OVF" },
+  [V_TIMER1_CAPT] = { host_vect_TIMER1_CAPT, ADDR_TIFR1, ICF1, ADDR_TIMSK1,
+                      ICIE1, false, "TIMER1_CAPT" },
+  [V_TIMER1_COMPA] = { host_vect_TIMER1_COMPA, ADDR_TIFR1, OCF1A,
+                       ADDR_TIMSK1, OCIE1A, false, "TIMER1_COMPA" },
+  [V_TIMER1_COMPB] = { host_vect_TIMER1_COMPB, ADDR_TIFR1, OCF1B,
+                       ADDR_TIMSK1, OCIE1B, false, "TIMER1_COMPB" },
+  [V_TIMER1_OVF] = { host_vect_TIMER1_OVF, ADDR_TIFR1, TOV1, ADDR_TIMSK1,
+                     TOIE1, false, "TIMER1_OVF" },
+  [V_TIMER0_COMPA] = { host_vect_TIMER0_COMPA, ADDR_TIFR0, OCF0A,
+                       ADDR_TIMSK0, OCIE0A, false, "TIMER0_COMPA" },
+  [V_TIMER0_COMPB] = { host_vect_TIMER0_COMPB, ADDR_TIFR0, OCF0B,
+                       ADDR_TIMSK0, OCIE0B, false, "TIMER0_COMPB" },
+  [V_TIMER0_OVF] = { host_vect_TIMER0_OVF, ADDR_TIFR0, TOV0, ADDR_TIMSK0,
+                     TOIE0, false, "TIMER0_OVF" },
+  [V_USART_RX] = { host_vect_USART_RX, ADDR_UCSR0A, RXC0, ADDR_UCSR0B,
+                   RXCIE0, false, "USART_RX" },
+  [V_USART_UDRE] = { host_vect_USART_UDRE, ADDR_UCSR0A, UDRE0, ADDR_UCSR0B,
+                     UDRIE0, true, "USART_UDRE" },
+  [V_USART_TX] = { host_vect_USART_TX, ADDR_UCSR0A, TXC0, ADDR_UCSR0B,
+                   TXCIE0, false, "USART_TX" },
+  [V_ADC] = { host_vect_ADC, ADDR_ADCSRA, ADIF, ADDR_ADCSRA, ADIE, false,
+              "ADC" },
+  [V_EE_READY] = { host_vect_EE_READY, NO_REGISTER, 0, ADDR_EECR, EERIE,
+                   true, "EE_READY" },
+  [V_ANALOG_COMP] = { host_vect_ANALOG_COMP, ADDR_ACSR, ACI, ADDR_ACSR, ACIE,
+                      false, "ANALOG_COMP" },
+};
+
+typedef enum TimerKind_e
+{
+  TIMER_NORMAL, // Count to TOP, overflow at MAX
+  TIMER_CTC,    // Clear at TOP, overflow only if TOP is MAX
+  TIMER_FAST,   // Count to TOP, overflow at TOP
+  TIMER_PHASE,  // Count up to TOP and back, overflow at BOTTOM
+} TimerKind_t;
+
+typedef struct HostTimer_s
+{
+  uint8_t tccra;
+  uint8_t tccrb;
+  uint8_t tcnt;
+  uint8_t ocra;
+  uint8_t ocrb;
+  bool wide; // 16-bit
+  uint8_t prr_bit;
+  const uint16_t *divisors; // Indexed by CS2:0, 0 where not clocked
+  Vector_t ovf;
+  Vector_t compa;
+  Vector_t compb;
+  uint32_t prescaler_cycles;
+  bool counting_down;
+} HostTimer_t;
+
+static const uint16_t DIVISORS_0_1[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+static const uint16_t DIVISORS_2[8] = { 0, 1, 8, 32, 64, 128, 256, 1024 };
+
+enum
+{
+  TIMER_0,
+  TIMER_1,
+  TIMER_2,
+  TIMER_COUNT
+};
+
+/* A triangle wave from `low` to `high` and back, plus up to +/-`noise`. */
+typedef struct HostAdcSweep_s
+{
+  uint16_t low;
+  uint16_t high;
+  uint16_t noise;
+  uint32_t period_us; // 0 for fixed readings
+} HostAdcSweep_t;
+
+static HostTimer_t timers[TIMER_COUNT] = {
+  [TIMER_0] = { ADDR_TCCR0A, ADDR_TCCR0B, ADDR_TCNT0, ADDR_OCR0A, ADDR_OCR0B,
+                false, PRTIM0, DIVISORS_0_1, V_TIMER0_OVF, V_TIMER0_COMPA,
+                V_TIMER0_COMPB, 0, false },
+  [TIMER_1] = { ADDR_TCCR1A, ADDR_TCCR1B, ADDR_TCNT1, ADDR_OCR1A, ADDR_OCR1B,
+                true, PRTIM1, DIVISORS_0_1, V_TIMER1_OVF, V_TIMER1_COMPA,
+                V_TIMER1_COMPB, 0, false },
+  [TIMER_2] = { ADDR_TCCR2A, ADDR_TCCR2B, ADDR_TCNT2, ADDR_OCR2A, ADDR_OCR2B,
+                false, PRTIM2, DIVISORS_2, V_TIMER2_OVF, V_TIMER2_COMPA,
+                V_TIMER2_COMPB, 0, false },
+};
+
+volatile HostSFR_t host_sfr;
+
+static uint64_t now_us = 0;
+static uint64_t limit_us = 0;
+static bool realtime = false;
+static struct timespec start_time;
+
+static uint32_t pending = 0;
+static uint32_t dispatched = 0;
+static bool in_isr = false;
+static bool in_rx_isr = false;
+
+/* The hooked access in progress, settled by the next simulator call. */
+static int16_t open_addr = -1;
+static uint8_t open_preload = 0;
+
+static uint8_t pin_levels[(HOST_PORT_COUNT)];
+static uint8_t pin_published[(HOST_PORT_COUNT)];
+static uint8_t pin_driven[(HOST_PORT_COUNT)];
+/* DDRx and PORTx as last synced, and whether the inputs have changed since. */
+static uint8_t pin_ddr_synced[(HOST_PORT_COUNT)];
+static uint8_t pin_port_synced[(HOST_PORT_COUNT)];
+static bool pin_inputs_changed = true;
+
+static uint16_t adc_values[16];
+static uint16_t (*adc_source) (uint8_t channel) = NULL;
+static HostAdcSweep_t adc_sweep = { 0 };
+static bool adc_converting = false;
+static uint64_t adc_done_us = 0;
+
+static void (*uart_sink) (uint8_t byte) = NULL;
+static uint8_t uart_rx_byte = 0;
+static bool uart_paced = false;
+static uint32_t uart_baud = 0;  // 0 to take the rate from UBRR0
+static uint32_t uart_owed = 0;  // Cycles of frame time not yet run
+static uint64_t uart_rx_us = 0; // When the receiver is next free
+static int pty_master = -1;
+static const char *pty_link = NULL;
+
+static uint32_t wdt_elapsed_us = 0;
+
+static uint8_t eeprom[(EEPROM_SIZE)];
+static const char *eeprom_path = NULL;
+
+static void init (void) __attribute__ ((constructor));
+static void settle (void);
+static void prepare (uint8_t addr);
+static uint8_t flag_mask (uint8_t addr);
+static uint8_t pending_flags (uint8_t addr);
+static void raise_interrupt (Vector_t v);
+static void lower_interrupt (Vector_t v);
+static void dispatch (void);
+static void step (uint32_t us, uint8_t sleep_mode, bool asleep);
+static void clock_timer (HostTimer_t *t, uint32_t cycles);
+static uint32_t timer_top (const HostTimer_t *t, TimerKind_t *kind);
+static uint32_t timer_read (const HostTimer_t *t, uint8_t addr);
+static void timer_write (const HostTimer_t *t, uint8_t addr, uint32_t value);
+static void clock_watchdog (uint32_t us);
+static void start_conversion (void);
+static void finish_conversion (void);
+static void sync_pins (void);
+static uint8_t pin_value (HostPort_t port);
+static void edge_interrupts (HostPort_t port, uint8_t bit, bool level);
+static void emit (uint8_t byte);
+static uint32_t frame_cycles (void);
+static void parse_adc (const char *value);
+static uint16_t sweep_reading (uint8_t channel);
+static void open_pty (const char *link);
+static void poll_pty (void);
+static void remove_pty_link (void);
+static void load_eeprom (const char *path);
+static bool program_eeprom (uint16_t addr, uint8_t value);
+static void save_eeprom (void);
+static void pace (void);
+static void check_limit (void);
+
+/*
+ *  Settles the previous hooked access, does whatever reading `addr` implies
+ *  (finishing an ADC conversion, taking a received byte, ...) and hands out
+ *  the register for the caller to read or write. Writes are told from reads
+ *  by comparing the register with what was loaded into it, so a store of
+ *  the value just read is taken for a read. Unused flag bits read as ones
+ *  to keep that from hiding a flag clear.
+ */
+volatile uint8_t *
+host_sfr_access (uint8_t addr)
+{
+  settle ();
+  prepare (addr);
+  /* Preparing can run interrupts, whose own accesses are settled here. */
+  settle ();
+
+  if (addr == ADDR_UDR0 && in_rx_isr)
+    REG (addr) = uart_rx_byte;
+  else
+    {
+      const uint8_t mask = flag_mask (addr);
+      if (mask)
+        REG (addr) = (REG (addr) & ~mask) | pending_flags (addr)
+                     | (addr == ADDR_ACSR || addr == ADDR_ADCSRA ? 0 : ~mask);
+
+      open_addr = addr;
+      open_preload = REG (addr);
+    }
+
+  return &host_sfr.b[addr];
+}
+
+void
+host_sim_sei (void)
+{
+  settle ();
+  REG (ADDR_SREG) |= (1 << (SREG_I_BIT));
+  dispatch ();
+}
+
+uint64_t
+host_sim_now_us (void)
+{
+  return now_us;
+}
+
+void
+host_sim_advance_us (uint32_t us)
+{
+  settle ();
+
+  while (us > 0)
+    {
+      const uint32_t slice = us < (STEP_US) ? us : (STEP_US);
+      step (slice, 0, false);
+      us -= slice;
+    }
+
+  pace ();
+}
+
+void
+host_sim_sleep (void)
+{
+  settle ();
+
+  /* Without SE, SLEEP is a no-op. */
+  if (!(REG (ADDR_SMCR) & (1 << (SE))))
+    return;
+
+  if (!(REG (ADDR_SREG) & (1 << (SREG_I_BIT))))
+    {
+      host_sim_flush ();
+      fprintf (stderr, "host_sim: sleeping with interrupts disabled\n");
+      exit (EXIT_FAILURE);
+    }
+
+  const uint8_t mode = REG (ADDR_SMCR) & ((1 << (SM0)) | (1 << (SM1))
+                                          | (1 << (SM2)));
+  const uint32_t woken_by = dispatched;
+
+  fflush (stdout);
+  while (dispatched == woken_by)
+    step ((STEP_US), mode, true);
+
+  pace ();
+}
+
+void
+host_sim_set_pin (HostPort_t port, uint8_t bit, bool level)
+{
+  if ((unsigned)port >= (HOST_PORT_COUNT) || bit > 7)
+    return;
+
+  settle ();
+
+  const uint8_t mask = (1 << bit);
+  const uint8_t before = pin_value (port);
+
+  pin_driven[port] |= mask;
+  if (level)
+    pin_levels[port] |= mask;
+  else
+    pin_levels[port] &= ~mask;
+  pin_inputs_changed = true;
+
+  if ((before ^ pin_value (port)) & mask)
+    edge_interrupts (port, bit, level);
+
+  sync_pins ();
+
+  dispatch ();
+}
+
+void
+host_sim_set_adc (uint8_t channel, uint16_t value)
+{
+  if (channel < 16)
+    adc_values[channel] = value > (ADC_MAX) ? (ADC_MAX) : value;
+}
+
+void
+host_sim_set_adc_source (uint16_t (*source) (uint8_t channel))
+{
+  adc_source = source;
+}
+
+void
+host_sim_set_uart_sink (void (*sink) (uint8_t byte))
+{
+  uart_sink = sink;
+}
+
+void
+host_sim_uart_receive (uint8_t byte)
+{
+  settle ();
+
+  if (!(REG (ADDR_UCSR0B) & (1 << (RXEN0))))
+    return;
+
+  uart_rx_byte = byte;
+  raise_interrupt (V_USART_RX);
+  dispatch ();
+}
+
+void
+host_sim_set_comparator (bool output)
+{
+  settle ();
+
+  const uint8_t acsr = REG (ADDR_ACSR);
+  const bool before = acsr & (1 << (ACO));
+
+  REG (ADDR_ACSR) = output ? (acsr | (1 << (ACO))) : (acsr & ~(1 << (ACO)));
+
+  if (before == output || (acsr & (1 << (ACD))))
+    return;
+
+  const uint8_t edges = acsr & ((1 << (ACIS1)) | (1 << (ACIS0)));
+  if (edges == 0 || (edges == (1 << (ACIS1)) && !output)
+      || (edges == ((1 << (ACIS1)) | (1 << (ACIS0))) && output))
+    raise_interrupt (V_ANALOG_COMP);
+
+  dispatch ();
+}
+
+void
+host_sim_flush (void)
+{
+  settle ();
+  fflush (stdout);
+}
+
+void
+host_sim_wdt_reset (void)
+{
+  wdt_elapsed_us = 0;
+}
+
+/* Addresses wrap at the end of the EEPROM, as they do on the device. */
+uint8_t
+eeprom_read_byte (const uint8_t *addr)
+{
+  return eeprom[(uintptr_t)addr & (E2END)];
+}
+
+void
+eeprom_read_block (void *dst, const void *src, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    ((uint8_t *)dst)[i] = eeprom_read_byte ((const uint8_t *)src + i);
+}
+
+void
+eeprom_update_byte (uint8_t *addr, uint8_t value)
+{
+  if (program_eeprom ((uintptr_t)addr & (E2END), value))
+    save_eeprom ();
+}
+
+void
+eeprom_update_block (const void *src, void *dst, size_t n)
+{
+  bool changed = false;
+
+  for (size_t i = 0; i < n; i++)
+    changed |= program_eeprom (((uintptr_t)dst + i) & (E2END),
+                               ((const uint8_t *)src)[i]);
+
+  if (changed)
+    save_eeprom ();
+}
+
+void
+init (void)
+{
+  const char *value;
+
+  clock_gettime (CLOCK_MONOTONIC, &start_time);
+
+  if ((value = getenv ("HOST_SIM_LIMIT_MS")) != NULL)
+    limit_us = strtoull (value, NULL, 10) * 1000ULL;
+  if ((value = getenv ("HOST_SIM_REALTIME")) != NULL)
+    realtime = (value[0] != '\0' && value[0] != '0');
+  if ((value = getenv ("HOST_SIM_ADC")) != NULL)
+    parse_adc (value);
+  if ((value = getenv ("HOST_SIM_BAUD")) != NULL && value[0] != '\0')
+    {
+      uart_paced = true;
+      uart_baud = strcmp (value, "auto") ? strtoul (value, NULL, 10) : 0;
+    }
+  if ((value = getenv ("HOST_SIM_PTY")) != NULL)
+    open_pty (value);
+  load_eeprom (getenv ("HOST_SIM_EEPROM"));
+
+  /* Power-on values; the transmitter is always ready for the next byte. */
+  REG (ADDR_MCUSR) = (1 << (PORF));
+  REG (ADDR_ACSR) = 0;
+  pending |= (1UL << V_USART_UDRE) | (1UL << V_EE_READY);
+  REG (ADDR_UCSR0A) = (1 << (UDRE0));
+  /* The RESET pin is pulled up. */
+  pin_levels[HOST_PORT_C] = (1 << 6);
+  pin_driven[HOST_PORT_C] = (1 << 6);
+
+  atexit (host_sim_flush);
+}
+
+void
+settle (void)
+{
+  sync_pins ();
+
+  if (open_addr < 0)
+    return;
+
+  const uint8_t addr = (uint8_t)open_addr;
+  const uint8_t value = REG (addr);
+  const uint8_t preload = open_preload;
+  const uint8_t mask = flag_mask (addr);
+  open_addr = -1;
+
+  if (addr == ADDR_UDR0)
+    {
+      emit (value);
+      return;
+    }
+
+  if (value != preload)
+    {
+      /* Flags are cleared by writing a one to them. */
+      for (Vector_t v = 0; v < (V_COUNT); v++)
+        if (VECTORS[v].flag_addr == addr
+            && (value & (1 << VECTORS[v].flag_bit)))
+          lower_interrupt (v);
+
+      if (addr == ADDR_ADCSRA)
+        {
+          if (!(value & (1 << (ADEN))))
+            adc_converting = false;
+          else if ((value & (1 << (ADSC))) && !adc_converting)
+            start_conversion ();
+        }
+    }
+
+  REG (addr) = (value & ~mask) | pending_flags (addr);
+  if (addr == ADDR_ADCSRA)
+    REG (addr) = (REG (addr) & ~(1 << (ADSC)))
+                 | (adc_converting ? (1 << (ADSC)) : 0);
+}
+
+void
+prepare (uint8_t addr)
+{
+  switch (addr)
+    {
+    case ADDR_ADCSRA:
+      /* Polling a conversion waits it out. */
+      if (adc_converting && adc_done_us > now_us)
+        host_sim_advance_us ((uint32_t)(adc_done_us - now_us));
+      break;
+    case ADDR_UDR0:
+      if (in_rx_isr)
+        {
+          lower_interrupt (V_USART_RX);
+          break;
+        }
+      /*
+       *  The byte is complete before it's sent: straight away, or once its
+       *  frame time has run when paced.
+       */
+      if (REG (ADDR_UCSR0B) & (1 << (TXEN0)))
+        {
+          if (uart_paced)
+            {
+              uart_owed += frame_cycles ();
+              host_sim_advance_us (uart_owed / (CYCLES_PER_US));
+              uart_owed %= (CYCLES_PER_US);
+            }
+          raise_interrupt (V_USART_TX);
+          dispatch ();
+        }
+      break;
+    default:
+      break;
+    }
+}
+
+uint8_t
+flag_mask (uint8_t addr)
+{
+  switch (addr)
+    {
+    case ADDR_TIFR0:
+    case ADDR_TIFR1:
+    case ADDR_TIFR2:
+    case ADDR_PCIFR:
+    case ADDR_EIFR:
+    case ADDR_ACSR:
+    case ADDR_ADCSRA:
+      break;
+    default:
+      return 0;
+    }
+
+  uint8_t mask = 0;
+  for (Vector_t v = 0; v < (V_COUNT); v++)
+    if (VECTORS[v].flag_addr == addr)
+      mask |= (1 << VECTORS[v].flag_bit);
+
+  return mask;
+}
+
+uint8_t
+pending_flags (uint8_t addr)
+{
+  uint8_t flags = 0;
+
+  for (Vector_t v = 0; v < (V_COUNT); v++)
+    if (VECTORS[v].flag_addr == addr && (pending & (1UL << v)))
+      flags |= (1 << VECTORS[v].flag_bit);
+
+  return flags;
+}
+
+void
+raise_interrupt (Vector_t v)
+{
+  pending |= (1UL << v);
+  if (VECTORS[v].flag_addr != NO_REGISTER)
+    REG (VECTORS[v].flag_addr) |= (1 << VECTORS[v].flag_bit);
+}
+
+void
+lower_interrupt (Vector_t v)
+{
+  if (VECTORS[v].level)
+    return;
+
+  pending &= ~(1UL << v);
+  if (VECTORS[v].flag_addr != NO_REGISTER)
+    REG (VECTORS[v].flag_addr) &= ~(1 << VECTORS[v].flag_bit);
+}
+
+/*
+ *  Runs pending, enabled interrupts, highest priority first, while the
+ *  global interrupt flag is set. ISRs aren't nested, as with ISR_BLOCK.
+ */
+void
+dispatch (void)
+{
+  static uint32_t unhandled = 0;
+
+  if (in_isr)
+    return;
+
+  while (REG (ADDR_SREG) & (1 << (SREG_I_BIT)))
+    {
+      Vector_t v = 0;
+      while (v < (V_COUNT)
+             && !((pending & (1UL << v))
+                  && (REG (VECTORS[v].mask_addr)
+                      & (1 << VECTORS[v].mask_bit))))
+        v++;
+
+      if (v == (V_COUNT))
+        return;
+
+      /* The hardware clears the flag as the vector is taken. */
+      lower_interrupt (v);
+
+      if (VECTORS[v].isr == NULL)
+        {
+          /* Would jump to __bad_interrupt and reset the device. */
+          if (!(unhandled & (1UL << v)))
+            fprintf (stderr, "host_sim: %s enabled with no ISR\n",
+                     VECTORS[v].name);
+          unhandled |= (1UL << v);
+          if (VECTORS[v].level)
+            return;
+          continue;
+        }
+
+      in_isr = true;
+      in_rx_isr = (v == V_USART_RX);
+      REG (ADDR_SREG) &= ~(1 << (SREG_I_BIT));
+      VECTORS[v].isr ();
+      settle ();
+      REG (ADDR_SREG) |= (1 << (SREG_I_BIT));
+      in_rx_isr = false;
+      in_isr = false;
+      dispatched++;
+    }
+}
+
+/*
+ *  Advances the clock by up to STEP_US. Asleep, only the clocks the sleep
+ *  mode keeps running are advanced (Table 10-1, ATmega328P data sheet).
+ */
+void
+step (uint32_t us, uint8_t sleep_mode, bool asleep)
+{
+  const uint32_t cycles = us * (CYCLES_PER_US);
+  bool io_clock = true;
+  bool async_timer = true;
+
+  if (asleep)
+    {
+      io_clock = (sleep_mode == (SLEEP_MODE_IDLE));
+      async_timer = (sleep_mode == (SLEEP_MODE_IDLE)
+                     || sleep_mode == (SLEEP_MODE_ADC)
+                     || sleep_mode == (SLEEP_MODE_PWR_SAVE)
+                     || sleep_mode == (SLEEP_MODE_EXT_STANDBY));
+    }
+
+  now_us += us;
+
+  if (io_clock)
+    {
+      clock_timer (&timers[TIMER_0], cycles);
+      clock_timer (&timers[TIMER_1], cycles);
+    }
+  if (async_timer)
+    clock_timer (&timers[TIMER_2], cycles);
+
+  clock_watchdog (us);
+
+  if (adc_converting && now_us >= adc_done_us)
+    finish_conversion ();
+
+  if (pty_master >= 0)
+    poll_pty ();
+
+  dispatch ();
+  check_limit ();
+}
+
+void
+clock_timer (HostTimer_t *t, uint32_t cycles)
+{
+  if (REG (ADDR_PRR) & (1 << t->prr_bit))
+    return;
+
+  const uint16_t divisor = t->divisors[REG (t->tccrb) & 0x07];
+  if (divisor == 0)
+    return;
+
+  t->prescaler_cycles += cycles;
+  uint32_t ticks = t->prescaler_cycles / divisor;
+  t->prescaler_cycles %= divisor;
+
+  /* Jumps from event to event rather than tick by tick. */
+  while (ticks > 0)
+    {
+      TimerKind_t kind;
+      const uint32_t max = t->wide ? 0xFFFF : 0xFF;
+      uint32_t top = timer_top (t, &kind);
+      uint32_t count = timer_read (t, t->tcnt);
+      const uint32_t ocr[2]
+          = { timer_read (t, t->ocra), timer_read (t, t->ocrb) };
+      uint32_t distance;
+
+      if (kind == TIMER_PHASE)
+        {
+          if (count >= top)
+            t->counting_down = true;
+          else if (count == 0)
+            t->counting_down = false;
+
+          distance = t->counting_down ? count : top - count;
+          for (uint8_t i = 0; i < 2; i++)
+            {
+              if (!t->counting_down && ocr[i] > count && ocr[i] <= top
+                  && ocr[i] - count < distance)
+                distance = ocr[i] - count;
+              if (t->counting_down && ocr[i] < count
+                  && count - ocr[i] < distance)
+                distance = count - ocr[i];
+            }
+          if (distance > ticks)
+            distance = ticks;
+
+          count = t->counting_down ? count - distance : count + distance;
+          ticks -= distance;
+
+          if (count == 0 && t->counting_down)
+            raise_interrupt (t->ovf);
+        }
+      else
+        {
+          /* A TOP lowered below the count lets the counter run to MAX. */
+          if (count > top)
+            top = max;
+
+          distance = top + 1 - count;
+          for (uint8_t i = 0; i < 2; i++)
+            {
+              uint32_t to_match;
+              if (ocr[i] > top)
+                continue;
+              to_match = ocr[i] > count ? ocr[i] - count
+                                        : top + 1 - count + ocr[i];
+              if (to_match < distance)
+                distance = to_match;
+            }
+          if (distance > ticks)
+            distance = ticks;
+
+          count += distance;
+          ticks -= distance;
+
+          if (count > top)
+            {
+              count = 0;
+              if (kind != TIMER_CTC || top == max)
+                raise_interrupt (t->ovf);
+            }
+        }
+
+      timer_write (t, t->tcnt, count);
+      if (distance > 0 && count == ocr[0])
+        raise_interrupt (t->compa);
+      if (distance > 0 && count == ocr[1])
+        raise_interrupt (t->compb);
+
+      dispatch ();
+    }
+}
+
+uint32_t
+timer_top (const HostTimer_t *t, TimerKind_t *kind)
+{
+  const uint8_t wgm = (REG (t->tccra) & 0x03)
+                      | (((REG (t->tccrb) >> (WGM02)) & (t->wide ? 0x3 : 0x1))
+                         << 2);
+  const uint32_t ocra = timer_read (t, t->ocra);
+
+  if (!t->wide)
+    {
+      switch (wgm)
+        {
+        case 1:
+          *kind = TIMER_PHASE;
+          return 0xFF;
+        case 2:
+          *kind = TIMER_CTC;
+          return ocra;
+        case 3:
+          *kind = TIMER_FAST;
+          return 0xFF;
+        case 5:
+          *kind = TIMER_PHASE;
+          return ocra;
+        case 7:
+          *kind = TIMER_FAST;
+          return ocra;
+        default:
+          *kind = TIMER_NORMAL;
+          return 0xFF;
+        }
+    }
+
+  const uint32_t icr = REG16 (ADDR_ICR1);
+  switch (wgm)
+    {
+    case 1:
+    case 2:
+    case 3:
+      *kind = TIMER_PHASE;
+      return (1U << (wgm + 7)) - 1;
+    case 4:
+      *kind = TIMER_CTC;
+      return ocra;
+    case 5:
+    case 6:
+    case 7:
+      *kind = TIMER_FAST;
+      return (1U << (wgm + 3)) - 1;
+    case 8:
+    case 10:
+      *kind = TIMER_PHASE;
+      return icr;
+    case 9:
+    case 11:
+      *kind = TIMER_PHASE;
+      return ocra;
+    case 12:
+      *kind = TIMER_CTC;
+      return icr;
+    case 14:
+      *kind = TIMER_FAST;
+      return icr;
+    case 15:
+      *kind = TIMER_FAST;
+      return ocra;
+    default:
+      *kind = TIMER_NORMAL;
+      return 0xFFFF;
+    }
+}
+
+uint32_t
+timer_read (const HostTimer_t *t, uint8_t addr)
+{
+  return t->wide ? REG16 (addr) : REG (addr);
+}
+
+void
+timer_write (const HostTimer_t *t, uint8_t addr, uint32_t value)
+{
+  if (t->wide)
+    REG16 (addr) = (uint16_t)value;
+  else
+    REG (addr) = (uint8_t)value;
+}
+
+/*
+ *  The watchdog runs from its own 128 kHz oscillator in every sleep mode.
+ *  A time-out in interrupt and reset mode clears WDIE, so the next one
+ *  resets (pg. 61, ATmega328P data sheet).
+ */
+void
+clock_watchdog (uint32_t us)
+{
+  const uint8_t wdtcsr = REG (ADDR_WDTCSR);
+
+  if (!(wdtcsr & ((1 << (WDIE)) | (1 << (WDE)))))
+    {
+      wdt_elapsed_us = 0;
+      return;
+    }
+
+  const uint8_t period = (wdtcsr & 0x07) | ((wdtcsr & (1 << (WDP3))) >> 2);
+  const uint32_t period_us = 16000UL << period;
+
+  wdt_elapsed_us += us;
+  if (wdt_elapsed_us < period_us)
+    return;
+  wdt_elapsed_us -= period_us;
+
+  if (wdtcsr & (1 << (WDIE)))
+    {
+      raise_interrupt (V_WDT);
+      if (wdtcsr & (1 << (WDE)))
+        REG (ADDR_WDTCSR) &= ~(1 << (WDIE));
+      return;
+    }
+
+  host_sim_flush ();
+  fprintf (stderr, "host_sim: watchdog reset at %llu us\n",
+           (unsigned long long)now_us);
+  exit (EXIT_FAILURE);
+}
+
+/* 13 ADC clocks; the longer first conversion isn't modelled. */
+void
+start_conversion (void)
+{
+  const uint8_t adps = REG (ADDR_ADCSRA) & 0x07;
+  const uint32_t divisor = adps ? (1UL << adps) : 2;
+
+  adc_converting = true;
+  adc_done_us = now_us + (13 * divisor + (CYCLES_PER_US)-1) / (CYCLES_PER_US);
+}
+
+void
+finish_conversion (void)
+{
+  const uint8_t admux = REG (ADDR_ADMUX);
+  const uint8_t channel = admux & 0x0F;
+  uint16_t value;
+
+  if (adc_source != NULL)
+    value = adc_source (channel);
+  else if (channel == 0x0E)
+    value = 225; // The 1.1 V bandgap against a 5 V AVcc
+  else if (channel == 0x0F)
+    value = 0;
+  else if (adc_sweep.period_us != 0)
+    value = sweep_reading (channel);
+  else
+    value = adc_values[channel];
+
+  if (value > 1023)
+    value = 1023;
+
+  REG16 (ADDR_ADC) = (admux & (1 << (ADLAR))) ? (value << 6) : value;
+
+  adc_converting = false;
+  REG (ADDR_ADCSRA) &= ~(1 << (ADSC));
+  raise_interrupt (V_ADC);
+}
+
+/*
+ *  Writing ones to PINx toggles PORTx. A write shows up as PINx differing
+ *  from what was last put there, so only the last write since the previous
+ *  call counts, and writing the pins' current levels is missed.
+ */
+void
+sync_pins (void)
+{
+  for (HostPort_t port = 0; port < (HOST_PORT_COUNT); port++)
+    {
+      const uint8_t addr = ADDR_PINB + port * 3;
+
+      /*
+       *  This runs on every hooked register access, so a port is skipped
+       *  unless the firmware has written one of its registers or an input
+       *  has been driven since.
+       */
+      if (!pin_inputs_changed && REG (addr) == pin_published[port]
+          && REG (addr + 1) == pin_ddr_synced[port]
+          && REG (addr + 2) == pin_port_synced[port])
+        continue;
+
+      if (REG (addr) != pin_published[port])
+        REG (addr + 2) ^= REG (addr);
+
+      pin_published[port] = pin_value (port);
+      REG (addr) = pin_published[port];
+      pin_ddr_synced[port] = REG (addr + 1);
+      pin_port_synced[port] = REG (addr + 2);
+    }
+
+  pin_inputs_changed = false;
+}
+
+/* Undriven inputs read their pull-up, or high if floating. */
+uint8_t
+pin_value (HostPort_t port)
+{
+  const uint8_t ddr = REG (ADDR_DDRB + port * 3);
+  const uint8_t out = REG (ADDR_PORTB + port * 3);
+  const uint8_t in
+      = (pin_levels[port] & pin_driven[port]) | (uint8_t)~pin_driven[port];
+  uint8_t value = (out & ddr) | (in & ~ddr);
+
+  /* Port C has no bit 7. */
+  if (port == HOST_PORT_C)
+    value &= 0x7F;
+
+  return value;
+}
+
+void
+edge_interrupts (HostPort_t port, uint8_t bit, bool level)
+{
+  if (REG (ADDR_PCMSK0 + port) & (1 << bit))
+    raise_interrupt (V_PCINT0 + port);
+
+  if (port == HOST_PORT_D && (bit == 2 || bit == 3))
+    {
+      const uint8_t sense = (REG (ADDR_EICRA) >> ((bit - 2) * 2)) & 0x03;
+      if (sense == 1 || (sense == 2 && !level) || (sense == 3 && level)
+          || (sense == 0 && !level))
+        raise_interrupt (bit == 2 ? V_INT0 : V_INT1);
+    }
+
+  /* ICP1 is PB0; ICES1 selects the rising edge. */
+  if (port == HOST_PORT_B && bit == 0 && !(REG (ADDR_PRR) & (1 << (PRTIM1)))
+      && (REG (ADDR_TCCR1B) & 0x07)
+      && level == !!(REG (ADDR_TCCR1B) & (1 << (ICES1))))
+    {
+      REG16 (ADDR_ICR1) = REG16 (ADDR_TCNT1);
+      raise_interrupt (V_TIMER1_CAPT);
+    }
+}
+
+/* The firmware terminates strings with NULs on the wire; they aren't shown. */
+void
+emit (uint8_t byte)
+{
+  if (uart_sink != NULL)
+    uart_sink (byte);
+  else if (pty_master >= 0)
+    {
+      /* Blocks while the tool on the other end is behind. */
+      while (write (pty_master, &byte, 1) < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          perror ("host_sim: pseudo-terminal");
+          exit (EXIT_FAILURE);
+        }
+    }
+  else if (byte != '\0')
+    {
+      putchar (byte);
+      if (realtime)
+        fflush (stdout);
+    }
+}
+
+/* Holds the simulation back to the wall clock when running in real time. */
+void
+pace (void)
+{
+  if (!realtime)
+    return;
+
+  struct timespec now;
+  clock_gettime (CLOCK_MONOTONIC, &now);
+
+  const int64_t wall_us = (int64_t)(now.tv_sec - start_time.tv_sec) * 1000000
+                          + (now.tv_nsec - start_time.tv_nsec) / 1000;
+  const int64_t ahead_us = (int64_t)now_us - wall_us;
+
+  if (ahead_us > 1000)
+    {
+      const struct timespec wait = { ahead_us / 1000000,
+                                     (ahead_us % 1000000) * 1000 };
+      nanosleep (&wait, NULL);
+    }
+}
+
+void
+check_limit (void)
+{
+  if (limit_us == 0 || now_us < limit_us)
+    return;
+
+  host_sim_flush ();
+  exit (EXIT_SUCCESS);
+}
+
+/* @return CPU cycles one frame takes at the simulated baud rate. */
+uint32_t
+frame_cycles (void)
+{
+  if (uart_baud != 0)
+    return (UART_FRAME_BITS) * (F_CPU) / uart_baud;
+
+  /* As the USART itself divides the clock (pg. 182). */
+  const uint16_t ubrr = ((REG (ADDR_UBRR0H) & 0x0F) << 8) | REG (ADDR_UBRR0L);
+  const uint8_t divisor = (REG (ADDR_UCSR0A) & (1 << (U2X0))) ? 8 : 16;
+
+  return (UART_FRAME_BITS) * (uint32_t)divisor * (ubrr + 1);
+}
+
+/* Either "<value>" or "<low>:<high>[:<period ms>[:<noise>]]". */
+void
+parse_adc (const char *value)
+{
+  char *end;
+  const unsigned long low = strtoul (value, &end, 10);
+
+  if (*end != ':')
+    {
+      for (uint8_t i = 0; i < 16; i++)
+        host_sim_set_adc (i, (uint16_t)low);
+      return;
+    }
+
+  const unsigned long high = strtoul (end + 1, &end, 10);
+  unsigned long period_ms = (ADC_SWEEP_DEFAULT_PERIOD_MS);
+  if (*end == ':')
+    period_ms = strtoul (end + 1, &end, 10);
+  if (*end == ':')
+    adc_sweep.noise = (uint16_t)strtoul (end + 1, &end, 10);
+
+  adc_sweep.low = low < high ? low : high;
+  adc_sweep.high = low < high ? high : low;
+  adc_sweep.period_us = (period_ms ? period_ms : 1) * 1000;
+}
+
+/* Each channel lags the one before it by a fraction of the period. */
+uint16_t
+sweep_reading (uint8_t channel)
+{
+  const uint32_t period = adc_sweep.period_us;
+  const uint32_t half = period / 2 ? period / 2 : 1;
+  const uint32_t phase
+      = (now_us + (uint64_t)period * channel / (ADC_SWEEP_PHASES)) % period;
+  const uint32_t rise = phase < half ? phase : period - phase;
+  const uint32_t span = adc_sweep.high - adc_sweep.low;
+  int32_t value = adc_sweep.low + (int32_t)((uint64_t)span * rise / half);
+
+  if (adc_sweep.noise != 0)
+    value += rand () % (2 * adc_sweep.noise + 1) - adc_sweep.noise;
+
+  /* Noise can carry a reading past either end of the ADC's range. */
+  if (value < 0)
+    return 0;
+  return value > (ADC_MAX) ? (ADC_MAX) : (uint16_t)value;
+}
+
+/*
+ *  Serves the UART on a pseudo-terminal, linked from `link` unless that's
+ *  empty. The simulator holds the terminal's own end open as well, so
+ *  output waits in it until a tool connects.
+ */
+void
+open_pty (const char *link)
+{
+  const int master = posix_openpt (O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt (master) != 0 || unlockpt (master) != 0)
+    {
+      perror ("host_sim: pseudo-terminal");
+      exit (EXIT_FAILURE);
+    }
+
+  const char *name = ptsname (master);
+  const int slave = open (name, O_RDWR | O_NOCTTY);
+  struct termios tio;
+  if (slave < 0 || tcgetattr (slave, &tio) != 0)
+    {
+      perror (name);
+      exit (EXIT_FAILURE);
+    }
+
+  /* Raw, so bytes pass through untouched and aren't echoed back. */
+  tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL
+                   | IXON);
+  tio.c_oflag &= ~OPOST;
+  tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+  tcsetattr (slave, TCSANOW, &tio);
+
+  pty_master = master;
+
+  if (link[0] != '\0')
+    {
+      /* Only a link left by an earlier run is replaced, never a file. */
+      struct stat st;
+      if (lstat (link, &st) == 0)
+        {
+          if (!S_ISLNK (st.st_mode))
+            {
+              fprintf (stderr, "host_sim: %s exists and isn't a symlink\n",
+                       link);
+              exit (EXIT_FAILURE);
+            }
+          unlink (link);
+        }
+      else if (errno != ENOENT)
+        {
+          perror (link);
+          exit (EXIT_FAILURE);
+        }
+
+      if (symlink (name, link) != 0)
+        {
+          perror (link);
+          exit (EXIT_FAILURE);
+        }
+      pty_link = link;
+      atexit (remove_pty_link);
+    }
+
+  fprintf (stderr, "host_sim: UART on %s\n", pty_link ? pty_link : name);
+}
+
+/*
+ *  Hands bytes typed into the pseudo-terminal to the receiver, one per
+ *  step (or per frame time when paced) and none while the last is unread.
+ */
+void
+poll_pty (void)
+{
+  static uint8_t queue[(PTY_QUEUE_SIZE)];
+  static uint8_t queued = 0;
+  static uint8_t next = 0;
+  static uint8_t idle_steps = 0;
+
+  if (next == queued)
+    {
+      if (++idle_steps < (PTY_POLL_STEPS))
+        return;
+      idle_steps = 0;
+
+      struct pollfd p = { pty_master, POLLIN, 0 };
+      if (poll (&p, 1, 0) <= 0 || !(p.revents & POLLIN))
+        return;
+
+      const ssize_t n = read (pty_master, queue, sizeof (queue));
+      if (n <= 0)
+        return;
+      queued = (uint8_t)n;
+      next = 0;
+    }
+
+  if ((pending & (1UL << V_USART_RX)) || now_us < uart_rx_us)
+    return;
+
+  if (uart_paced)
+    uart_rx_us = now_us + frame_cycles () / (CYCLES_PER_US);
+  host_sim_uart_receive (queue[next++]);
+}
+
+void
+remove_pty_link (void)
+{
+  unlink (pty_link);
+}
+
+/* Starts erased (all ones), unless `path` holds a saved image. */
+void
+load_eeprom (const char *path)
+{
+  memset (eeprom, 0xFF, sizeof (eeprom));
+
+  if (path == NULL || path[0] == '\0')
+    return;
+
+  eeprom_path = path;
+  FILE *f = fopen (path, "rb");
+  if (f == NULL)
+    return;
+  if (fread (eeprom, 1, sizeof (eeprom), f) != sizeof (eeprom))
+    fprintf (stderr, "host_sim: %s is short; the rest reads erased\n", path);
+  fclose (f);
+}
+
+/*
+ *  Programs a byte, taking its write time out of the simulated clock, if
+ *  it differs from what is there.
+ *  @return true if it did.
+ */
+bool
+program_eeprom (uint16_t addr, uint8_t value)
+{
+  if (eeprom[addr] == value)
+    return false;
+
+  eeprom[addr] = value;
+  host_sim_advance_us (EEPROM_WRITE_US);
+  return true;
+}
+
+/* Keeps the image in HOST_SIM_EEPROM, if set, up to date. */
+void
+save_eeprom (void)
+{
+  if (eeprom_path == NULL)
+    return;
+
+  FILE *f = fopen (eeprom_path, "wb");
+  if (f == NULL || fwrite (eeprom, 1, sizeof (eeprom), f) != sizeof (eeprom))
+    perror (eeprom_path);
+  if (f != NULL)
+    fclose (f);
+}
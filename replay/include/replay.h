@@ -0,0 +1,49 @@
+/*
+ *  Sensor Trace Replay
+ *  Feeds recorded ADC readings through a project's own sampling, conversion
+ *  and output code, built for the host backend (see: host/include/host_sim.h)
+ *  with the simulated ADC reading from the trace. What the firmware prints,
+ *  plus anything the image adds with `replay_emit`, is either written out or
+ *  checked against a golden copy, so an algorithm change can be run over
+ *  days of field data in seconds:
+ *
+ *    replay_<image> <trace> [<golden>]
+ *
+ *  Without a golden file the output goes to stdout, ready to be saved as
+ *  one. With one, the output is compared byte for byte; the first line to
+ *  differ is reported, and the exit status is 1.
+ *
+ *  A trace holds one row per step, with one reading (0-1023, right
+ *  adjusted) per channel from ADC0 up:
+ *
+ *    CSV     comma-separated decimal readings, a row per line. Blank lines
+ *            and lines starting with '#' are skipped.
+ *    binary  any file named *.bin: rows of little-endian 16-bit readings,
+ *            `replay_channels` per row.
+ */
+#ifndef _REPLAY_H_
+#define _REPLAY_H_
+
+#include <stdint.h>
+
+#define REPLAY_MAX_CHANNELS (8)
+
+/* Defined by each image: its readings per trace row, 1-REPLAY_MAX_CHANNELS. */
+extern const uint8_t replay_channels;
+
+/*
+ *  Defined by each image: sets the firmware up, as its `main` would.
+ *  @return 0 on success, -1 on failure.
+ */
+int8_t replay_setup (void);
+
+/*
+ *  Defined by each image: runs the firmware once on the current row.
+ *  @return 0 on success, -1 to stop the replay.
+ */
+int8_t replay_step (void);
+
+/* Adds `str` to the output, alongside what the firmware prints. */
+void replay_emit (const char *str);
+
+#endif /* _REPLAY_H_ */
@@ -0,0 +1,201 @@
+#include "replay.h"
+#include "host_sim.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINE_BUFFER_SIZE (256)
+#define ADC_MAX (1023)
+#define BINARY_SUFFIX (".bin")
+
+static FILE *trace = NULL;
+static bool trace_is_binary = false;
+static uint16_t row[(REPLAY_MAX_CHANNELS)] = { 0 };
+static unsigned long row_number = 0;
+
+static FILE *golden = NULL;
+static unsigned long output_line = 1;
+static unsigned long mismatch_line = 0; // 0 while the output matches
+static unsigned long mismatch_row = 0;
+
+static int8_t read_row (void);
+static int8_t read_csv_row (void);
+static int8_t read_binary_row (void);
+static uint16_t trace_source (uint8_t channel);
+static void output_byte (uint8_t byte);
+static bool ends_with (const char *str, const char *suffix);
+
+int
+main (int argc, char **argv)
+{
+  if (argc < 2 || argc > 3)
+    {
+      fprintf (stderr, "usage: %s <trace> [<golden>]\n", argv[0]);
+      return 2;
+    }
+
+  if (replay_channels == 0 || replay_channels > (REPLAY_MAX_CHANNELS))
+    {
+      fprintf (stderr, "%s: bad channel count %u\n", argv[0],
+               replay_channels);
+      return 2;
+    }
+
+  trace = fopen (argv[1], "rb");
+  if (trace == NULL)
+    {
+      perror (argv[1]);
+      return 2;
+    }
+  trace_is_binary = ends_with (argv[1], (BINARY_SUFFIX));
+
+  if (argc == 3 && (golden = fopen (argv[2], "rb")) == NULL)
+    {
+      perror (argv[2]);
+      return 2;
+    }
+
+  host_sim_set_adc_source (trace_source);
+  host_sim_set_uart_sink (output_byte);
+
+  if (replay_setup () != 0)
+    {
+      fprintf (stderr, "%s: firmware setup failed\n", argv[0]);
+      return 2;
+    }
+
+  const clock_t start = clock ();
+  while (read_row () == 0)
+    {
+      row_number++;
+      if (replay_step () != 0)
+        break;
+    }
+  host_sim_flush ();
+  const double seconds = (double)(clock () - start) / CLOCKS_PER_SEC;
+
+  fprintf (stderr, "replayed %lu rows in %.3f s (%.0f rows/s)\n",
+           row_number, seconds, seconds > 0 ? row_number / seconds : 0.0);
+
+  if (golden == NULL)
+    return 0;
+
+  /* Output which stops short of the golden copy doesn't match either. */
+  if (mismatch_line == 0 && fgetc (golden) != EOF)
+    {
+      mismatch_line = output_line;
+      mismatch_row = row_number;
+    }
+
+  if (mismatch_line != 0)
+    {
+      fprintf (stderr, "%s: differs from %s at line %lu (trace row %lu)\n",
+               argv[0], argv[2], mismatch_line, mismatch_row);
+      return 1;
+    }
+
+  fprintf (stderr, "matches %s\n", argv[2]);
+  return 0;
+}
+
+void
+replay_emit (const char *str)
+{
+  while (*str != '\0')
+    output_byte (*str++);
+}
+
+/* @return 0 once `row` holds the next row, -1 at the end of the trace. */
+int8_t
+read_row (void)
+{
+  return trace_is_binary ? read_binary_row () : read_csv_row ();
+}
+
+/* Missing readings are 0; extra ones are ignored. */
+int8_t
+read_csv_row (void)
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  while (fgets (line, sizeof (line), trace) != NULL)
+    {
+      const char *p = line + strspn (line, " \t");
+      if (*p == '#' || *p == '\r' || *p == '\n' || *p == '\0')
+        continue;
+
+      for (uint8_t c = 0; c < replay_channels; c++)
+        {
+          char *end;
+          const unsigned long value = strtoul (p, &end, 10);
+
+          row[c] = end == p ? 0 : value > (ADC_MAX) ? (ADC_MAX) : value;
+          p = end + strspn (end, " \t");
+          if (*p == ',')
+            p++;
+        }
+
+      return 0;
+    }
+
+  return -1;
+}
+
+int8_t
+read_binary_row (void)
+{
+  uint8_t bytes[(REPLAY_MAX_CHANNELS) * 2];
+  const size_t size = (size_t)replay_channels * 2;
+
+  if (fread (bytes, 1, size, trace) != size)
+    return -1;
+
+  for (uint8_t c = 0; c < replay_channels; c++)
+    {
+      const uint16_t value = bytes[c * 2] | (bytes[c * 2 + 1] << 8);
+      row[c] = value > (ADC_MAX) ? (ADC_MAX) : value;
+    }
+
+  return 0;
+}
+
+/* The simulated ADC's reading: the current row's, for channels it has. */
+uint16_t
+trace_source (uint8_t channel)
+{
+  return channel < replay_channels ? row[channel] : 0;
+}
+
+/* Writes or checks one byte of output; the UART HALs' NULs are dropped. */
+void
+output_byte (uint8_t byte)
+{
+  if (byte == '\0')
+    return;
+
+  if (golden == NULL)
+    {
+      putchar (byte);
+    }
+  else if (fgetc (golden) != byte && mismatch_line == 0)
+    {
+      mismatch_line = output_line;
+      mismatch_row = row_number;
+    }
+
+  if (byte == '\n')
+    output_line++;
+}
+
+bool
+ends_with (const char *str, const char *suffix)
+{
+  const size_t length = strlen (str);
+  const size_t suffix_length = strlen (suffix);
+
+  return length >= suffix_length
+         && strcmp (str + length - suffix_length, suffix) == 0;
+}
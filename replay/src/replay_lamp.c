@@ -0,0 +1,42 @@
+/*
+ *  The Color Mixing Lamp: each row is a red, green and blue reading (ADC0-2)
+ *  for one `l_lamp_step`, after which the LEDs' duty cycles are read back
+ *  from the compare registers.
+ */
+#include "lamp.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "uart_hal.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdio.h>
+
+#define BAUD_RATE (9600)
+#define LINE_BUFFER_SIZE (48)
+
+const uint8_t replay_channels = 3;
+
+int8_t
+replay_setup (void)
+{
+  sched_init ();
+  uart_init ((BAUD_RATE), false);
+  sei ();
+
+  return l_init_lamp ();
+}
+
+int8_t
+replay_step (void)
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  if (l_lamp_step () != 0)
+    return -1;
+
+  snprintf (line, sizeof (line), "PWM - red: %u green: %u blue: %u\r\n",
+            OCR2A, OCR1A, OCR1B);
+  replay_emit (line);
+  return 0;
+}
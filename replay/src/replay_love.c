@@ -0,0 +1,45 @@
+/*
+ *  The Love-o-Meter: each row is a temperature sensor reading (ADC0) for one
+ *  run of `love_o_meter_loop`, after which the bargraph LEDs are read back
+ *  from PORTD.
+ */
+#include "love_o_meter.h"
+#include "replay.h"
+#include "scheduler.h"
+#include "uart_hal.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stdio.h>
+
+#define BAUD_RATE (9600)
+#define LINE_BUFFER_SIZE (32)
+
+/* PD2-4 */
+#define BARGRAPH_SHIFT (2)
+#define BARGRAPH_MASK (0x07)
+
+const uint8_t replay_channels = 1;
+
+int8_t
+replay_setup (void)
+{
+  sched_init ();
+  uart_init ((BAUD_RATE), false);
+  sei ();
+
+  return init_love_o_meter () == 0 ? 0 : -1;
+}
+
+int8_t
+replay_step (void)
+{
+  char line[(LINE_BUFFER_SIZE)];
+
+  love_o_meter_loop ();
+
+  snprintf (line, sizeof (line), "Bargraph LEDs: %u\r\n",
+            (PORTD >> (BARGRAPH_SHIFT)) & (BARGRAPH_MASK));
+  replay_emit (line);
+  return 0;
+}
@@ -0,0 +1,46 @@
+/*
+ *  Host Tests
+ *  Checks the HAL and project logic which doesn't need a board, built for
+ *  the host backend (see: host/include/host_sim.h) as one executable:
+ *
+ *    run_tests
+ *
+ *  Every suite runs; each failed check is printed with where it is and what
+ *  it got, and the exit status is 1 if any failed. `make test` builds and
+ *  runs it.
+ */
+#ifndef _TEST_H_
+#define _TEST_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Fails, without stopping the suite, unless `cond` holds. */
+#define TEST_CHECK(cond) test_check ((cond), #cond, __FILE__, __LINE__)
+
+/* Fails unless the integers `actual` and `expected` are equal. */
+#define TEST_CHECK_EQ(actual, expected)                                       \
+  test_check_eq ((actual), (expected), #actual, __FILE__, __LINE__)
+
+/* Fails unless the strings `actual` and `expected` are equal. */
+#define TEST_CHECK_STR(actual, expected)                                      \
+  test_check_str ((actual), (expected), #actual, __FILE__, __LINE__)
+
+void test_check (bool passed, const char *expr, const char *file, int line);
+void test_check_eq (int64_t actual, int64_t expected, const char *expr,
+                    const char *file, int line);
+void test_check_str (const char *actual, const char *expected,
+                     const char *expr, const char *file, int line);
+
+/* The suites, one per module under test, each in its own test_*.c. */
+void test_uart_hal (void);
+void test_baseline (void);
+void test_latency (void);
+void test_reports (void);
+void test_pwm_frequency (void);
+void test_pwm_hal (void);
+void test_pwm_stream (void);
+void test_input_capture (void);
+void test_lamp_config (void);
+
+#endif /* _TEST_H_ */
@@ -0,0 +1,73 @@
+#include "test.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+static unsigned long checks = 0;
+static unsigned long failures = 0;
+
+static void run_suite (const char *name, void (*suite) (void));
+
+int
+main (void)
+{
+  run_suite ("uart_hal", test_uart_hal);
+  run_suite ("baseline", test_baseline);
+  run_suite ("latency", test_latency);
+  run_suite ("reports", test_reports);
+  run_suite ("pwm_frequency", test_pwm_frequency);
+  run_suite ("pwm_hal", test_pwm_hal);
+  run_suite ("pwm_stream", test_pwm_stream);
+  run_suite ("input_capture", test_input_capture);
+  run_suite ("lamp_config", test_lamp_config);
+
+  printf ("%lu checks, %lu failed\n", checks, failures);
+  return failures == 0 ? 0 : 1;
+}
+
+void
+test_check (bool passed, const char *expr, const char *file, int line)
+{
+  checks++;
+  if (passed)
+    return;
+
+  failures++;
+  printf ("%s:%d: check failed: %s\n", file, line, expr);
+}
+
+void
+test_check_eq (int64_t actual, int64_t expected, const char *expr,
+               const char *file, int line)
+{
+  checks++;
+  if (actual == expected)
+    return;
+
+  failures++;
+  printf ("%s:%d: %s is %" PRId64 ", expected %" PRId64 "\n", file, line,
+          expr, actual, expected);
+}
+
+void
+test_check_str (const char *actual, const char *expected, const char *expr,
+                const char *file, int line)
+{
+  checks++;
+  if (strcmp (actual, expected) == 0)
+    return;
+
+  failures++;
+  printf ("%s:%d: %s is\n  \"%s\"\nexpected\n  \"%s\"\n", file, line, expr,
+          actual, expected);
+}
+
+void
+run_suite (const char *name, void (*suite) (void))
+{
+  const unsigned long failed_before = failures;
+
+  suite ();
+  printf ("%s: %s\n", name, failures == failed_before ? "ok" : "FAILED");
+}
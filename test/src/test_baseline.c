@@ -0,0 +1,117 @@
+/*
+ *  The Love-o-Meter's baseline estimator: a running mean while warming up,
+ *  then a slow moving average which leaves outliers out until there have
+ *  been enough in a row to start over.
+ */
+#include "baseline.h"
+#include "test.h"
+
+static void update_n (BaselineEstimator_t *be, uint16_t sample, uint16_t n);
+static void test_warm_up (void);
+static void test_outliers (void);
+static void test_drift (void);
+static void test_restart (void);
+
+void
+test_baseline (void)
+{
+  test_warm_up ();
+  test_outliers ();
+  test_drift ();
+  test_restart ();
+}
+
+void
+update_n (BaselineEstimator_t *be, uint16_t sample, uint16_t n)
+{
+  while (n-- > 0)
+    baseline_update (be, sample);
+}
+
+void
+test_warm_up (void)
+{
+  BaselineEstimator_t be;
+
+  baseline_reset (&be);
+  TEST_CHECK_EQ (baseline_value (&be), 0);
+  TEST_CHECK (!baseline_is_settled (&be));
+
+  /* The first sample is the baseline straight away. */
+  TEST_CHECK (baseline_update (&be, 150));
+  TEST_CHECK_EQ (baseline_value (&be), 150);
+
+  /* 150, 160, 150, 160, ... averages to 155, nothing rejected. */
+  for (uint8_t i = 1; i < (BASELINE_WARMUP_SAMPLES); i++)
+    {
+      TEST_CHECK (!baseline_is_settled (&be));
+      TEST_CHECK (baseline_update (&be, i % 2 ? 160 : 150));
+    }
+  TEST_CHECK (baseline_is_settled (&be));
+  TEST_CHECK_EQ (baseline_value (&be), 155);
+}
+
+void
+test_outliers (void)
+{
+  BaselineEstimator_t be;
+
+  baseline_reset (&be);
+  update_n (&be, 150, (BASELINE_WARMUP_SAMPLES));
+
+  /* A hand on the sensor: rejected, and the baseline doesn't move. */
+  TEST_CHECK (!baseline_update (&be, 150 + (BASELINE_OUTLIER_COUNTS) + 1));
+  TEST_CHECK (!baseline_update (&be, 150 - (BASELINE_OUTLIER_COUNTS) - 1));
+  TEST_CHECK_EQ (baseline_value (&be), 150);
+  TEST_CHECK_EQ (be.outliers, 2);
+
+  /* A sample at the limit is drift; it's used and clears the run. */
+  TEST_CHECK (baseline_update (&be, 150 + (BASELINE_OUTLIER_COUNTS)));
+  TEST_CHECK_EQ (be.outliers, 0);
+  TEST_CHECK_EQ (baseline_value (&be), 150);
+}
+
+/*
+ *  After one time constant, a 4-count step has moved the baseline most of
+ *  the way; it then converges on the new level without overshooting.
+ */
+void
+test_drift (void)
+{
+  BaselineEstimator_t be;
+
+  baseline_reset (&be);
+  update_n (&be, 150, (BASELINE_WARMUP_SAMPLES));
+
+  update_n (&be, 154, 1 << (BASELINE_EMA_SHIFT));
+  TEST_CHECK (baseline_value (&be) >= 152);
+  TEST_CHECK (baseline_value (&be) <= 154);
+
+  update_n (&be, 154, 8 << (BASELINE_EMA_SHIFT));
+  TEST_CHECK_EQ (baseline_value (&be), 154);
+
+  update_n (&be, 150, 8 << (BASELINE_EMA_SHIFT));
+  TEST_CHECK_EQ (baseline_value (&be), 150);
+}
+
+/*
+ *  The resting level really moved: after enough outliers in a row, the
+ *  estimator warms up again from the new level.
+ */
+void
+test_restart (void)
+{
+  BaselineEstimator_t be;
+
+  baseline_reset (&be);
+  update_n (&be, 150, (BASELINE_WARMUP_SAMPLES));
+
+  update_n (&be, 200, (BASELINE_MAX_CONSECUTIVE_OUTLIERS)-1);
+  TEST_CHECK_EQ (baseline_value (&be), 150);
+  TEST_CHECK (baseline_is_settled (&be));
+
+  TEST_CHECK (baseline_update (&be, 200));
+  TEST_CHECK_EQ (baseline_value (&be), 200);
+  TEST_CHECK_EQ (be.sample_count, 1);
+  TEST_CHECK (!baseline_is_settled (&be));
+}
@@ -0,0 +1,180 @@
+/*
+ *  Timer/Counter1 input capture, driven through ICP1 on the simulator: the
+ *  timestamps extend across counter overflows, including a capture taken
+ *  while the overflow (compare match B, with OCR1B at 0) is still pending,
+ *  and a full queue drops new edges and marks the gap.
+ */
+#include "host_sim.h"
+#include "pwm/input_capture.h"
+#include "test.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+/* With no prescaling, 16 ticks a microsecond; the count wraps every 4096. */
+#define TICKS_PER_US ((F_CPU) / 1000000UL)
+#define WRAP_US (65536UL / (TICKS_PER_US))
+
+static uint64_t start_us = 0;
+
+static void start (void);
+static void rising_edge (void);
+static uint32_t ticks_now (void);
+static void test_overflow_counting (void);
+static void test_pending_overflow (void);
+static void test_queue_full (void);
+static void test_measure (void);
+
+void
+test_input_capture (void)
+{
+  const uint8_t sreg = SREG;
+
+  TEST_CHECK_EQ (icp_start (CS_PRESCALE_BY_32, ICP_RISING_EDGES, false), -1);
+  TEST_CHECK_EQ (icp_start (CS_NONE, ICP_RISING_EDGES, false), -1);
+
+  test_overflow_counting ();
+  test_pending_overflow ();
+  test_queue_full ();
+  test_measure ();
+
+  icp_stop ();
+  TEST_CHECK (PRR & (1 << (PRTIM1)));
+  SREG = sreg;
+}
+
+/* Starts capturing rising edges at a tick a cycle, interrupts on. */
+void
+start (void)
+{
+  host_sim_set_pin (HOST_PORT_B, 0, false);
+  TEST_CHECK_EQ (icp_start (CS_NO_PRESCALING, ICP_RISING_EDGES, false), 0);
+  TEST_CHECK_EQ (OCR1B, 0);
+  start_us = host_sim_now_us ();
+  sei ();
+}
+
+void
+rising_edge (void)
+{
+  host_sim_set_pin (HOST_PORT_B, 0, true);
+  host_sim_set_pin (HOST_PORT_B, 0, false);
+}
+
+/* @return the ticks a capture taken now should carry. */
+uint32_t
+ticks_now (void)
+{
+  return (uint32_t)((host_sim_now_us () - start_us) * (TICKS_PER_US));
+}
+
+void
+test_overflow_counting (void)
+{
+  ICPCapture_t c;
+
+  start ();
+  host_sim_advance_us (3 * (WRAP_US) + 100);
+  rising_edge ();
+
+  TEST_CHECK (icp_read_capture (&c));
+  TEST_CHECK_EQ (c.ticks, ticks_now ());
+  TEST_CHECK_EQ (c.ticks >> 16, 3);
+  TEST_CHECK_EQ (c.flags, ICP_RISING_EDGE);
+  TEST_CHECK (!icp_read_capture (&c));
+}
+
+/*
+ *  With interrupts off, the counter wraps and an edge is captured; both
+ *  flags are pending when they come back on, and the capture vector runs
+ *  first. Captured just after the wrap, the timestamp takes the overflow;
+ *  captured just before it, it doesn't.
+ */
+void
+test_pending_overflow (void)
+{
+  ICPCapture_t c;
+
+  start ();
+  cli ();
+  host_sim_advance_us ((WRAP_US) + 1);
+  TEST_CHECK (TIFR1 & (1 << (OCF1B)));
+  rising_edge ();
+  TEST_CHECK (TIFR1 & (1 << (ICF1)));
+  const uint32_t after_wrap = ticks_now ();
+  sei ();
+
+  TEST_CHECK (icp_read_capture (&c));
+  TEST_CHECK_EQ (c.ticks, after_wrap);
+  TEST_CHECK_EQ (c.ticks >> 16, 1);
+
+  host_sim_advance_us ((WRAP_US) - 2);
+  cli ();
+  rising_edge ();
+  const uint32_t before_wrap = ticks_now ();
+  host_sim_advance_us (2);
+  TEST_CHECK (TIFR1 & (1 << (OCF1B)));
+  sei ();
+
+  TEST_CHECK (icp_read_capture (&c));
+  TEST_CHECK_EQ (c.ticks, before_wrap);
+  TEST_CHECK_EQ (c.ticks >> 16, 1);
+}
+
+/* The queue keeps one slot free, so it holds `ICP_QUEUE_SIZE` - 1 edges. */
+void
+test_queue_full (void)
+{
+  ICPCapture_t c;
+  uint32_t first = 0;
+
+  start ();
+  for (uint8_t i = 0; i < (ICP_QUEUE_SIZE) + 3; i++)
+    {
+      host_sim_advance_us (10);
+      if (i == 0)
+        first = ticks_now ();
+      rising_edge ();
+    }
+  TEST_CHECK_EQ (icp_dropped_captures (), 4);
+
+  for (uint8_t i = 0; i < (ICP_QUEUE_SIZE)-1; i++)
+    {
+      TEST_CHECK (icp_read_capture (&c));
+      TEST_CHECK_EQ (c.ticks, first + i * 10UL * (TICKS_PER_US));
+      TEST_CHECK_EQ (c.flags, ICP_RISING_EDGE);
+    }
+  TEST_CHECK (!icp_read_capture (&c));
+
+  host_sim_advance_us (10);
+  rising_edge ();
+  TEST_CHECK (icp_read_capture (&c));
+  TEST_CHECK_EQ (c.ticks, ticks_now ());
+  TEST_CHECK_EQ (c.flags, ICP_RISING_EDGE | ICP_AFTER_GAP);
+}
+
+/* A 1 kHz pulse train, 25% high, with both edges captured. */
+void
+test_measure (void)
+{
+  ICPMeasurement_t m = { 0 };
+
+  host_sim_set_pin (HOST_PORT_B, 0, false);
+  TEST_CHECK_EQ (icp_start (CS_PRESCALE_BY_8, ICP_BOTH_EDGES, false), 0);
+  sei ();
+  TEST_CHECK_EQ (icp_measure (&m), -1);
+
+  for (uint8_t i = 0; i < 3; i++)
+    {
+      host_sim_set_pin (HOST_PORT_B, 0, true);
+      host_sim_advance_us (250);
+      host_sim_set_pin (HOST_PORT_B, 0, false);
+      host_sim_advance_us (750);
+    }
+
+  TEST_CHECK_EQ (icp_measure (&m), 0);
+  TEST_CHECK_EQ (m.period_ticks, 2000);
+  TEST_CHECK_EQ (m.high_ticks, 500);
+  TEST_CHECK_EQ (m.frequency_hz, 1000);
+  TEST_CHECK_EQ (m.duty_permille, 250);
+}
@@ -0,0 +1,78 @@
+/*
+ *  The lamp's settings loaded back from EEPROM: out of range values, as
+ *  another build or a corrupted write could leave, are held to the ranges
+ *  the lamp's commands allow.
+ */
+#include "config_store.h"
+#include "lamp.h"
+#include "scheduler.h"
+#include "test.h"
+
+#include <avr/pgmspace.h>
+#include <string.h>
+
+static char reported[64];
+
+static void capture (const char *str);
+static void store (const LampConfig_t *c);
+static void test_too_low (void);
+static void test_too_high (void);
+
+void
+test_lamp_config (void)
+{
+  sched_init ();
+  test_too_low ();
+  test_too_high ();
+}
+
+/* Appends to `reported`. */
+void
+capture (const char *str)
+{
+  strncat (reported, str, sizeof (reported) - strlen (reported) - 1);
+}
+
+/*
+ *  Saves `c` through the config store, as the lamp would. `cfg_load` adds a
+ *  task each time, so each case costs two of `SCHED_MAX_TASKS`.
+ */
+void
+store (const LampConfig_t *c)
+{
+  static const LampConfig_t UNUSED PROGMEM = { 0 };
+  static LampConfig_t settings;
+
+  cfg_load (&settings, sizeof (settings), (LAMP_CONFIG_VERSION), &UNUSED);
+  settings = *c;
+  cfg_mark_dirty ();
+  cfg_flush ();
+}
+
+void
+test_too_low (void)
+{
+  const LampConfig_t c = { 0, 0, 0 };
+
+  store (&c);
+  TEST_CHECK_EQ (l_load_config (), 0);
+  TEST_CHECK_EQ (l_baud_rate (), 9600);
+
+  reported[0] = '\0';
+  TEST_CHECK_EQ (l_command ('l', capture), 0);
+  TEST_CHECK_STR (reported, "lamp,250,16,9600\r\n");
+}
+
+void
+test_too_high (void)
+{
+  const LampConfig_t c = { 65535, 200, 19200 };
+
+  store (&c);
+  TEST_CHECK_EQ (l_load_config (), 0);
+  TEST_CHECK_EQ (l_baud_rate (), 19200);
+
+  reported[0] = '\0';
+  TEST_CHECK_EQ (l_command ('l', capture), 0);
+  TEST_CHECK_STR (reported, "lamp,60000,128,19200\r\n");
+}
@@ -0,0 +1,167 @@
+/*
+ *  Latency histograms: which bucket a duration lands in, and the
+ *  percentiles read back from them. Built with LATENCY_TRACKING.
+ */
+#include "latency.h"
+#include "test.h"
+
+#include <string.h>
+
+#if !LAT_ENABLED
+#error "the latency tests need LATENCY_TRACKING"
+#endif /* LAT_ENABLED */
+
+static char reported[160];
+
+static void capture (const char *str);
+static void test_empty (void);
+static void test_buckets (void);
+static void test_percentiles (void);
+static void test_saturation (void);
+static void test_report (void);
+static void test_report_all (void);
+
+void
+test_latency (void)
+{
+  test_empty ();
+  test_buckets ();
+  test_percentiles ();
+  test_saturation ();
+  test_report ();
+  test_report_all ();
+}
+
+/* Appends to `reported`. */
+void
+capture (const char *str)
+{
+  strncat (reported, str, sizeof (reported) - strlen (reported) - 1);
+}
+
+void
+test_empty (void)
+{
+  LatencyHistogram_t h = { 0 };
+
+  TEST_CHECK_EQ (lat_percentile (&h, 50), 0);
+  TEST_CHECK_EQ (lat_percentile (&h, 100), 0);
+}
+
+/* Bucket 0 holds zeros, bucket b [2^(b-1), 2^b), the last the rest. */
+void
+test_buckets (void)
+{
+  LatencyHistogram_t h = { 0 };
+
+  lat_record (&h, 0);
+  lat_record (&h, 1);
+  lat_record (&h, 2);
+  lat_record (&h, 3);
+  lat_record (&h, 4);
+  lat_record (&h, 1000);
+  lat_record (&h, UINT32_MAX);
+
+  TEST_CHECK_EQ (h.buckets[0], 1);
+  TEST_CHECK_EQ (h.buckets[1], 1);
+  TEST_CHECK_EQ (h.buckets[2], 2);
+  TEST_CHECK_EQ (h.buckets[3], 1);
+  TEST_CHECK_EQ (h.buckets[10], 1);
+  TEST_CHECK_EQ (h.buckets[(LAT_BUCKET_COUNT)-1], 1);
+  TEST_CHECK_EQ (h.count, 7);
+  TEST_CHECK_EQ (h.max_us, UINT32_MAX);
+
+  lat_reset (&h);
+  TEST_CHECK_EQ (h.count, 0);
+  TEST_CHECK_EQ (h.max_us, 0);
+  TEST_CHECK_EQ (h.buckets[2], 0);
+}
+
+void
+test_percentiles (void)
+{
+  LatencyHistogram_t h = { 0 };
+
+  /* 98 runs of 100 us and two of 5000 us. */
+  for (uint8_t i = 0; i < 98; i++)
+    lat_record (&h, 100);
+  lat_record (&h, 5000);
+  lat_record (&h, 5000);
+
+  /* The upper edge of 100's bucket, [64, 128). */
+  TEST_CHECK_EQ (lat_percentile (&h, 50), 127);
+  TEST_CHECK_EQ (lat_percentile (&h, 98), 127);
+  /* 5000's bucket is [4096, 8192), but nothing went above the maximum. */
+  TEST_CHECK_EQ (lat_percentile (&h, 99), 5000);
+  TEST_CHECK_EQ (lat_percentile (&h, 100), 5000);
+
+  /* The rank rounds up: p50 of three samples is the second. */
+  lat_reset (&h);
+  lat_record (&h, 0);
+  lat_record (&h, 10);
+  lat_record (&h, 1000);
+  TEST_CHECK_EQ (lat_percentile (&h, 1), 0);
+  TEST_CHECK_EQ (lat_percentile (&h, 50), 15);
+  TEST_CHECK_EQ (lat_percentile (&h, 67), 1000);
+}
+
+/* Counts stop at UINT16_MAX rather than wrapping to a tiny count. */
+void
+test_saturation (void)
+{
+  LatencyHistogram_t h = { 0 };
+
+  for (uint32_t i = 0; i < UINT16_MAX + 10UL; i++)
+    lat_record (&h, 3);
+
+  TEST_CHECK_EQ (h.count, UINT16_MAX);
+  TEST_CHECK_EQ (h.buckets[2], UINT16_MAX);
+  TEST_CHECK_EQ (lat_percentile (&h, 99), 3);
+}
+
+void
+test_report (void)
+{
+  LatencyHistogram_t h = { 0 };
+
+  for (uint8_t i = 0; i < 98; i++)
+    lat_record (&h, 100);
+  lat_record (&h, 5000);
+  lat_record (&h, 5000);
+
+  reported[0] = '\0';
+  lat_report (&h, "sample_jitter", capture);
+  TEST_CHECK_STR (reported, "lat,sample_jitter,100,127,5000,5000\r\n");
+}
+
+/* Every histogram added is printed in turn, then emptied. */
+void
+test_report_all (void)
+{
+  static LatencyHistogram_t jitter = { 0 };
+  static LatencyHistogram_t run_time = { 0 };
+  static LatencyHistogram_t spare = { 0 };
+
+  TEST_CHECK_EQ (lat_add_to_report (&jitter, "sample_jitter"), 0);
+  TEST_CHECK_EQ (lat_add_to_report (&run_time, "sample_run"), 0);
+
+  lat_record (&jitter, 3);
+  lat_record (&run_time, 100);
+  lat_record (&run_time, 200);
+
+  reported[0] = '\0';
+  lat_report_all (capture);
+  TEST_CHECK_STR (reported, "lat,sample_jitter,1,3,3,3\r\n"
+                            "lat,sample_run,2,127,200,200\r\n");
+  TEST_CHECK_EQ (jitter.count, 0);
+  TEST_CHECK_EQ (run_time.max_us, 0);
+
+  reported[0] = '\0';
+  lat_report_all (capture);
+  TEST_CHECK_STR (reported, "lat,sample_jitter,0,0,0,0\r\n"
+                            "lat,sample_run,0,0,0,0\r\n");
+
+  for (uint8_t i = 2; i < (LAT_MAX_REPORTED); i++)
+    TEST_CHECK_EQ (lat_add_to_report (&spare, "spare"), 0);
+  TEST_CHECK_EQ (lat_add_to_report (&spare, "spare"), -1);
+}
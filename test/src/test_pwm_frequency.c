@@ -0,0 +1,139 @@
+/*
+ *  The lamp's PWM frequency solver: the configurations it picks, and that
+ *  targets up to `PWM_MAX_HZ` solve without the arithmetic overflowing.
+ */
+#include "pwm/pwm_frequency.h"
+#include "test.h"
+
+#include <stddef.h>
+
+static uint32_t achieved_hz (TimerCounterSelect_t timer,
+                             const PWMSolution_t *s);
+static void test_rejects (void);
+static void test_fixed_top (void);
+static void test_ocra_top (void);
+static void test_sweep (TimerCounterSelect_t timer);
+
+void
+test_pwm_frequency (void)
+{
+  test_rejects ();
+  test_fixed_top ();
+  test_ocra_top ();
+  test_sweep (TCNTRS_0);
+  test_sweep (TCNTRS_1);
+  test_sweep (TCNTRS_2);
+}
+
+/* @return the frequency of `s`, from pp. 79-81 of the data sheet. */
+uint32_t
+achieved_hz (TimerCounterSelect_t timer, const PWMSolution_t *s)
+{
+  const uint32_t divisor = PWM_CLK_DIVISOR (s->prescale);
+  const bool phase_correct
+      = s->waveform_gen_mode == WGM_MODE_1
+        || (timer == TCNTRS_1 ? s->waveform_gen_mode == WGM_MODE_3
+                              : s->waveform_gen_mode == WGM_MODE_5);
+
+  if (phase_correct)
+    return (F_CPU) / (2 * divisor * s->top);
+  return (F_CPU) / (divisor * (s->top + 1UL));
+}
+
+void
+test_rejects (void)
+{
+  PWMSolution_t s;
+
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_0, 199, 1, false, &s), -1);
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_0, (PWM_MAX_HZ) + 1, 1, false, &s),
+                 -1);
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_2, UINT32_MAX, 1, false, &s), -1);
+  /* Only Timer/Counter1 has more than 8 bits. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_2, 1000, 9, false, &s), -1);
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_0, 1000, 1, false, NULL), -1);
+}
+
+void
+test_fixed_top (void)
+{
+  PWMSolution_t s;
+
+  /* Fast PWM at /64 is 976 Hz; Timer/Counter0 has no /32. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_0, 977, 8, true, &s), 0);
+  TEST_CHECK_EQ (s.waveform_gen_mode, WGM_MODE_3);
+  TEST_CHECK_EQ (s.prescale, CS_PRESCALE_BY_64);
+  TEST_CHECK_EQ (s.top, 0xFF);
+  TEST_CHECK (!s.top_is_ocra);
+  TEST_CHECK_EQ (s.frequency_hz, 976);
+  TEST_CHECK_EQ (s.resolution_bits, 8);
+
+  /* Timer/Counter2 does, for 1953 Hz. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_2, 1953, 8, true, &s), 0);
+  TEST_CHECK_EQ (s.waveform_gen_mode, WGM_MODE_3);
+  TEST_CHECK_EQ (s.prescale, CS_PRESCALE_BY_32);
+  TEST_CHECK_EQ (s.frequency_hz, 1953);
+
+  /* Timer/Counter1's 10-bit fast PWM, unprescaled. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_1, 15625, 10, true, &s), 0);
+  TEST_CHECK_EQ (s.waveform_gen_mode, WGM_MODE_7);
+  TEST_CHECK_EQ (s.prescale, CS_NO_PRESCALING);
+  TEST_CHECK_EQ (s.top, 0x3FF);
+  TEST_CHECK_EQ (s.frequency_hz, 15625);
+  TEST_CHECK_EQ (s.resolution_bits, 10);
+}
+
+void
+test_ocra_top (void)
+{
+  PWMSolution_t s;
+
+  /* The fastest there is: TOP = 1, unprescaled. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_0, (PWM_MAX_HZ), 1, false, &s), 0);
+  TEST_CHECK_EQ (s.waveform_gen_mode, WGM_MODE_7);
+  TEST_CHECK_EQ (s.prescale, CS_NO_PRESCALING);
+  TEST_CHECK_EQ (s.top, 1);
+  TEST_CHECK (s.top_is_ocra);
+  TEST_CHECK_EQ (s.frequency_hz, (PWM_MAX_HZ));
+
+  /*
+   *  40 kHz is exact in fast PWM at /8 with TOP 49, and in phase correct
+   *  PWM unprescaled with TOP 200; the tie goes to the finer resolution.
+   */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_2, 40000, 1, false, &s), 0);
+  TEST_CHECK_EQ (s.prescale, CS_NO_PRESCALING);
+  TEST_CHECK_EQ (s.waveform_gen_mode, WGM_MODE_5);
+  TEST_CHECK_EQ (s.top, 200);
+  TEST_CHECK_EQ (s.frequency_hz, 40000);
+  TEST_CHECK_EQ (s.resolution_bits, 7);
+
+  /* Timer/Counter1 has no OCR1A-as-TOP candidates. */
+  TEST_CHECK_EQ (pwm_solve_for (TCNTRS_1, 40000, 1, false, &s), 0);
+  TEST_CHECK (!s.top_is_ocra);
+}
+
+/*
+ *  Every target from the flicker threshold up to `PWM_MAX_HZ` solves, to
+ *  a configuration which really runs at the frequency reported. Where TOP
+ *  can be set in OCRnA, it's within a quarter of the target (the step
+ *  between TOPs 1 and 2).
+ */
+void
+test_sweep (TimerCounterSelect_t timer)
+{
+  PWMSolution_t s;
+  uint32_t target = (PWM_FLICKER_FUSION_HZ);
+
+  while (target <= (PWM_MAX_HZ))
+    {
+      TEST_CHECK_EQ (pwm_solve_for (timer, target, 1, false, &s), 0);
+      TEST_CHECK_EQ (s.frequency_hz, achieved_hz (timer, &s));
+
+      const uint32_t error = s.frequency_hz > target
+                                 ? s.frequency_hz - target
+                                 : target - s.frequency_hz;
+      TEST_CHECK (timer == TCNTRS_1 || error <= target / 4);
+
+      target += target / 16 + 1;
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ *  The lamp's PWM HAL: build-time configurations and `pwm_init` write the
+ *  same control registers through the same path, and out of range
+ *  arguments are rejected rather than half applied.
+ */
+#include "host_sim.h"
+#include "metrics.h"
+#include "pwm/pwm_hal.h"
+#include "test.h"
+#include "uart_hal.h"
+
+#include <avr/io.h>
+#include <stddef.h>
+
+PWM_DEFINE_CONFIG (FAST_PWM_CONFIG, TCNTRS_2, WGM_MODE_3, COM_CLEAR, false,
+                   false, CS_PRESCALE_BY_64);
+
+static void discard (uint8_t byte);
+static void test_apply_config (void);
+static void test_init_matches_config (void);
+static void test_rejects (void);
+
+void
+test_pwm_hal (void)
+{
+  test_apply_config ();
+  test_init_matches_config ();
+
+  /* The rejections are reported over the UART in debug builds. */
+  host_sim_set_uart_sink (discard);
+  uart_wake ();
+  test_rejects ();
+  uart_shutdown ();
+  host_sim_set_uart_sink (NULL);
+
+  pwm_power_down (TCNTRS_2);
+}
+
+void
+discard (uint8_t byte)
+{
+  (void)byte;
+}
+
+void
+test_apply_config (void)
+{
+  const uint32_t reconfigs = metrics_get (METRIC_pwm_reconfigs);
+
+  TCCR2A = 0;
+  TCCR2B = 0;
+  pwm_apply_config (&FAST_PWM_CONFIG);
+  TEST_CHECK_EQ (TCCR2A, FAST_PWM_CONFIG.control_register_a);
+  TEST_CHECK_EQ (TCCR2B, FAST_PWM_CONFIG.control_register_b);
+  TEST_CHECK_EQ (metrics_get (METRIC_pwm_reconfigs), reconfigs + 1);
+}
+
+void
+test_init_matches_config (void)
+{
+  TCCR2A = 0;
+  TCCR2B = 0;
+  TEST_CHECK_EQ (pwm_init (TCNTRS_2, WGM_MODE_3, COM_CLEAR, false, false,
+                           CS_PRESCALE_BY_64),
+                 0);
+  TEST_CHECK_EQ (TCCR2A, FAST_PWM_CONFIG.control_register_a);
+  TEST_CHECK_EQ (TCCR2B, FAST_PWM_CONFIG.control_register_b);
+}
+
+/* Each leaves Timer/Counter2's registers as `FAST_PWM_CONFIG` set them. */
+void
+test_rejects (void)
+{
+  const uint32_t reconfigs = metrics_get (METRIC_pwm_reconfigs);
+
+  TEST_CHECK_EQ (pwm_init ((TimerCounterSelect_t)3, WGM_MODE_3, COM_CLEAR,
+                           false, false, CS_PRESCALE_BY_64),
+                 -1);
+  TEST_CHECK_EQ (pwm_init (TCNTRS_2, (WaveformGenerationMode_t)4, COM_CLEAR,
+                           false, false, CS_PRESCALE_BY_64),
+                 -1);
+  TEST_CHECK_EQ (pwm_init (TCNTRS_2, WGM_MODE_3, (CompareOutputMode_t)4,
+                           false, false, CS_PRESCALE_BY_64),
+                 -1);
+  TEST_CHECK_EQ (pwm_init (TCNTRS_2, WGM_MODE_3, COM_CLEAR, true, false,
+                           CS_PRESCALE_BY_64),
+                 -1);
+  TEST_CHECK_EQ (pwm_init (TCNTRS_2, WGM_MODE_3, COM_CLEAR, false, false,
+                           CS_EXT_RISING_EDGE),
+                 -1);
+  TEST_CHECK_EQ (pwm_init (TCNTRS_0, WGM_MODE_3, COM_CLEAR, false, false,
+                           CS_PRESCALE_BY_32),
+                 -1);
+  TEST_CHECK_EQ (pwm_set_prescaler (TCNTRS_2, CS_EXT_FALLING_EDGE), -1);
+  TEST_CHECK_EQ (pwm_set_prescaler ((TimerCounterSelect_t)3, CS_NONE), -1);
+
+  TEST_CHECK_EQ (TCCR2A, FAST_PWM_CONFIG.control_register_a);
+  TEST_CHECK_EQ (TCCR2B, FAST_PWM_CONFIG.control_register_b);
+  TEST_CHECK_EQ (metrics_get (METRIC_pwm_reconfigs), reconfigs);
+}
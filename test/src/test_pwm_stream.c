@@ -0,0 +1,115 @@
+/*
+ *  PWM DAC streaming: samples reach OCR1A in order across the swap between
+ *  the two buffers, running out only counts as an underrun without
+ *  `PWM_STREAM_END`, and stopping hands Timer/Counter1 back.
+ *
+ *  The overflow vector is called directly, one carrier period at a time,
+ *  rather than waiting on the simulated clock.
+ */
+#include "pwm/pwm_stream.h"
+#include "test.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+static const uint8_t FIRST[] = { 1, 2 };
+static const uint8_t SECOND[] = { 3, 4, 5 };
+
+void TIMER1_OVF_vect (void);
+
+static void play (const uint8_t *expected, uint8_t count);
+static void test_double_buffer (void);
+static void test_underrun (void);
+static void test_loop (void);
+static void test_stop (void);
+
+void
+test_pwm_stream (void)
+{
+  /* A sample per carrier period, so each overflow outputs one. */
+  TEST_CHECK_EQ (pwm_stream_init (PWM_STREAM_CARRIER_HZ),
+                 PWM_STREAM_CARRIER_HZ);
+
+  test_double_buffer ();
+  test_underrun ();
+  test_loop ();
+  test_stop ();
+}
+
+/* Steps `count` overflows, checking the sample each one outputs. */
+void
+play (const uint8_t *expected, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+    {
+      TEST_CHECK (TIMSK1 & (1 << (TOIE1)));
+      TIMER1_OVF_vect ();
+      TEST_CHECK_EQ (OCR1A, expected[i]);
+    }
+}
+
+void
+test_double_buffer (void)
+{
+  const uint8_t expected[] = { 1, 2, 3, 4, 5 };
+  const uint16_t underruns = pwm_stream_underruns ();
+
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), 0), 0);
+  TEST_CHECK_EQ (pwm_stream_queue (SECOND, sizeof (SECOND), PWM_STREAM_END),
+                 0);
+  TEST_CHECK (!pwm_stream_can_queue ());
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), 0), -1);
+
+  play (expected, 2);
+  /* The first buffer is done with, so its slot is free again. */
+  TEST_CHECK (pwm_stream_can_queue ());
+  play (&expected[2], 3);
+
+  TEST_CHECK (pwm_stream_is_idle ());
+  TEST_CHECK (!(TIMSK1 & (1 << (TOIE1))));
+  TEST_CHECK_EQ (pwm_stream_underruns (), underruns);
+}
+
+void
+test_underrun (void)
+{
+  const uint16_t underruns = pwm_stream_underruns ();
+
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), 0), 0);
+  play (FIRST, sizeof (FIRST));
+
+  TEST_CHECK (pwm_stream_is_idle ());
+  TEST_CHECK (!(TIMSK1 & (1 << (TOIE1))));
+  TEST_CHECK_EQ (pwm_stream_underruns (), underruns + 1);
+}
+
+/* A looping buffer repeats until another is queued, then ends its pass. */
+void
+test_loop (void)
+{
+  const uint8_t expected[] = { 1, 2, 1, 2, 1, 2, 3, 4, 5 };
+
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), PWM_STREAM_LOOP),
+                 0);
+  play (expected, 5);
+  TEST_CHECK_EQ (pwm_stream_queue (SECOND, sizeof (SECOND), PWM_STREAM_END),
+                 0);
+  play (&expected[5], 4);
+
+  TEST_CHECK (pwm_stream_is_idle ());
+}
+
+void
+test_stop (void)
+{
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), 0), 0);
+  pwm_stream_stop ();
+
+  TEST_CHECK (pwm_stream_is_idle ());
+  TEST_CHECK (!(TIMSK1 & (1 << (TOIE1))));
+  TEST_CHECK_EQ (OCR1A, 0x80);
+  TEST_CHECK_EQ (TCCR1B & 0x07, 0);
+  TEST_CHECK (PRR & (1 << (PRTIM1)));
+  TEST_CHECK (!(DDRB & (1 << (DDB1))));
+  TEST_CHECK_EQ (pwm_stream_queue (FIRST, sizeof (FIRST), 0), -1);
+}
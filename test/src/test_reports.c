@@ -0,0 +1,68 @@
+/*
+ *  The lines the projects print: the lamp's report after each colour cycle
+ *  and the Love-o-Meter's line per sample.
+ */
+#include "lamp.h"
+#include "love_o_meter.h"
+#include "test.h"
+
+#include <string.h>
+
+static void test_lamp_report (void);
+static void test_love_o_meter_report (void);
+
+void
+test_reports (void)
+{
+  test_lamp_report ();
+  test_love_o_meter_report ();
+}
+
+void
+test_lamp_report (void)
+{
+  char buffer[256];
+  const ADCSample_t red = { .value = 1023, .timestamp_us = 4000000 };
+  const ADCSample_t green = { .value = 153, .timestamp_us = 4000112 };
+  const ADCSample_t blue = { .value = 3, .timestamp_us = 4294967295UL };
+  const char *expected
+      = "Raw sensor values - red: 1023 green: 153 blue: 3\r\n"
+        "Sample times (us) - red: 4000000 green: 4000112 blue: 4294967295\r\n"
+        "Mapped sensor values - red: 255 green: 38 blue: 0\r\n";
+
+  const int length
+      = l_format_report (buffer, sizeof (buffer), &red, &green, &blue);
+  TEST_CHECK_STR (buffer, expected);
+  TEST_CHECK_EQ (length, strlen (expected));
+
+  /* Cut short, but still terminated, in a buffer too small for it. */
+  char small[16];
+  TEST_CHECK_EQ (l_format_report (small, sizeof (small), &red, &green, &blue),
+                 strlen (expected));
+  TEST_CHECK_STR (small, "Raw sensor valu");
+}
+
+void
+test_love_o_meter_report (void)
+{
+  char buffer[(LOVE_O_METER_REPORT_SIZE)];
+  const ADCSample_t sample = { .value = 153, .timestamp_us = 4000000 };
+
+  love_o_meter_format_report (buffer, sizeof (buffer), &sample, 150);
+  TEST_CHECK_STR (buffer, "Time (us): 4000000 Sensor value: 153 "
+                          "Voltage: 0.74 Temperature (C): 24 "
+                          "Temperature (F): 76 Baseline (C): 23\r\n");
+
+  /* Below 0.5 V the temperature goes negative. */
+  const ADCSample_t cold = { .value = 92, .timestamp_us = 1000 };
+  love_o_meter_format_report (buffer, sizeof (buffer), &cold, 92);
+  TEST_CHECK_STR (buffer, "Time (us): 1000 Sensor value: 92 "
+                          "Voltage: 0.44 Temperature (C): -5 "
+                          "Temperature (F): 22 Baseline (C): -5\r\n");
+
+  /* The longest line there can be still fits the buffer size given. */
+  const ADCSample_t widest = { .value = 1023, .timestamp_us = UINT32_MAX };
+  TEST_CHECK (love_o_meter_format_report (buffer, sizeof (buffer), &widest,
+                                          0)
+              < (LOVE_O_METER_REPORT_SIZE));
+}
@@ -0,0 +1,110 @@
+/*
+ *  The UART receive ring: bytes come out in order across the wrap, and a
+ *  full ring drops new bytes, counting them as overruns, rather than
+ *  overwriting ones yet to be read.
+ */
+#include "host_sim.h"
+#include "metrics.h"
+#include "test.h"
+#include "uart_hal.h"
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <stddef.h>
+
+/* Matches uart_hal.c's RX_BUFFER_SIZE. */
+#define RX_RING_SIZE (128)
+
+static void discard (uint8_t byte);
+static void receive_run (uint8_t first, uint16_t count);
+static void check_read_run (uint8_t first, uint16_t count);
+static void test_wrap (void);
+static void test_drop_on_full (void);
+static void test_hardware_overrun (void);
+
+void
+test_uart_hal (void)
+{
+  host_sim_set_uart_sink (discard);
+  uart_init (9600, false);
+  sei ();
+
+  test_wrap ();
+  test_drop_on_full ();
+  test_hardware_overrun ();
+
+  uart_shutdown ();
+  host_sim_set_uart_sink (NULL);
+}
+
+void
+discard (uint8_t byte)
+{
+  (void)byte;
+}
+
+/* Receives `count` bytes counting up (mod 256) from `first`. */
+void
+receive_run (uint8_t first, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; i++)
+    host_sim_uart_receive ((uint8_t)(first + i));
+}
+
+void
+check_read_run (uint8_t first, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; i++)
+    TEST_CHECK_EQ (uart_read (), (uint8_t)(first + i));
+}
+
+/* The second run starts 100 bytes in, so it wraps past the end. */
+void
+test_wrap (void)
+{
+  receive_run (0, 100);
+  TEST_CHECK_EQ (uart_read_count (), 100);
+  check_read_run (0, 100);
+  TEST_CHECK_EQ (uart_read_count (), 0);
+
+  receive_run (100, 100);
+  TEST_CHECK_EQ (uart_read_count (), 100);
+  check_read_run (100, 100);
+  TEST_CHECK_EQ (uart_read_count (), 0);
+}
+
+void
+test_drop_on_full (void)
+{
+  metrics_reset ();
+
+  receive_run (0, (RX_RING_SIZE) + 3);
+  TEST_CHECK_EQ (uart_read_count (), (RX_RING_SIZE));
+  TEST_CHECK_EQ (metrics_get (METRIC_uart_rx_bytes), (RX_RING_SIZE) + 3);
+  TEST_CHECK_EQ (metrics_get (METRIC_uart_rx_overruns), 3);
+
+  /* The oldest bytes survive; the three late ones are gone. */
+  check_read_run (0, (RX_RING_SIZE));
+  TEST_CHECK_EQ (uart_read_count (), 0);
+
+  /* Reading made room again. */
+  receive_run (42, 1);
+  TEST_CHECK_EQ (uart_read_count (), 1);
+  check_read_run (42, 1);
+  TEST_CHECK_EQ (metrics_get (METRIC_uart_rx_overruns), 3);
+}
+
+/* A byte the hardware flags as overrun (DOR0) is kept, but counted. */
+void
+test_hardware_overrun (void)
+{
+  metrics_reset ();
+
+  UCSR0A |= 1 << (DOR0);
+  host_sim_uart_receive (7);
+  UCSR0A &= ~(1 << (DOR0));
+
+  TEST_CHECK_EQ (metrics_get (METRIC_uart_rx_overruns), 1);
+  TEST_CHECK_EQ (uart_read_count (), 1);
+  check_read_run (7, 1);
+}